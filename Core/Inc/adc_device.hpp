@@ -0,0 +1,123 @@
+/*
+ * adc_device.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef INC_ADC_DEVICE_HPP_
+#define INC_ADC_DEVICE_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+enum class AdcCodingTypeDef : uint8_t {
+	kTwosComplement,
+	kOffsetBinary		// 0 = -full scale; the MSB is flipped on decode
+};
+
+// Frame layout of one conversion as the ADC shifts it out, MSB first. The data field is
+// ceil(Resolution / 8) bytes at DataOffset with the code left-justified in it; status and CRC
+// bytes are wherever the part puts them and are not part of the sample.
+// The frame is clocked as kWordCount SPI words of kWordBits (the widest size from 16 down to 4
+// bits that divides it, e.g. 12 x 2 for 3 bytes, 16 x 2 for 4), so the F7 SPI moves one FIFO
+// entry per word instead of per byte. Words above 8 bits land in the receive buffer as
+// halfwords, kBufferSize bytes per frame.
+// Decode() returns the code as `Resolution`-bit two's complement, zero-extended to 32 bits,
+// which is what the RADC output and RiceCodec expect. Everything is a compile-time constant,
+// so each device gets its own straight-line kernel with no branches on the layout.
+template <size_t Resolution, size_t DataOffset, size_t FrameSize, AdcCodingTypeDef Coding,
+	size_t StatusOffset = FrameSize, bool HasCrc = false>
+class AdcDevice {
+public:
+	static constexpr size_t kResolution = Resolution;
+	static constexpr size_t kFrameSize = FrameSize;
+	static constexpr size_t kDataOffset = DataOffset;
+	static constexpr size_t kDataBytes = (Resolution + 7) / 8;
+	static constexpr bool kHasStatus = StatusOffset < FrameSize;
+	static constexpr bool kHasCrc = HasCrc;		// always the last byte
+
+	static constexpr size_t kWordBits = [] {
+		size_t bits = 16;
+		while((FrameSize * 8) % bits != 0) --bits;
+		return bits;
+	}();
+	static constexpr size_t kWordCount = FrameSize * 8 / kWordBits;
+	static constexpr size_t kBufferSize = kWordCount * ((kWordBits > 8) ? 2 : 1);
+
+private:
+	// The whole frame is gathered into one register, then the data field is cut out of it
+	using RawType = std::conditional_t<(FrameSize > 4), uint64_t, uint32_t>;
+	static constexpr size_t kFieldShift = (FrameSize - DataOffset - kDataBytes) * 8;
+	static constexpr size_t kShift = kDataBytes * 8 - Resolution;
+	static constexpr uint32_t kMask = (Resolution >= 32) ? 0xFFFF'FFFF : ((1u << Resolution) - 1);
+	static constexpr uint32_t kFlip = (Coding == AdcCodingTypeDef::kOffsetBinary) ? (1u << (Resolution - 1)) : 0;
+
+	static_assert(Resolution >= 8 && Resolution <= 32);
+	static_assert(FrameSize <= 8 && kWordBits >= 4);
+	static_assert(DataOffset + kDataBytes <= FrameSize - (HasCrc ? 1 : 0));
+	static_assert(!kHasStatus || StatusOffset < DataOffset || StatusOffset >= DataOffset + kDataBytes);
+
+public:
+	AdcDevice() = delete;
+
+	// One frame as it sits in the receive buffer (kBufferSize bytes)
+	static RawType Gather(const uint8_t* buffer)
+	{
+		RawType raw = 0;
+		for(size_t i = 0; i < kWordCount; ++i)
+		{
+			if constexpr (kWordBits > 8) {
+				uint16_t word;
+				std::memcpy(&word, buffer + 2 * i, sizeof(word));
+				raw = (raw << kWordBits) | word;
+			}
+			else {
+				raw = (raw << kWordBits) | buffer[i];
+			}
+		}
+		return raw;
+	}
+	static uint32_t Decode(const uint8_t* buffer)
+	{
+		const auto field = static_cast<uint32_t>(Gather(buffer) >> kFieldShift);
+		return ((field >> kShift) & kMask) ^ kFlip;
+	}
+	// Inverse of Decode(), for replaying and simulating captures; status and CRC bytes are zero
+	static void Encode(uint32_t code, uint8_t* buffer)
+	{
+		const RawType raw = static_cast<RawType>(((code & kMask) ^ kFlip) << kShift) << kFieldShift;
+		for(size_t i = 0; i < kWordCount; ++i)
+		{
+			constexpr RawType kWordMask = (RawType{1} << kWordBits) - 1;
+			const auto word = static_cast<uint16_t>((raw >> (kWordBits * (kWordCount - 1 - i))) & kWordMask);
+			if constexpr (kWordBits > 8) std::memcpy(buffer + 2 * i, &word, sizeof(word));
+			else buffer[i] = static_cast<uint8_t>(word);
+		}
+	}
+	static uint8_t Status(const uint8_t* buffer)
+	{
+		if constexpr (kHasStatus) return static_cast<uint8_t>(Gather(buffer) >> ((FrameSize - 1 - StatusOffset) * 8));
+		else return 0;
+	}
+};
+
+namespace adc_devices {
+
+	using Adc16				= AdcDevice<16, 0, 2, AdcCodingTypeDef::kTwosComplement>;
+	using Adc18				= AdcDevice<18, 0, 3, AdcCodingTypeDef::kTwosComplement>;
+	using Adc20				= AdcDevice<20, 0, 3, AdcCodingTypeDef::kOffsetBinary>;
+	using Adc24				= AdcDevice<24, 0, 3, AdcCodingTypeDef::kTwosComplement>;
+	using Adc24Status		= AdcDevice<24, 0, 4, AdcCodingTypeDef::kTwosComplement, 3>;			// data, status
+	using Adc24StatusCrc	= AdcDevice<24, 1, 5, AdcCodingTypeDef::kTwosComplement, 0, true>;		// status, data, CRC-8
+	using Adc32				= AdcDevice<32, 0, 4, AdcCodingTypeDef::kTwosComplement>;
+
+}
+
+// The part on the board. Frame size, resolution and the decode kernel of the acquisition
+// path all follow from it (see adc_constants).
+using AdcProfile = adc_devices::Adc24;
+
+
+#endif /* INC_ADC_DEVICE_HPP_ */
@@ -9,38 +9,217 @@
 
 #include <spi_driver.hpp>
 #include <uart_driver.hpp>
+#include <spsc_queue.hpp>
+#include <arena.hpp>
+#include <format.hpp>
+#include <rice_codec.hpp>
+#include <sample_pipeline.hpp>
+#include <profile_store.hpp>
+#include <kernel.hpp>
 #include <string>
+#include <string_view>
+#include <memory_resource>
+#include <vector>
+#include <span>
 #include <array>
+#include <atomic>
+#include <optional>
 
 namespace app_constants {
 	constexpr size_t kMax = 4096;
+	constexpr size_t kMaxStream = 0xFFFF'FFFF;		// samples of one streamed RADC (task build), as counted
+
+	// Commands that change the bus, the conversion clock or the framing of the output. In the task
+	// build they wait until a running RADC has been captured and written.
+	constexpr std::array<std::string_view, 11> kExclusive = {
+		"SCLK", "SWEEP", "IRQTEST", "RXBENCH", "CAL", "SCAN", "RXONLY", "RATE", "PSAVE", "PBOOT", "CRC"
+	};
+}
+
+// Task build (define USE_TASK_KERNEL): stacks in words, including room for nested interrupts.
+// Commands rank above output so a reply goes out between two lines of a long record.
+namespace task_constants {
+	constexpr uint8_t kAcquisitionPriority = 3;
+	constexpr uint8_t kCommandPriority = 2;
+	constexpr uint8_t kOutputPriority = 1;
+	constexpr size_t kAcquisitionStack = 1024;
+	constexpr size_t kOutputStack = 1024;
+	constexpr size_t kCommandStack = 4096;
+	constexpr size_t kCaptureQueueDepth = 2;
 }
 
+// Where RADC is, for STATUS
+enum class CaptureStateTypeDef : uint8_t {
+	kIdle,
+	kRun,		// capturing (and writing, in the task build)
+	kOutput		// captured, the rest of the record still being written
+};
+
+// Acquisition health of one RADC, counted in the data-ready interrupt. Every lost conversion
+// shows up in busy, spi_errors or overruns.
+struct AcquisitionStatisticsTypeDef {
+	std::atomic<uint32_t> edges{0};			// data-ready edges while capturing
+	std::atomic<uint32_t> samples{0};		// samples stored in the record
+	std::atomic<uint32_t> busy{0};			// edges skipped, the previous read was still queued or on the bus
+	std::atomic<uint32_t> spi_errors{0};	// scans that failed on the bus
+	std::atomic<uint32_t> overruns{0};		// scans lost for lack of a free receive bank or record space
+};
+
+// What RADC stores: raw codes, offset/gain corrected codes, or corrected microvolts
+enum class CalibrationModeTypeDef {
+	kOff,
+	kOn,
+	kMicrovolt
+};
+
 class Application {
 private:
 	// TypeDef
-	using Tokens	= std::vector<std::string>;
-	using Command	= std::string;
-	using Args		= std::vector<std::string>;
+	using Tokens	= std::pmr::vector<std::string_view>;
+	using Command	= std::string_view;
+	using Args		= std::span<const std::string_view>;
+
+	// Per-command allocations, released after each command
+	ArenaResource arena_;
 
 	// SPI Driver
 	SPIDriver spi_driver_;
 
 	// ADC record
-	std::array<uint8_t, 3> buffer_;
-	std::array<uint32_t, app_constants::kMax> record_;
+	SPSCQueue<uint32_t, app_constants::kMax> record_;
 	size_t record_length_;
+	size_t channel_count_{1};
+
+	// Health of the current (or last) RADC; scans already decoded, interrupt context only
+	AcquisitionStatisticsTypeDef acquisition_;
+	size_t decoded_count_{0};
+	std::atomic<bool> is_armed_{false};		// data-ready edges are ignored unless set
+
+	// Offset/gain of every ADC (CS index), and the terms applied per scan position while capturing
+	std::array<CalibrationTypeDef, spi_constants::kMaxPin> calibration_;
+	CalibrationModeTypeDef calibration_mode_{CalibrationModeTypeDef::kOff};
+	std::array<Calibration::TermTypeDef, spi_constants::kMaxPin> terms_;
+	size_t term_count_{0};
+
+	// Output format of RREG/RADC
+	FormatTypeDef format_{FormatTypeDef::kBin};
+	uint32_t vref_uv_;
+
+	// RADC compression (delta order, disabled if not set)
+	bool is_compressed_{false};
+	uint8_t compression_order_{1};
+	std::array<uint32_t, rice_constants::kBlockSamples> block_;
+	std::array<uint8_t, rice_constants::kMaxBlockSize> encoded_;
+
+	// IRQ self-test
+	std::atomic<bool> is_irq_test_{false};
+
+	// ADC reads without TX traffic (ReadIT in 2-line receive-only) instead of zeros through ReadWriteIT
+	bool is_rx_only_{false};
+
+	// Command latency stamps after every reply
+	bool is_latency_{false};
+
+	// Progress of RADC, and STOP
+	std::atomic<CaptureStateTypeDef> capture_state_{CaptureStateTypeDef::kIdle};
+	std::atomic<size_t> written_count_{0};
+	std::atomic<bool> is_stop_requested_{false};
+
+	// SPI bus, conversion clock and record: held by the acquisition task from the start of a
+	// capture until it has been written, and by the commands of kExclusive
+	Mutex bus_;
+
+#if defined(USE_TASK_KERNEL)
+	// Task build: the command task hands RADC to the acquisition task, which captures into the
+	// record while the output task writes it out; the command task keeps reading lines meanwhile.
+	struct CaptureRequestTypeDef {
+		size_t length;
+	};
+	// Output settings as they were when the capture started
+	struct CaptureTypeDef {
+		size_t count;
+		size_t channel_count;
+		FormatTypeDef format;
+		uint32_t vref_uv;
+		bool is_compressed;
+		uint8_t order;
+	};
+	Queue<CaptureRequestTypeDef, task_constants::kCaptureQueueDepth> capture_queue_;
+	Queue<CaptureTypeDef, 1> output_queue_;
+
+	alignas(8) std::array<uint32_t, task_constants::kAcquisitionStack> acquisition_stack_;
+	alignas(8) std::array<uint32_t, task_constants::kOutputStack> output_stack_;
+	alignas(8) std::array<uint32_t, task_constants::kCommandStack> command_stack_;
+	Task acquisition_task_{"ACQUISITION", task_constants::kAcquisitionPriority, acquisition_stack_, AcquisitionTask, this};
+	Task output_task_{"OUTPUT", task_constants::kOutputPriority, output_stack_, OutputTask, this};
+	Task command_task_{"COMMAND", task_constants::kCommandPriority, command_stack_, CommandTask, this};
+
+	static void AcquisitionTask(void*);
+	static void OutputTask(void*);
+	static void CommandTask(void*);
+	void Capture(const CaptureRequestTypeDef&);
+	void WriteCapture(const CaptureTypeDef&);
+#endif
+
+	// Acquisition (data-ready edge or conversion timer, interrupt context)
+	void OnDataReady();
+	void StopAcquisition();
+	bool StartAcquisition(size_t, bool);
+	bool Acquire(size_t, bool);
+	void PrepareRead();
+	void StartRead();
+	SPIDriver::InterruptStatusTypeDef GetReadState() const;
+
+	// Calibration
+	static size_t GetScanDevice(size_t);
+	bool PrepareCalibration();
+	bool MeasureMean(size_t, std::span<int32_t>);
+
+	// Register Access
+	HAL_StatusTypeDef WriteRegister(uint8_t, uint32_t);
+	HAL_StatusTypeDef ReadRegister(uint8_t, uint32_t&);
+	HAL_StatusTypeDef WriteRegisters(std::span<const uint32_t>);
+
+	// Output
+	size_t FormatRegister(std::span<char>, uint64_t) const;
+	void WriteStatistics();
 
 	// Command Analysis
-	Tokens InputTokenizer(std::string);
+	static std::optional<int64_t> ToInteger(std::string_view);
+	Tokens InputTokenizer(std::string_view);
 	void CommandDispatcher(const Tokens&);
+	void ReadCommand();
 
 	// Command Declaration
 	void Wreg(const Args&);
 	void Rreg(const Args&);
 	void Radc(const Args&);
+	void Sclk(const Args&);
+	void Sweep(const Args&);
+	void Irqtest(const Args&);
+	void Idle(const Args&);
+	void Heap(const Args&);
+	void Fmt(const Args&);
+	void Cmp(const Args&);
+	void Scan(const Args&);
+	void Psave(const Args&);
+	void Pload(const Args&);
+	void Pboot(const Args&);
+	void Plist(const Args&);
+	void Boot(const Args&);
+	void Crc(const Args&);
+	void Stat(const Args&);
+	void Rate(const Args&);
+	void Cal(const Args&);
+	void Rxonly(const Args&);
+	void Rxbench(const Args&);
+	void Lat(const Args&);
+	void Status(const Args&);
+	void Stop(const Args&);
+	void Tasks(const Args&);
 
 	friend void HAL_GPIO_EXTI_Callback(uint16_t);
+	friend void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef*);
 
 public:
 	Application() = default;
@@ -0,0 +1,56 @@
+/*
+ * arena.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef INC_ARENA_HPP_
+#define INC_ARENA_HPP_
+
+#include <memory_resource>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace arena_constants {
+	constexpr size_t kSize = 8 * 1024;
+}
+
+// Bump allocator over a static buffer, used as the polymorphic allocator of everything
+// a command allocates. Deallocation is a no-op; Reset() reclaims the whole arena once
+// the command has finished. When the arena is exhausted, allocations fall back to the
+// newlib heap and are counted as overflows.
+class ArenaResource : public std::pmr::memory_resource {
+private:
+	alignas(std::max_align_t) std::array<std::byte, arena_constants::kSize> buffer_;
+	size_t offset_{0};
+
+	// Statistics
+	size_t peak_{0};
+	uint32_t allocation_count_{0};
+	uint32_t overflow_count_{0};
+
+	void* do_allocate(size_t, size_t) override;
+	void do_deallocate(void*, size_t, size_t) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+public:
+	ArenaResource() = default;
+	ArenaResource(const ArenaResource&) = delete;
+	ArenaResource& operator=(const ArenaResource&) = delete;
+
+	struct StatisticsTypeDef {
+		size_t used;
+		size_t peak;
+		uint32_t allocation_count;
+		uint32_t overflow_count;
+	};
+
+	// Only when nothing allocated from the arena is alive
+	void Reset() { offset_ = 0; }
+
+	StatisticsTypeDef GetStatistics() const { return {offset_, peak_, allocation_count_, overflow_count_}; }
+};
+
+
+#endif /* INC_ARENA_HPP_ */
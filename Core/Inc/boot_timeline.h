@@ -0,0 +1,14 @@
+/*
+ * boot_timeline.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef INC_BOOT_TIMELINE_H_
+#define INC_BOOT_TIMELINE_H_
+
+// Records a named point of the boot sequence. Callable from main.c before HAL_Init().
+void boot_timeline_mark(const char* name);
+
+
+#endif /* INC_BOOT_TIMELINE_H_ */
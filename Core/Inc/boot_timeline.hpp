@@ -0,0 +1,49 @@
+/*
+ * boot_timeline.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef INC_BOOT_TIMELINE_HPP_
+#define INC_BOOT_TIMELINE_HPP_
+
+extern "C" {
+#include "main.h"
+}
+#include <array>
+#include <span>
+
+namespace boot_constants {
+	constexpr size_t kMaxMarks = 16;
+}
+
+// Cycle counter stamps of the boot sequence. The first mark starts the counter.
+// SystemCoreClock is stored with every mark, because the core runs from HSI until
+// SystemClock_Config() switches to the PLL.
+// The timeline starts at main() entry: Reset_Handler runs SystemInit(), the .data copy, the
+// .bss fill and the static constructors before that, with the counter stopped, and the marks
+// themselves live in .bss. That part of the startup is not measured.
+class BootTimeline {
+public:
+	struct MarkTypeDef {
+		const char* name;
+		uint32_t cycle;
+		uint32_t clock_hz;
+	};
+
+private:
+	static std::array<MarkTypeDef, boot_constants::kMaxMarks> mark_;
+	static size_t count_;
+
+public:
+	BootTimeline() = delete;
+
+	static void Mark(const char*);
+	static std::span<const MarkTypeDef> GetMarks();
+
+	// Time between two marks, at the clock that was running from the earlier one
+	static uint32_t ToMicroseconds(const MarkTypeDef&, const MarkTypeDef&);
+};
+
+
+#endif /* INC_BOOT_TIMELINE_HPP_ */
@@ -0,0 +1,114 @@
+/*
+ * calibration.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef INC_CALIBRATION_HPP_
+#define INC_CALIBRATION_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#if defined(__ARM_FEATURE_DSP)
+#include <arm_acle.h>
+#endif
+
+namespace calibration_constants {
+
+	constexpr size_t kGainFraction = 30;						// gain is Q2.30
+	constexpr int32_t kUnityGain = int32_t{1} << kGainFraction;
+	constexpr size_t kMinScans = 1;
+	constexpr size_t kDefaultScans = 256;
+
+}
+
+// Offset and gain of one ADC, as measured by CAL ZERO / CAL REF:
+// corrected = (code - offset) * gain / 2^30
+struct CalibrationTypeDef {
+	int32_t offset{0};									// codes
+	int32_t gain{calibration_constants::kUnityGain};	// Q2.30
+};
+
+// Per-sample correction in the data-ready interrupt. The code is left-justified to 31 bits (one
+// bit of headroom so the offset cannot clip before the gain; 32-bit parts have none) so that one
+// set of saturating instructions serves every resolution: QSUB for the offset, SMMULR for the
+// gain and SSAT before scaling back, all branch-free. The host build gets the same arithmetic in
+// portable code.
+class Calibration {
+public:
+	// CalibrationTypeDef prepared for Apply(): offset left-justified, gain possibly scaled to microvolts
+	struct TermTypeDef {
+		int32_t offset;
+		int32_t gain;
+	};
+
+private:
+	static int32_t QSub(int32_t a, int32_t b)
+	{
+#if defined(__ARM_FEATURE_DSP)
+		return __qsub(a, b);
+#else
+		const int64_t r = static_cast<int64_t>(a) - b;
+		return static_cast<int32_t>((r > INT32_MAX) ? INT32_MAX : (r < INT32_MIN) ? INT32_MIN : r);
+#endif
+	}
+	// Upper word of the product, rounded
+	static int32_t MulHigh(int32_t a, int32_t b)
+	{
+#if defined(__ARM_FEATURE_DSP)
+		int32_t r;
+		__asm__("smmulr %0, %1, %2" : "=r"(r) : "r"(a), "r"(b));
+		return r;
+#else
+		return static_cast<int32_t>((static_cast<int64_t>(a) * b + 0x8000'0000) >> 32);
+#endif
+	}
+	// Saturates to `Bits` bits signed
+	template <unsigned Bits>
+	static int32_t Saturate(int32_t a)
+	{
+#if defined(__ARM_FEATURE_DSP)
+		return __ssat(a, Bits);
+#else
+		constexpr int32_t kMax = (int32_t{1} << (Bits - 1)) - 1;
+		return (a > kMax) ? kMax : (a < -kMax - 1) ? -kMax - 1 : a;
+#endif
+	}
+	template <size_t Resolution>
+	static constexpr size_t kHeadroom = (Resolution < 32) ? 1 : 0;
+
+public:
+	Calibration() = delete;
+
+	// Fails (returns false) if the scaled gain does not fit Q2.30. With `vref_uv` != 0 the result
+	// is in microvolts instead of codes (full scale = +-vref).
+	template <size_t Resolution>
+	static bool Prepare(const CalibrationTypeDef& calibration, uint32_t vref_uv, TermTypeDef& term)
+	{
+		int64_t gain = calibration.gain;
+		if(vref_uv != 0) gain = (gain * vref_uv) >> (Resolution - 1);
+		if(gain >= INT32_MAX || gain <= INT32_MIN) return false;
+
+		const int64_t offset = static_cast<int64_t>(calibration.offset) * (int64_t{1} << (32 - Resolution - kHeadroom<Resolution>));
+		term.offset = static_cast<int32_t>((offset > INT32_MAX) ? INT32_MAX : (offset < INT32_MIN) ? INT32_MIN : offset);
+		term.gain = static_cast<int32_t>(gain);
+		return true;
+	}
+
+	// `code` as returned by AdcDevice::Decode(); the result has the same form, saturated at full scale
+	template <size_t Resolution>
+	static uint32_t Apply(uint32_t code, const TermTypeDef& term)
+	{
+		constexpr size_t kShift = 32 - Resolution;
+		constexpr size_t kHead = kHeadroom<Resolution>;
+		constexpr uint32_t kMask = (Resolution >= 32) ? 0xFFFF'FFFF : ((1u << Resolution) - 1);
+
+		const int32_t x = static_cast<int32_t>(code << kShift) >> kHead;
+		// (x - offset) * gain / 2^30 = MulHigh(x - offset, gain) * 4, then back to 32 bits
+		const int32_t y = Saturate<30 - kHead>(MulHigh(QSub(x, term.offset), term.gain)) * (4 << kHead);
+		return static_cast<uint32_t>(y >> kShift) & kMask;
+	}
+};
+
+
+#endif /* INC_CALIBRATION_HPP_ */
@@ -7,12 +7,14 @@
 #ifndef INC_CONSTANTS_HPP_
 #define INC_CONSTANTS_HPP_
 
+#include <adc_device.hpp>
 #include <array>
 
 namespace reg_constants {
 
 	constexpr uint64_t kReadFlag 	= 0b1000'0000;
 	constexpr uint64_t kWriteFlag	= 0b0000'0000;
+	constexpr size_t kFrameSize		= 5;
 	constexpr std::array<uint64_t, 5> kRegAddr = {
 		0b0000'0000,
 		0b0000'0001,
@@ -21,12 +23,48 @@ namespace reg_constants {
 		0b0000'0100
 	};
 
+}
+namespace adc_constants {
+
+	constexpr size_t kResolution = AdcProfile::kResolution;
+	constexpr size_t kFrameSize = AdcProfile::kFrameSize;		// bytes on the wire
+	constexpr size_t kWordBits = AdcProfile::kWordBits;			// SPI frame size of a read
+	constexpr size_t kBufferSize = AdcProfile::kBufferSize;		// bytes in the receive buffer
+	constexpr uint32_t kVref_uV = 2'500'000;
+
 }
 namespace cs_constants {
 
 	constexpr size_t kADC = 0;
 	constexpr size_t kReg = 1;
 
+}
+namespace sweep_constants {
+
+	constexpr std::array<uint32_t, 4> kPattern = {
+		0xAAAA'AAAA,
+		0x5555'5555,
+		0xFFFF'FFFF,
+		0x0000'0000
+	};
+	constexpr size_t kDefaultIteration = 100;
+
+}
+namespace irq_test_constants {
+
+	constexpr size_t kDefaultIteration = 1000;
+	constexpr uint32_t kMaxPhase = 20'000;		// cycles, spreads triggers over the UART byte time
+	constexpr uint32_t kTimeOut = 1'000'000;	// cycles
+	constexpr size_t kTrafficLength = 64;		// bytes per load line, CR+LF included
+	constexpr std::array<char, 8> kTrafficPrefix = {'I', 'R', 'Q', 'L', 'O', 'A', 'D', ' '};
+
+}
+namespace rx_bench_constants {
+
+	constexpr size_t kDefaultScans = 1000;
+	constexpr size_t kCalibrationPolls = 10'000;
+	constexpr uint32_t kTimeOut = 1'000'000;	// cycles per scan
+
 }
 
 #endif /* INC_CONSTANTS_HPP_ */
@@ -0,0 +1,61 @@
+/*
+ * conversion_clock.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef INC_CONVERSION_CLOCK_HPP_
+#define INC_CONVERSION_CLOCK_HPP_
+
+extern "C" {
+#include "main.h"
+}
+#include <cstdint>
+
+namespace clock_constants {
+
+	constexpr uint32_t kMinRate = 1;			// Hz
+	constexpr uint32_t kMaxRate = 1'000'000;	// Hz, one read per period must still fit
+	constexpr uint32_t kMaxCount = 0x1'0000;	// TIM4 is a 16-bit timer (prescaler and period)
+
+}
+
+// Where the conversions of a RADC come from:
+// kExternal	CLKDEC edges (PD15) from the board, read in the EXTI callback
+// kTimer		TIM4 CH1 PWM on CONVST (PD12) clocks the ADC, its data-ready edges still come in on CLKDEC
+// kTriggered	TIM4 CH1 PWM as above, and the TIM4 update interrupt starts the read of the conversion
+//				started one period earlier, so CLKDEC and the EXTI are not used at all
+enum class ClockSourceTypeDef {
+	kExternal,
+	kTimer,
+	kTriggered
+};
+
+class ConversionClock {
+private:
+	static TIM_HandleTypeDef* htim_;
+	static ClockSourceTypeDef source_;
+
+	static uint32_t GetTimerClock();
+
+public:
+	ConversionClock() = delete;
+
+	// Initializer
+	static void Init(TIM_HandleTypeDef*);
+
+	// Setter
+	static HAL_StatusTypeDef SetRate(uint32_t);
+	static HAL_StatusTypeDef SetSource(ClockSourceTypeDef);
+
+	// Getter
+	static uint64_t GetRate_mHz();
+	static ClockSourceTypeDef GetSource();
+
+	// Acquisition (kTriggered only; enables and disables the update interrupt)
+	static void EnableTrigger();
+	static void DisableTrigger();
+};
+
+
+#endif /* INC_CONVERSION_CLOCK_HPP_ */
@@ -0,0 +1,37 @@
+/*
+ * crc_unit.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef INC_CRC_UNIT_HPP_
+#define INC_CRC_UNIT_HPP_
+
+extern "C" {
+#include "main.h"
+}
+#include <span>
+
+// CRC-32 (IEEE 802.3, same as zlib) on the CRC peripheral. MX_CRC_Init() sets the default
+// polynomial and initial value with byte-wise input and output bit reversal, so the result
+// matches the host's software CRC byte for byte. Data is fed as whole words, four bytes per
+// bus write; the unit has no other user, so main-loop callers need no locking.
+class CRCUnit {
+private:
+	static CRC_HandleTypeDef* hcrc_;
+
+public:
+	CRCUnit() = delete;
+
+	// Initializer
+	static void Init(CRC_HandleTypeDef*);
+
+	// Calculation
+	static void Reset();
+	static void Accumulate(std::span<const uint8_t>);
+	static uint32_t Get();
+	static uint32_t Calculate(std::span<const uint8_t>);
+};
+
+
+#endif /* INC_CRC_UNIT_HPP_ */
@@ -0,0 +1,29 @@
+/*
+ * critical_section.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef INC_CRITICAL_SECTION_HPP_
+#define INC_CRITICAL_SECTION_HPP_
+
+extern "C" {
+#include "main.h"
+}
+
+// Masks all configurable interrupts for the lifetime of the object.
+// PRIMASK is restored rather than cleared, so sections nest and may be used from ISRs.
+class CriticalSection {
+private:
+	uint32_t primask_;
+
+public:
+	CriticalSection() : primask_(__get_PRIMASK()) { __disable_irq(); }
+	~CriticalSection() { __set_PRIMASK(primask_); }
+
+	CriticalSection(const CriticalSection&) = delete;
+	CriticalSection& operator=(const CriticalSection&) = delete;
+};
+
+
+#endif /* INC_CRITICAL_SECTION_HPP_ */
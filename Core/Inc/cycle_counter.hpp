@@ -0,0 +1,43 @@
+/*
+ * cycle_counter.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef INC_CYCLE_COUNTER_HPP_
+#define INC_CYCLE_COUNTER_HPP_
+
+extern "C" {
+#include "main.h"
+}
+
+// DWT cycle counter. Wraps every 2^32 cycles (about 22 s at 192 MHz),
+// so only differences of unsigned values should be used.
+class CycleCounter {
+public:
+	CycleCounter() = delete;
+
+	// Keeps counting if already running, so stamps taken during boot stay comparable
+	static void Init()
+	{
+		if(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) return;
+		CoreDebug->DEMCR = CoreDebug->DEMCR | CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->LAR = 0xC5AC'CE55;
+		DWT->CYCCNT = 0;
+		DWT->CTRL = DWT->CTRL | DWT_CTRL_CYCCNTENA_Msk;
+	}
+
+	static uint32_t Now() { return DWT->CYCCNT; }
+
+	static uint32_t ToNanoseconds(uint32_t cycles)
+	{
+		return static_cast<uint32_t>((static_cast<uint64_t>(cycles) * 1'000'000'000) / SystemCoreClock);
+	}
+	static uint32_t ToMicroseconds(uint32_t cycles)
+	{
+		return static_cast<uint32_t>((static_cast<uint64_t>(cycles) * 1'000'000) / SystemCoreClock);
+	}
+};
+
+
+#endif /* INC_CYCLE_COUNTER_HPP_ */
@@ -0,0 +1,63 @@
+/*
+ * event.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef INC_EVENT_HPP_
+#define INC_EVENT_HPP_
+
+extern "C" {
+#include "main.h"
+}
+#include <atomic>
+
+namespace event_constants {
+
+	constexpr uint32_t kUARTRx	= 1u << 0;
+	constexpr uint32_t kSPI		= 1u << 1;
+	constexpr uint32_t kSample	= 1u << 2;
+	constexpr uint32_t kUARTTx	= 1u << 3;
+	constexpr uint32_t kWake	= 1u << 30;		// a Queue or Mutex changed (kernel.hpp)
+	constexpr uint32_t kReady	= 1u << 31;		// a task became ready
+	constexpr uint32_t kAll		= 0xFFFF'FFFF;
+
+	constexpr uint32_t kForever	= 0xFFFF'FFFF;	// timeout of Wait()
+
+}
+
+// ISRs post event bits, the main loop sleeps (WFI) until one of the bits it waits for is set.
+// Called from a task of the kernel (kernel.hpp), Wait() blocks only that task. A timeout is
+// checked whenever the core wakes, which SysTick guarantees at least every millisecond.
+class Event {
+private:
+	static std::atomic<uint32_t> pending_;
+
+	// Idle statistics (SysTick based, the DWT cycle counter stops while the core sleeps)
+	static uint64_t sleep_cycles_;
+	static uint64_t busy_cycles_;
+	static uint32_t wake_stamp_;
+
+	static uint32_t Timestamp();
+
+public:
+	Event() = delete;
+	struct StatisticsTypeDef {
+		uint64_t sleep_cycles;
+		uint64_t busy_cycles;
+	};
+
+	// Initializer
+	static void Init();
+
+	// Event
+	static void Post(uint32_t);
+	static uint32_t Wait(uint32_t, uint32_t = event_constants::kForever);	// timeout in ms; 0 if it passed
+
+	// Statistics
+	static StatisticsTypeDef GetStatistics();
+	static void ResetStatistics();
+};
+
+
+#endif /* INC_EVENT_HPP_ */
@@ -0,0 +1,159 @@
+/*
+ * format.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef INC_FORMAT_HPP_
+#define INC_FORMAT_HPP_
+
+#include <array>
+#include <span>
+#include <cstdint>
+#include <cstddef>
+
+enum class FormatTypeDef : uint8_t {
+	kBin,
+	kHex,
+	kDec,
+	kVolt
+};
+
+// Heap-free integer to text conversion into a caller-provided buffer (e.g. UARTDriver::GetTxBuffer()).
+// Every function returns the number of characters written, or 0 if the buffer is too small.
+class Format {
+private:
+	static constexpr std::array<char, 16> kHexDigit = {
+		'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
+	};
+	// "000102...99": two decimal digits per lookup
+	static constexpr std::array<char, 200> kDecPair = [] {
+		std::array<char, 200> table{};
+		for(size_t i = 0; i < 100; ++i) {
+			table[2 * i]		= static_cast<char>('0' + i / 10);
+			table[2 * i + 1]	= static_cast<char>('0' + i % 10);
+		}
+		return table;
+	}();
+	// Four binary digits per lookup
+	static constexpr std::array<std::array<char, 4>, 16> kBinNibble = [] {
+		std::array<std::array<char, 4>, 16> table{};
+		for(size_t i = 0; i < 16; ++i) {
+			for(size_t b = 0; b < 4; ++b) table[i][b] = (i & (0b1000 >> b)) ? '1' : '0';
+		}
+		return table;
+	}();
+
+	// Writes the digits right-aligned in a 20-character scratch and returns the first digit
+	static char* Digits(std::array<char, 20>& scratch, uint64_t value)
+	{
+		char* p = scratch.data() + scratch.size();
+		while(value >= 100) {
+			const size_t pair = static_cast<size_t>(value % 100) * 2;
+			value /= 100;
+			*--p = kDecPair[pair + 1];
+			*--p = kDecPair[pair];
+		}
+		if(value >= 10) {
+			const size_t pair = static_cast<size_t>(value) * 2;
+			*--p = kDecPair[pair + 1];
+			*--p = kDecPair[pair];
+		}
+		else {
+			*--p = static_cast<char>('0' + value);
+		}
+		return p;
+	}
+
+public:
+	Format() = delete;
+
+	// Lowest `bits` bits, MSB first
+	static size_t Bin(std::span<char> out, uint64_t value, size_t bits)
+	{
+		if(bits == 0 || bits > 64 || out.size() < bits) return 0;
+
+		size_t n = 0;
+		const size_t head = bits % 4;
+		for(size_t b = head; b > 0; --b) out[n++] = ((value >> (bits - head + b - 1)) & 1) ? '1' : '0';
+		for(size_t shift = bits - head; shift > 0; shift -= 4) {
+			const auto& nibble = kBinNibble[(value >> (shift - 4)) & 0xF];
+			out[n++] = nibble[0];
+			out[n++] = nibble[1];
+			out[n++] = nibble[2];
+			out[n++] = nibble[3];
+		}
+		return n;
+	}
+
+	// ceil(bits / 4) upper-case digits, zero padded
+	static size_t Hex(std::span<char> out, uint64_t value, size_t bits)
+	{
+		const size_t digits = (bits + 3) / 4;
+		if(digits == 0 || digits > 16 || out.size() < digits) return 0;
+
+		for(size_t i = digits; i > 0; --i) {
+			out[i - 1] = kHexDigit[value & 0xF];
+			value >>= 4;
+		}
+		return digits;
+	}
+
+	static size_t Udec(std::span<char> out, uint64_t value)
+	{
+		std::array<char, 20> scratch;
+		const char* first = Digits(scratch, value);
+		const size_t n = static_cast<size_t>(scratch.data() + scratch.size() - first);
+		if(out.size() < n) return 0;
+
+		for(size_t i = 0; i < n; ++i) out[i] = first[i];
+		return n;
+	}
+
+	static size_t Dec(std::span<char> out, int64_t value)
+	{
+		if(value >= 0) return Udec(out, static_cast<uint64_t>(value));
+		if(out.empty()) return 0;
+
+		const size_t n = Udec(out.subspan(1), ~static_cast<uint64_t>(value) + 1);
+		if(n == 0) return 0;
+		out[0] = '-';
+		return n + 1;
+	}
+
+	// Two's complement `bits`-bit code to a signed integer
+	static constexpr int32_t SignExtend(uint32_t code, size_t bits)
+	{
+		const uint32_t sign = 1u << (bits - 1);
+		code &= (bits >= 32) ? 0xFFFF'FFFF : ((1u << bits) - 1);
+		return static_cast<int32_t>((code ^ sign) - sign);
+	}
+
+	// Two's complement `bits`-bit code to volts with six decimals (full scale = +-vref)
+	static size_t Volt(std::span<char> out, uint32_t code, size_t bits, uint32_t vref_uv)
+	{
+		const int64_t uv = (static_cast<int64_t>(SignExtend(code, bits)) * vref_uv) >> (bits - 1);
+		const uint64_t magnitude = (uv < 0) ? static_cast<uint64_t>(-uv) : static_cast<uint64_t>(uv);
+
+		size_t n = 0;
+		if(uv < 0) {
+			if(out.empty()) return 0;
+			out[n++] = '-';
+		}
+		const size_t integer = Udec(out.subspan(n), magnitude / 1'000'000);
+		if(integer == 0) return 0;
+		n += integer;
+
+		if(out.size() < n + 7) return 0;
+		out[n++] = '.';
+		uint32_t fraction = static_cast<uint32_t>(magnitude % 1'000'000);
+		for(size_t i = 6; i > 0; --i) {
+			out[n + i - 1] = static_cast<char>('0' + fraction % 10);
+			fraction /= 10;
+		}
+		return n + 6;
+	}
+};
+
+
+#endif /* INC_FORMAT_HPP_ */
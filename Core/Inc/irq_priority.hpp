@@ -0,0 +1,58 @@
+/*
+ * irq_priority.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef INC_IRQ_PRIORITY_HPP_
+#define INC_IRQ_PRIORITY_HPP_
+
+extern "C" {
+#include "main.h"
+}
+#include <array>
+
+// Interrupt priority plan (NVIC_PRIORITYGROUP_4: 16 preemption levels, no sub-priority).
+// The acquisition chain (SPI completion, then data-ready edge or conversion timer) preempts everything else,
+// so communication traffic can only delay the main loop, never a sample.
+namespace irq_constants {
+
+	struct PriorityTypeDef {
+		IRQn_Type irqn;
+		uint32_t preempt;
+	};
+
+	constexpr uint32_t kAcquisitionSPI		= 0;
+	constexpr uint32_t kAcquisitionEXTI		= 1;
+	constexpr uint32_t kSysTick				= 4;
+	constexpr uint32_t kCommunication		= 6;
+	constexpr uint32_t kBackground			= 8;
+
+	constexpr std::array<PriorityTypeDef, 7> kPlan = {{
+		{SPI1_IRQn,			kAcquisitionSPI},
+		{EXTI15_10_IRQn,	kAcquisitionEXTI},
+		{TIM4_IRQn,			kAcquisitionEXTI},
+		{SysTick_IRQn,		kSysTick},
+		{USART3_IRQn,		kCommunication},
+		{OTG_FS_IRQn,		kBackground},
+		{ETH_IRQn,			kBackground}
+	}};
+
+}
+
+class IRQPriority {
+public:
+	IRQPriority() = delete;
+
+	// Overrides the 0/0 priorities set by the generated MX_*_Init/MspInit code.
+	// Enable state of each IRQ is left untouched.
+	static void Apply()
+	{
+		for(const auto& p : irq_constants::kPlan) {
+			HAL_NVIC_SetPriority(p.irqn, p.preempt, 0);
+		}
+	}
+};
+
+
+#endif /* INC_IRQ_PRIORITY_HPP_ */
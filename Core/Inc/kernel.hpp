@@ -0,0 +1,177 @@
+/*
+ * kernel.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef INC_KERNEL_HPP_
+#define INC_KERNEL_HPP_
+
+extern "C" {
+#include "main.h"
+}
+#include <event.hpp>
+#include <array>
+#include <span>
+#include <cstddef>
+
+namespace kernel_constants {
+
+	constexpr size_t kMaxTask = 4;
+	constexpr uint32_t kStackFill = 0xA5A5'A5A5;		// stack words never written keep this
+	constexpr uint8_t kMaxPriority = 15;
+
+}
+
+// A thread of the task build (USE_TASK_KERNEL) with its own stack. Higher priority runs first.
+// Interrupts stack onto whichever task they interrupt, so every stack needs room for the
+// deepest interrupt nesting on top of its own use.
+class Task {
+private:
+	friend class Kernel;
+	friend class Mutex;
+
+	const char* name_;
+	uint8_t priority_;
+	uint8_t effective_priority_;		// raised while it owns a mutex a higher task waits for
+	std::span<uint32_t> stack_;
+	void (*entry_)(void*);
+	void* argument_;
+	size_t slot_{0};
+	uint32_t switch_count_{0};
+
+	// Also written by Event::Post() from interrupts, inside CriticalSection
+	bool is_waiting_{false};
+	uint32_t events_{0};
+	uint32_t wait_mask_{0};
+	uint32_t wait_start_{0};				// HAL_GetTick() when the timeout started
+	uint32_t wait_timeout_{event_constants::kForever};
+
+	class Mutex* waiting_for_{nullptr};
+
+public:
+	Task(const char* name, uint8_t priority, std::span<uint32_t> stack, void (*entry)(void*), void* argument)
+		: name_(name), priority_(priority), effective_priority_(priority), stack_(stack), entry_(entry), argument_(argument) {}
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+
+	// Getter
+	const char* GetName() const { return name_; }
+	uint8_t GetPriority() const { return priority_; }
+	uint8_t GetEffectivePriority() const { return effective_priority_; }
+	uint32_t GetSwitchCount() const { return switch_count_; }
+	size_t GetStackSize() const { return stack_.size_bytes(); }
+	size_t GetStackUsed() const;		// high-water mark, in bytes
+};
+
+// Cooperative priority scheduler. A task runs until it waits: Event::Wait() called from a task
+// blocks only that task, and so do Queue and Mutex. The highest ready task runs next, tasks of
+// equal priority take turns. Mutex::Unlock() and Queue also yield, so a higher task they wake
+// runs right away instead of at the next wait. Interrupts never switch tasks, they only make them ready through
+// Event::Post(); with none ready the scheduler sleeps in Event::Wait() on the main stack, waking
+// every tick while a task waits with a timeout.
+class Kernel {
+private:
+	static std::array<Task*, kernel_constants::kMaxTask> task_;
+	static size_t task_count_;
+	static Task* current_;
+	static size_t last_index_;
+	static uint32_t main_stack_;
+
+	static void Entry();
+	static Task* Pick();
+	static bool IsExpired(const Task&);
+	static void Switch();
+
+public:
+	Kernel() = delete;
+
+	// Before Start() only
+	static HAL_StatusTypeDef Create(Task&);
+	// Runs the tasks on the calling stack; never returns
+	[[noreturn]] static void Start();
+
+	// Getter
+	static Task* Current();			// nullptr outside a task (before Start(), in the scheduler)
+	static size_t CurrentSlot();		// 0 outside a task, 1 + creation order in one
+	static std::span<Task* const> GetTasks();
+	static uint32_t GetMainStack();	// MSP of the scheduler, 0 before Start()
+
+	// Task context
+	static uint32_t Wait(uint32_t, uint32_t);
+	static void Yield();				// lets a ready task of higher priority run first
+
+	// From Event::Post(), any context. Returns true if a waiting task became ready.
+	static bool Notify(uint32_t);
+};
+
+// Owned by one task at a time. A task that has to wait lends its priority to the owner (and on
+// to whatever that one waits for) until Unlock(), so a low-priority owner is not held up by the
+// tasks in between. Outside a task (the superloop build, Init) Lock() and Unlock() do nothing.
+class Mutex {
+private:
+	friend class Kernel;
+
+	Task* owner_{nullptr};
+
+	void Restore(Task&);
+
+public:
+	Mutex() = default;
+	Mutex(const Mutex&) = delete;
+	Mutex& operator=(const Mutex&) = delete;
+
+	void Lock();
+	void Unlock();
+	Task* GetOwner() const { return owner_; }
+
+	class Guard {
+	private:
+		Mutex& mutex_;
+
+	public:
+		explicit Guard(Mutex& mutex) : mutex_(mutex) { mutex_.Lock(); }
+		~Guard() { mutex_.Unlock(); }
+		Guard(const Guard&) = delete;
+		Guard& operator=(const Guard&) = delete;
+	};
+};
+
+// Blocking FIFO between tasks: Send() waits while it is full, Receive() while it is empty.
+// Not for interrupts, which hand data over through SPSCQueue and Event.
+template <typename T, size_t N>
+class Queue {
+private:
+	std::array<T, N> entry_{};
+	size_t head_{0};
+	size_t count_{0};
+
+public:
+	void Send(const T& value)
+	{
+		while(count_ == N) Event::Wait(event_constants::kWake);
+		entry_[(head_ + count_) % N] = value;
+		++count_;
+		Event::Post(event_constants::kWake);
+		Kernel::Yield();
+	}
+	T Receive()
+	{
+		while(count_ == 0) Event::Wait(event_constants::kWake);
+		const T value = entry_[head_];
+		head_ = (head_ + 1) % N;
+		--count_;
+		Event::Post(event_constants::kWake);
+		Kernel::Yield();
+		return value;
+	}
+	size_t Size() const { return count_; }
+};
+
+// Task switch of the port: kernel.cpp for the Cortex-M7, Host/Emu/kernel_port.cpp for fw_emu.
+// Slot 0 is the scheduler on the stack Start() was called on.
+void kernel_port_prepare(size_t slot, std::span<uint32_t> stack, void (*entry)());
+void kernel_port_switch(size_t from, size_t to);
+
+
+#endif /* INC_KERNEL_HPP_ */
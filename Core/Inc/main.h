@@ -49,6 +49,8 @@ extern "C" {
 
 /* USER CODE END EM */
 
+void HAL_TIM_MspPostInit(TIM_HandleTypeDef *htim);
+
 /* Exported functions prototypes ---------------------------------------------*/
 void Error_Handler(void);
 
@@ -86,6 +88,8 @@ void Error_Handler(void);
 #define STLK_RX_GPIO_Port GPIOD
 #define STLK_TX_Pin GPIO_PIN_9
 #define STLK_TX_GPIO_Port GPIOD
+#define CONVST_Pin GPIO_PIN_12
+#define CONVST_GPIO_Port GPIOD
 #define CS0_Pin GPIO_PIN_14
 #define CS0_GPIO_Port GPIOD
 #define CLKDEC_Pin GPIO_PIN_15
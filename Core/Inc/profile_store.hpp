@@ -0,0 +1,108 @@
+/*
+ * profile_store.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef INC_PROFILE_STORE_HPP_
+#define INC_PROFILE_STORE_HPP_
+
+extern "C" {
+#include "main.h"
+}
+#include <calibration.hpp>
+#include <array>
+#include <span>
+#include <string_view>
+
+namespace profile_constants {
+
+	// Last sector of the single-bank layout (256 KB). The linker script must keep code out of it.
+	constexpr uint32_t kSector = FLASH_SECTOR_11;
+	constexpr uint32_t kAddress = 0x081C'0000;
+	constexpr uint32_t kSize = 256 * 1024;
+
+	constexpr uint32_t kMagic = 0x5046'5231;
+	constexpr uint32_t kErased = 0xFFFF'FFFF;
+	constexpr size_t kNameSize = 8;
+	constexpr size_t kRegisterCount = 3;
+	constexpr size_t kMaxProfiles = 16;
+	constexpr size_t kMaxDevices = 8;			// calibrations, spi_constants::kMaxPin
+
+}
+
+struct ProfileTypeDef {
+	std::array<char, profile_constants::kNameSize> name;
+	std::array<uint32_t, profile_constants::kRegisterCount> value;
+
+	std::string_view GetName() const;
+};
+
+// Named register profiles kept as an append-only log in a reserved flash sector, together with
+// the boot selection and the calibration of each ADC. The newest valid record of a name wins;
+// Init() indexes them in RAM, so lookups never walk the log. When the sector is full it is
+// erased once and the indexed records are written back, so each save costs one record of wear
+// instead of one sector erase.
+class ProfileStore {
+private:
+	enum class RecordKindTypeDef : uint32_t {
+		kProfile = 1,
+		kBoot = 2,
+		kCalibration = 3		// unnamed; value = {device, offset, gain}
+	};
+	// Programmed word by word; a record torn by a reset fails the CRC and is skipped
+	struct RecordTypeDef {
+		uint32_t magic;
+		RecordKindTypeDef kind;
+		ProfileTypeDef profile;
+		uint32_t crc;
+	};
+	static_assert(sizeof(RecordTypeDef) % sizeof(uint32_t) == 0);
+
+	static uint32_t end_;
+
+	// Newest record of every profile (in order of first appearance), of the boot selection and
+	// of every calibration: indexed by Init() in one pass over the log, kept by Append()
+	static std::array<ProfileTypeDef, profile_constants::kMaxProfiles> profiles_;
+	static size_t profile_count_;
+	static RecordTypeDef boot_;											// magic is 0 if none
+	static std::array<RecordTypeDef, profile_constants::kMaxDevices> calibrations_;	// likewise
+
+	static uint32_t Checksum(const RecordTypeDef&);
+	static bool ReadRecord(uint32_t, RecordTypeDef&);
+	static void Index(const RecordTypeDef&);
+	static HAL_StatusTypeDef Append(RecordKindTypeDef, const ProfileTypeDef&);
+	static HAL_StatusTypeDef Program(uint32_t, const RecordTypeDef&);
+	static HAL_StatusTypeDef Erase();
+	static HAL_StatusTypeDef Compact();
+
+public:
+	ProfileStore() = delete;
+	struct StatisticsTypeDef {
+		uint32_t used;
+		uint32_t size;
+	};
+
+	// Initializer
+	static void Init();
+
+	// Profile
+	static bool IsValidName(std::string_view);
+	static HAL_StatusTypeDef Save(std::string_view, std::span<const uint32_t, profile_constants::kRegisterCount>);
+	static bool Find(std::string_view, ProfileTypeDef&);
+	static size_t List(std::span<ProfileTypeDef>);
+
+	// Boot profile (an empty name disables it)
+	static HAL_StatusTypeDef SetBoot(std::string_view);
+	static bool GetBoot(ProfileTypeDef&);
+
+	// Calibration of one ADC (CS index)
+	static HAL_StatusTypeDef SaveCalibration(size_t, const CalibrationTypeDef&);
+	static bool FindCalibration(size_t, CalibrationTypeDef&);
+
+	// Statistics
+	static StatisticsTypeDef GetStatistics();
+};
+
+
+#endif /* INC_PROFILE_STORE_HPP_ */
@@ -0,0 +1,251 @@
+/*
+ * rice_codec.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef INC_RICE_CODEC_HPP_
+#define INC_RICE_CODEC_HPP_
+
+#include <array>
+#include <span>
+#include <cstdint>
+#include <cstddef>
+
+// Lossless block codec for ADC samples: fixed delta predictor (order 0, 1 or 2) followed by
+// Rice coding of the zigzag-mapped residuals with one parameter k per block.
+// Shared by the firmware (encoder) and the host tools (decoder), so it must stay HAL-free.
+//
+// Block layout (every block decodes on its own):
+//   [0]    kMagic
+//   [1]    predictor order
+//   [2]    Rice parameter k
+//   [3:4]  sample count (little endian)
+//   [5:6]  payload size in bytes (little endian)
+//   [7]    XOR of bytes 0..6
+//   payload, MSB first:
+//     `order` warm-up samples, 32 bits each
+//     per residual: q = u >> k as q one-bits and a zero-bit, then the low k bits of u;
+//     if q >= kEscape: kEscape one-bits and u as 32 raw bits
+//
+// Arithmetic is modulo 2^32, so any uint32_t input round-trips. Sign-extend two's complement
+// samples before encoding, otherwise a zero crossing looks like a full-scale step.
+namespace rice_constants {
+
+	constexpr uint8_t kMagic = 0xA5;
+	constexpr size_t kHeaderSize = 8;
+	constexpr size_t kBlockSamples = 256;
+	constexpr uint32_t kEscape = 24;
+	constexpr uint8_t kMaxOrder = 2;
+	constexpr size_t kMaxPayload = (kMaxOrder * 32 + kBlockSamples * (kEscape + 32) + 7) / 8;
+	constexpr size_t kMaxBlockSize = kHeaderSize + kMaxPayload;
+
+}
+
+class RiceCodec {
+private:
+	class BitWriter {
+	private:
+		std::span<uint8_t> out_;
+		size_t byte_{0};
+		uint64_t acc_{0};
+		size_t acc_bits_{0};	// < 8 between calls
+
+	public:
+		explicit BitWriter(std::span<uint8_t> out) : out_(out) {}
+
+		bool Put(uint32_t value, size_t bits)
+		{
+			if(bits == 0) return true;
+			if(bits < 32) value &= (1u << bits) - 1;
+
+			acc_ = (acc_ << bits) | value;
+			acc_bits_ += bits;
+			while(acc_bits_ >= 8)
+			{
+				if(byte_ >= out_.size()) return false;
+				acc_bits_ -= 8;
+				out_[byte_++] = static_cast<uint8_t>(acc_ >> acc_bits_);
+			}
+			return true;
+		}
+		bool PutOnes(size_t n)
+		{
+			for(; n >= 32; n -= 32) {
+				if(!Put(0xFFFF'FFFF, 32)) return false;
+			}
+			return Put(0xFFFF'FFFF, n);
+		}
+		// Pads the last byte with zero-bits
+		bool Flush()
+		{
+			if(acc_bits_ == 0) return true;
+			if(byte_ >= out_.size()) return false;
+			out_[byte_++] = static_cast<uint8_t>(acc_ << (8 - acc_bits_));
+			acc_bits_ = 0;
+			return true;
+		}
+		size_t Bytes() const { return byte_; }
+	};
+
+	class BitReader {
+	private:
+		std::span<const uint8_t> in_;
+		size_t byte_{0};
+		uint64_t acc_{0};
+		size_t acc_bits_{0};
+
+	public:
+		explicit BitReader(std::span<const uint8_t> in) : in_(in) {}
+
+		bool Get(uint32_t& value, size_t bits)
+		{
+			while(acc_bits_ < bits)
+			{
+				if(byte_ >= in_.size()) return false;
+				acc_ = (acc_ << 8) | in_[byte_++];
+				acc_bits_ += 8;
+			}
+			acc_bits_ -= bits;
+			value = (bits == 0) ? 0 : static_cast<uint32_t>((acc_ >> acc_bits_) & ((uint64_t{1} << bits) - 1));
+			return true;
+		}
+		// Counts one-bits up to `limit`, consuming the terminating zero-bit if there is one
+		bool GetUnary(uint32_t& q, uint32_t limit)
+		{
+			q = 0;
+			while(q < limit)
+			{
+				uint32_t bit;
+				if(!Get(bit, 1)) return false;
+				if(bit == 0) return true;
+				++q;
+			}
+			return true;
+		}
+	};
+
+	static constexpr uint32_t ZigZag(uint32_t r) { return (r << 1) ^ static_cast<uint32_t>(static_cast<int32_t>(r) >> 31); }
+	static constexpr uint32_t UnZigZag(uint32_t u) { return (u >> 1) ^ (0u - (u & 1)); }
+
+	static constexpr uint32_t Predict(const uint32_t* x, size_t i, uint8_t order)
+	{
+		switch(order) {
+		case 1:		return x[i - 1];
+		case 2:		return 2 * x[i - 1] - x[i - 2];
+		default:	return 0;
+		}
+	}
+
+	static constexpr uint8_t Checksum(std::span<const uint8_t> header)
+	{
+		uint8_t sum = 0;
+		for(size_t i = 0; i < rice_constants::kHeaderSize - 1; ++i) sum ^= header[i];
+		return sum;
+	}
+
+public:
+	RiceCodec() = delete;
+
+	struct HeaderTypeDef {
+		uint8_t order;
+		uint8_t k;
+		uint16_t count;
+		uint16_t payload;
+	};
+	struct DecodeResultTypeDef {
+		size_t samples;		// 0 on error
+		size_t bytes;		// size of the decoded block including the header
+	};
+
+	// Encodes up to kBlockSamples samples into one block. Returns the block size, 0 on error.
+	static size_t Encode(std::span<const uint32_t> x, uint8_t order, std::span<uint8_t> out)
+	{
+		const size_t n = x.size();
+		if(n == 0 || n > rice_constants::kBlockSamples) return 0;
+		if(order > rice_constants::kMaxOrder) return 0;
+		if(out.size() < rice_constants::kHeaderSize) return 0;
+
+		const size_t warm = (order < n) ? order : n;
+
+		// Rice parameter from the mean residual magnitude
+		uint64_t sum = 0;
+		for(size_t i = warm; i < n; ++i) sum += ZigZag(x[i] - Predict(x.data(), i, order));
+		uint8_t k = 0;
+		while(k < 31 && (static_cast<uint64_t>(n - warm) << (k + 1)) < sum) ++k;
+
+		BitWriter writer(out.subspan(rice_constants::kHeaderSize));
+		for(size_t i = 0; i < warm; ++i) {
+			if(!writer.Put(x[i], 32)) return 0;
+		}
+		for(size_t i = warm; i < n; ++i)
+		{
+			const uint32_t u = ZigZag(x[i] - Predict(x.data(), i, order));
+			const uint32_t q = u >> k;
+			const bool ok = (q < rice_constants::kEscape)
+				? writer.PutOnes(q) && writer.Put(0, 1) && writer.Put(u, k)
+				: writer.PutOnes(rice_constants::kEscape) && writer.Put(u, 32);
+			if(!ok) return 0;
+		}
+
+		if(!writer.Flush()) return 0;
+		const size_t payload = writer.Bytes();
+		out[0] = rice_constants::kMagic;
+		out[1] = order;
+		out[2] = k;
+		out[3] = static_cast<uint8_t>(n);
+		out[4] = static_cast<uint8_t>(n >> 8);
+		out[5] = static_cast<uint8_t>(payload);
+		out[6] = static_cast<uint8_t>(payload >> 8);
+		out[7] = Checksum(out);
+		return rice_constants::kHeaderSize + payload;
+	}
+
+	// Validates a block header. Returns false if `in` does not start with a block header.
+	static bool ParseHeader(std::span<const uint8_t> in, HeaderTypeDef& header)
+	{
+		if(in.size() < rice_constants::kHeaderSize) return false;
+		if(in[0] != rice_constants::kMagic || in[7] != Checksum(in)) return false;
+
+		header.order	= in[1];
+		header.k		= in[2];
+		header.count	= static_cast<uint16_t>(in[3] | (in[4] << 8));
+		header.payload	= static_cast<uint16_t>(in[5] | (in[6] << 8));
+		return header.order <= rice_constants::kMaxOrder && header.k < 32 &&
+			header.count != 0 && header.count <= rice_constants::kBlockSamples &&
+			header.payload <= rice_constants::kMaxPayload;
+	}
+
+	static DecodeResultTypeDef Decode(std::span<const uint8_t> in, std::span<uint32_t> x)
+	{
+		HeaderTypeDef header;
+		if(!ParseHeader(in, header)) return {0, 0};
+		const size_t bytes = rice_constants::kHeaderSize + header.payload;
+		if(in.size() < bytes || x.size() < header.count) return {0, 0};
+
+		BitReader reader(in.subspan(rice_constants::kHeaderSize, header.payload));
+		const size_t n = header.count;
+		const size_t warm = (header.order < n) ? header.order : n;
+		for(size_t i = 0; i < warm; ++i) {
+			if(!reader.Get(x[i], 32)) return {0, bytes};
+		}
+		for(size_t i = warm; i < n; ++i)
+		{
+			uint32_t q, u;
+			if(!reader.GetUnary(q, rice_constants::kEscape)) return {0, bytes};
+			if(q == rice_constants::kEscape) {
+				if(!reader.Get(u, 32)) return {0, bytes};
+			}
+			else {
+				uint32_t low;
+				if(!reader.Get(low, header.k)) return {0, bytes};
+				u = (q << header.k) | low;
+			}
+			x[i] = Predict(x.data(), i, header.order) + UnZigZag(u);
+		}
+		return {n, bytes};
+	}
+};
+
+
+#endif /* INC_RICE_CODEC_HPP_ */
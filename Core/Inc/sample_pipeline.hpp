@@ -0,0 +1,119 @@
+/*
+ * sample_pipeline.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef INC_SAMPLE_PIPELINE_HPP_
+#define INC_SAMPLE_PIPELINE_HPP_
+
+#include <format.hpp>
+#include <rice_codec.hpp>
+#include <spsc_queue.hpp>
+#include <calibration.hpp>
+#include <constants.hpp>
+#include <algorithm>
+#include <span>
+#include <string>
+
+// Sample processing between the SPI receive buffer and the UART: frame decoding in the
+// data-ready interrupt, and the RADC output (text lines or RICE blocks).
+// Kept HAL-free so that Host/Src/radc_replay.cpp builds this same code and replays recorded
+// captures through it. `Output` is UARTDriver on the target; it must provide
+// GetTxBuffer(), WriteTxBuffer(size_t), WriteLine(std::string_view) and Write(std::span<const uint8_t>).
+class SamplePipeline {
+public:
+	SamplePipeline() = delete;
+
+	/*----- Acquisition (interrupt context) -----*/
+	// Every frame of a completed scan, in scan order, decoded by the device's kernel (adc_device.hpp).
+	// Returns the number stored; frames that do not fit in the record are dropped.
+	template <typename Device = AdcProfile, size_t N>
+	static size_t DecodeScan(std::span<const uint8_t> scan, SPSCQueue<uint32_t, N>& record)
+	{
+		size_t stored = 0;
+		for(size_t i = 0; i + Device::kBufferSize <= scan.size(); i += Device::kBufferSize) {
+			if(record.Push(Device::Decode(scan.data() + i))) ++stored;
+		}
+		return stored;
+	}
+	// As above with the offset/gain correction of each scan position applied (CAL ON/UV).
+	// `calibration` holds one term per frame of the scan.
+	template <typename Device = AdcProfile, size_t N>
+	static size_t DecodeScan(std::span<const uint8_t> scan, SPSCQueue<uint32_t, N>& record, std::span<const Calibration::TermTypeDef> calibration)
+	{
+		size_t stored = 0;
+		const size_t count = std::min(scan.size() / Device::kBufferSize, calibration.size());
+		for(size_t i = 0; i < count; ++i)
+		{
+			const uint32_t code = Device::Decode(scan.data() + i * Device::kBufferSize);
+			if(record.Push(Calibration::Apply<Device::kResolution>(code, calibration[i]))) ++stored;
+		}
+		return stored;
+	}
+
+	/*----- Output -----*/
+	static size_t FormatSample(std::span<char> out, uint32_t data, FormatTypeDef format, uint32_t vref_uv)
+	{
+		switch(format) {
+		case FormatTypeDef::kHex:	return Format::Hex(out, data, adc_constants::kResolution);
+		case FormatTypeDef::kDec:	return Format::Dec(out, Format::SignExtend(data, adc_constants::kResolution));
+		case FormatTypeDef::kVolt:	return Format::Volt(out, data, adc_constants::kResolution, vref_uv);
+		default:					return Format::Bin(out, data, 32);
+		}
+	}
+	// One line per data-ready edge, channels separated by a space
+	template <typename Output, size_t N>
+	static void WriteRecord(SPSCQueue<uint32_t, N>& record, size_t count, size_t channel_count, FormatTypeDef format, uint32_t vref_uv)
+	{
+		const auto out = Output::GetTxBuffer();
+		size_t length = 0;
+		size_t channel = 0;
+		for(size_t remaining = count; remaining > 0;)
+		{
+			const auto samples = record.ReadSpan();
+			const size_t n = std::min(samples.size(), remaining);
+			for(const auto data : samples.first(n))
+			{
+				if(channel != 0) out[length++] = ' ';
+				length += FormatSample(out.subspan(length), data, format, vref_uv);
+				if(++channel == channel_count) {
+					Output::WriteTxBuffer(length);
+					length = 0;
+					channel = 0;
+				}
+			}
+			record.Consume(n);
+			remaining -= n;
+		}
+	}
+	// "RADC RICE <samples> <channels>" followed by binary blocks of the interleaved record (see rice_codec.hpp)
+	template <typename Output, size_t N>
+	static void WriteRecordCompressed(SPSCQueue<uint32_t, N>& record, size_t count, size_t channel_count, uint8_t order,
+		std::span<uint32_t, rice_constants::kBlockSamples> block, std::span<uint8_t, rice_constants::kMaxBlockSize> encoded)
+	{
+		Output::WriteLine("RADC RICE " + std::to_string(count) + " " + std::to_string(channel_count));
+		WriteBlocks<Output>(record, count, order, block, encoded);
+	}
+	// The blocks alone, for output that follows the capture (the task build) in several calls
+	template <typename Output, size_t N>
+	static void WriteBlocks(SPSCQueue<uint32_t, N>& record, size_t count, uint8_t order,
+		std::span<uint32_t, rice_constants::kBlockSamples> block, std::span<uint8_t, rice_constants::kMaxBlockSize> encoded)
+	{
+		for(size_t remaining = count; remaining > 0;)
+		{
+			const auto samples = record.ReadSpan();
+			const size_t n = std::min({samples.size(), remaining, block.size()});
+			std::transform(samples.begin(), samples.begin() + n, block.begin(),
+				[](uint32_t data) { return static_cast<uint32_t>(Format::SignExtend(data, adc_constants::kResolution)); });
+			record.Consume(n);
+			remaining -= n;
+
+			const size_t size = RiceCodec::Encode(std::span<const uint32_t>(block).first(n), order, encoded);
+			Output::Write(std::span<const uint8_t>(encoded).first(size));
+		}
+	}
+};
+
+
+#endif /* INC_SAMPLE_PIPELINE_HPP_ */
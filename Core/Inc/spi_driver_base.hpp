@@ -12,28 +12,98 @@ extern "C" {
 }
 #include <atomic>
 #include <array>
-#include <vector>
+#include <initializer_list>
 #include <span>
 #include <algorithm>
+#include <limits>
 #include <gpio_wrapper.hpp>
+#include <cycle_counter.hpp>
+#include <critical_section.hpp>
 
 namespace spi_constants {
 	constexpr size_t kMax = 256;
+	constexpr size_t kMaxPin = 8;
 	constexpr uint32_t kTimeOut = 1000;
+	constexpr size_t kQueueDepth = 16;
+	constexpr size_t kRxBufferCount = 2;
+	static_assert(kRxBufferCount >= 2 && kRxBufferCount <= 32);
+	constexpr uint8_t kMinWordBits = 4;
+	constexpr uint8_t kMaxWordBits = 16;
+
+	struct BaudRatePrescalerTypeDef {
+		uint16_t divider;
+		uint32_t prescaler;
+	};
+	// Fastest first
+	constexpr std::array<BaudRatePrescalerTypeDef, 8> kBaudRatePrescaler = {{
+		{2,		SPI_BAUDRATEPRESCALER_2},
+		{4,		SPI_BAUDRATEPRESCALER_4},
+		{8,		SPI_BAUDRATEPRESCALER_8},
+		{16,	SPI_BAUDRATEPRESCALER_16},
+		{32,	SPI_BAUDRATEPRESCALER_32},
+		{64,	SPI_BAUDRATEPRESCALER_64},
+		{128,	SPI_BAUDRATEPRESCALER_128},
+		{256,	SPI_BAUDRATEPRESCALER_256}
+	}};
 }
 
+// Lower value is started first. A running transfer is never preempted.
+enum class SPIPriorityTypeDef : size_t {
+	kAcquisition = 0,
+	kControl,
+	kCount
+};
+
+// One chip-select framed transfer. An empty tx span receives only (2-line receive-only mode, nothing
+// is written to the TX FIFO), an empty rx span transmits only.
+// The callback runs in interrupt context after CS has been deasserted and may be nullptr.
+// `length` counts SPI words of `word_bits`; words above 8 bits take two bytes of the spans.
+struct SPITransactionTypeDef {
+	size_t pin_index;
+	std::span<const uint8_t> tx;
+	std::span<uint8_t> rx;
+	uint16_t length;
+	void (*callback)(void*, HAL_StatusTypeDef);
+	void* context;
+	uint8_t word_bits{8};
+};
+
 class SPIDriverBase {
 private:
 	bool is_initialized_{false};
-	std::vector<GPIOWrapper> cs_pin_;
+	std::array<GPIOWrapper, spi_constants::kMaxPin> cs_pin_;
+	size_t cs_pin_count_{0};
 
 	static SPI_HandleTypeDef* hspi_;
 
-	static std::array<uint8_t, spi_constants::kMax> rx_buffer_;
+	// Receive banks. The driver fills one while the consumer may own the last completed one.
+	// A bank being filled is marked busy until its transfer completes.
+	static std::array<std::array<uint8_t, spi_constants::kMax>, spi_constants::kRxBufferCount> rx_buffer_;
+	static std::atomic<size_t> rx_ready_index_;
+	static std::atomic<uint32_t> rx_owned_;
+	static std::atomic<uint32_t> rx_busy_;
 	static std::array<uint8_t, spi_constants::kMax> tx_buffer_;
 	static uint16_t buffer_size_;
+	static uint8_t word_bits_;
 	static size_t callback_pin_index_;
 
+	// Scan list: devices read back to back by one ReadIT()/ReadWriteIT() call
+	static std::array<size_t, spi_constants::kMaxPin> scan_list_;
+	static size_t scan_length_;
+	static std::atomic<uint32_t> assert_cycle_;
+
+	// Transaction queue, one ring per priority. Accessed inside CriticalSection only.
+	struct TransactionQueueTypeDef {
+		std::array<SPITransactionTypeDef, spi_constants::kQueueDepth> entry;
+		size_t head;
+		size_t count;
+	};
+	static std::array<TransactionQueueTypeDef, static_cast<size_t>(SPIPriorityTypeDef::kCount)> queue_;
+	static SPITransactionTypeDef current_;
+	static SPIPriorityTypeDef current_priority_;
+	static bool is_busy_;
+	static bool is_aborting_;
+
 	struct AtomicInterruptStatusTypeDef {
 			std::atomic<HAL_StatusTypeDef> state;
 			std::atomic<bool> done;
@@ -42,6 +112,13 @@ private:
 	static AtomicInterruptStatusTypeDef txrx_;
 	static SPIDriverBase* active_;
 
+	// Context of the transactions of one scan: the bank they fill travels with them
+	struct ScanContextTypeDef {
+		AtomicInterruptStatusTypeDef* status;
+		size_t bank;
+	};
+	static std::array<ScanContextTypeDef, spi_constants::kRxBufferCount> scan_context_;
+
 public:
 	SPIDriverBase() = default;
 	struct InterruptStatusTypeDef {
@@ -54,8 +131,9 @@ public:
 	HAL_StatusTypeDef Deassert(size_t);
 
 	// Initializer
-	void Init(SPI_HandleTypeDef*, std::vector<GPIOWrapper>);
+	void Init(SPI_HandleTypeDef*, std::initializer_list<GPIOWrapper>);
 	static void InitBuffer();
+	static void InitReadState();
 
 	// Getter
 	static const HAL_SPI_StateTypeDef GetSPIState();
@@ -63,11 +141,28 @@ public:
 	static size_t GetCallbackPinIndex();
 	static InterruptStatusTypeDef GetReadITState();
 	static InterruptStatusTypeDef GetReadWriteITState();
+	static uint16_t GetBaudRateDivider();
+	static uint32_t GetAssertCycle();
+	static std::span<const size_t> GetScanList();
+	static std::span<const uint8_t> GetScanBuffer();
+	static size_t GetPendingCount(SPIPriorityTypeDef);
+
+	// Receive buffer ownership
+	static std::span<const uint8_t> TakeBuffer();
+	static void ReleaseBuffer(std::span<const uint8_t>);
 
 	// Setter
 	static void SetCallbackPinIndex(size_t);
 	static HAL_StatusTypeDef SetBufferSize(size_t);
+	static HAL_StatusTypeDef SetWordSize(uint8_t);
 	static HAL_StatusTypeDef SetTxBuffer(std::span<const uint8_t>);
+	static HAL_StatusTypeDef SetBaudRateDivider(uint16_t);
+	static HAL_StatusTypeDef SetScanList(std::span<const size_t>);
+
+	// Transaction
+	static HAL_StatusTypeDef Submit(const SPITransactionTypeDef&, SPIPriorityTypeDef);
+	static HAL_StatusTypeDef Transfer(size_t, std::span<const uint8_t>, std::span<uint8_t>);
+	static HAL_StatusTypeDef WriteBurst(size_t, std::span<const uint8_t>, size_t);
 
 	// I/O
 	template <uint16_t N> 	HAL_StatusTypeDef 	Write(const std::array<uint8_t, N>&, size_t);
@@ -78,9 +173,26 @@ public:
 							void				ReadWriteIT();
 
 private:
+	static void StartNext();
+	static void SetDirection(uint32_t);
+	static void SetDataSize(uint8_t);
+	static bool SelectRxBuffer(size_t&);
+	static HAL_StatusTypeDef TransferToRxBuffer(size_t, std::span<const uint8_t>);
+	static HAL_StatusTypeDef SubmitScan(bool, void (*)(void*, HAL_StatusTypeDef), AtomicInterruptStatusTypeDef&);
+	static void Complete(HAL_StatusTypeDef);
+	static void Cancel(void*);
+	static HAL_StatusTypeDef WaitFor(AtomicInterruptStatusTypeDef&);
+	static void OnScanStep(void*, HAL_StatusTypeDef);
+	static void OnBurstStep(void*, HAL_StatusTypeDef);
+	static void OnReadComplete(void*, HAL_StatusTypeDef);
+	static void OnReadWriteComplete(void*, HAL_StatusTypeDef);
+	static void OnTransferComplete(void*, HAL_StatusTypeDef);
+
 	// Interrupt Callback
+	friend void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef*);
 	friend void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef*);
 	friend void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef*);
+	friend void HAL_SPI_ErrorCallback(SPI_HandleTypeDef*);
 	virtual void RxInterruptCallback(SPI_HandleTypeDef*) = 0;
 	virtual void TxRxInterruptCallback(SPI_HandleTypeDef*) = 0;
 };
@@ -89,11 +201,8 @@ template <uint16_t N> HAL_StatusTypeDef SPIDriverBase::Write(const std::array<ui
 {
 	if(hspi_ == nullptr) return HAL_ERROR;
 	if(N == 0) return HAL_ERROR;
-	if(Assert(pin_index) != HAL_OK) return HAL_ERROR;
 
-	const auto state = HAL_SPI_Transmit(hspi_, write.data(), static_cast<uint16_t>(write.size()), spi_constants::kTimeOut);
-	Deassert(pin_index);
-	return state;
+	return Transfer(pin_index, write, {});
 }
 
 template <uint16_t N> HAL_StatusTypeDef SPIDriverBase::ReadWrite(const std::array<uint8_t, N>& write, size_t pin_index)
@@ -101,11 +210,8 @@ template <uint16_t N> HAL_StatusTypeDef SPIDriverBase::ReadWrite(const std::arra
 	if(hspi_ == nullptr) return HAL_ERROR;
 	if(N == 0) return HAL_ERROR;
 	if(SetBufferSize(write.size()) != HAL_OK) return HAL_ERROR;
-	if(Assert(pin_index) != HAL_OK) return HAL_ERROR;
 
-	const auto state = HAL_SPI_TransmitReceive(hspi_, write.data(), rx_buffer_.data(), static_cast<uint16_t>(write.size()), spi_constants::kTimeOut);
-	Deassert(pin_index);
-	return state;
+	return TransferToRxBuffer(pin_index, write);
 }
 
 #endif /* INC_SPI_DRIVER_BASE_HPP_ */
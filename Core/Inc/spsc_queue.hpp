@@ -0,0 +1,132 @@
+/*
+ * spsc_queue.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef INC_SPSC_QUEUE_HPP_
+#define INC_SPSC_QUEUE_HPP_
+
+#include <atomic>
+#include <array>
+#include <span>
+#include <algorithm>
+#include <type_traits>
+
+namespace spsc_constants {
+	constexpr size_t kCacheLine = 32;	// Cortex-M7 D-cache line size
+}
+
+// Lock-free single-producer/single-consumer ring (e.g. ISR -> main loop).
+// - N must be a power of two. Element size is arbitrary (std::array<uint8_t, 3> is fine).
+// - Indices run freely and are masked on access, so all N slots are usable.
+// - The producer publishes with a release store of head_, the consumer frees slots with a release
+//   store of tail_; each side reads the other's index with acquire. On Cortex-M7 this emits a DMB,
+//   which orders the element copy against the index update.
+// - head_ and tail_ live on separate cache lines so producer and consumer do not share one.
+template <typename T, size_t N>
+class SPSCQueue {
+	static_assert(N >= 2 && (N & (N - 1)) == 0, "SPSCQueue: N must be a power of two");
+	static_assert(std::is_trivially_copyable_v<T>, "SPSCQueue: T must be trivially copyable");
+
+private:
+	static constexpr size_t kMask = N - 1;
+
+	alignas(spsc_constants::kCacheLine) std::array<T, N> buffer_;
+	alignas(spsc_constants::kCacheLine) std::atomic<size_t> head_{0};
+	alignas(spsc_constants::kCacheLine) std::atomic<size_t> tail_{0};
+
+public:
+	SPSCQueue() = default;
+	SPSCQueue(const SPSCQueue&) = delete;
+	SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+	static constexpr size_t Capacity() { return N; }
+
+	// Both sides
+	size_t Size() const { return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire); }
+	bool Empty() const { return Size() == 0; }
+	bool Full() const { return Size() == N; }
+
+	// Only while neither side is running
+	void Clear()
+	{
+		head_.store(0, std::memory_order_relaxed);
+		tail_.store(0, std::memory_order_release);
+	}
+
+	/*----- Producer -----*/
+	bool Push(const T& value)
+	{
+		const size_t head = head_.load(std::memory_order_relaxed);
+		if(head - tail_.load(std::memory_order_acquire) == N) return false;
+
+		buffer_[head & kMask] = value;
+		head_.store(head + 1, std::memory_order_release);
+		return true;
+	}
+	// Returns the number of elements pushed
+	size_t Push(std::span<const T> values)
+	{
+		size_t pushed = 0;
+		while(pushed < values.size())
+		{
+			const auto free = WriteSpan();
+			if(free.empty()) break;
+
+			const size_t n = std::min(free.size(), values.size() - pushed);
+			std::copy_n(values.begin() + pushed, n, free.begin());
+			Commit(n);
+			pushed += n;
+		}
+		return pushed;
+	}
+	// Contiguous free slots up to the end of the ring; fill them, then Commit()
+	std::span<T> WriteSpan()
+	{
+		const size_t head = head_.load(std::memory_order_relaxed);
+		const size_t free = N - (head - tail_.load(std::memory_order_acquire));
+		const size_t index = head & kMask;
+		return std::span<T>(buffer_).subspan(index, std::min(free, N - index));
+	}
+	void Commit(size_t n) { head_.store(head_.load(std::memory_order_relaxed) + n, std::memory_order_release); }
+
+	/*----- Consumer -----*/
+	bool Pop(T& value)
+	{
+		const size_t tail = tail_.load(std::memory_order_relaxed);
+		if(head_.load(std::memory_order_acquire) == tail) return false;
+
+		value = buffer_[tail & kMask];
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+	// Returns the number of elements popped
+	size_t Pop(std::span<T> values)
+	{
+		size_t popped = 0;
+		while(popped < values.size())
+		{
+			const auto used = ReadSpan();
+			if(used.empty()) break;
+
+			const size_t n = std::min(used.size(), values.size() - popped);
+			std::copy_n(used.begin(), n, values.begin() + popped);
+			Consume(n);
+			popped += n;
+		}
+		return popped;
+	}
+	// Zero-copy view of contiguous readable elements up to the end of the ring; release with Consume()
+	std::span<const T> ReadSpan() const
+	{
+		const size_t tail = tail_.load(std::memory_order_relaxed);
+		const size_t used = head_.load(std::memory_order_acquire) - tail;
+		const size_t index = tail & kMask;
+		return std::span<const T>(buffer_).subspan(index, std::min(used, N - index));
+	}
+	void Consume(size_t n) { tail_.store(tail_.load(std::memory_order_relaxed) + n, std::memory_order_release); }
+};
+
+
+#endif /* INC_SPSC_QUEUE_HPP_ */
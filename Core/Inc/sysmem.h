@@ -0,0 +1,24 @@
+/*
+ * sysmem.h
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef INC_SYSMEM_H_
+#define INC_SYSMEM_H_
+
+#include <stdint.h>
+
+typedef struct {
+	uint32_t used;			// current heap size
+	uint32_t peak;			// heap high-water mark
+	uint32_t limit;			// heap size at which _sbrk() starts failing
+	uint32_t end;			// current heap end address
+	uint32_t call_count;	// _sbrk() calls
+	uint32_t fail_count;	// _sbrk() calls refused with ENOMEM
+} sbrk_statistics_t;
+
+void sbrk_get_statistics(sbrk_statistics_t*);
+
+
+#endif /* INC_SYSMEM_H_ */
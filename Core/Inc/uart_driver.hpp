@@ -12,12 +12,20 @@ extern "C" {
 }
 #include <atomic>
 #include <string>
+#include <memory_resource>
+#include <span>
+#include <array>
+#include <string_view>
+#include <kernel.hpp>
 
 namespace uart_constants {
 
 	constexpr uint32_t kTimeOut = 1000;
 	constexpr uint8_t kCR = '\r';
 	constexpr uint8_t kLF = '\n';
+	constexpr size_t kLineReserve = 64;
+	constexpr size_t kTxBufferSize = 320;
+	constexpr size_t kChecksumSize = 9;		// "*" and 8 hex digits in front of CR+LF
 
 }
 
@@ -26,8 +34,16 @@ private:
 	static UART_HandleTypeDef* huart_;
 	static std::atomic<bool> is_char_received_;
 	static uint8_t buffer_;
+	static std::array<std::array<char, uart_constants::kTxBufferSize>, kernel_constants::kMaxTask + 1> tx_buffer_;
+	static Mutex mutex_;
+	static bool is_checksum_;
+	static std::atomic<uint32_t> rx_cycles_;
+	static uint32_t line_start_;
+	static uint32_t line_end_;
 
 	static void ReadChar();
+	static void Transmit(const uint8_t*, size_t);
+	static void WaitTransmit();
 
 public:
 	UARTDriver() = delete;
@@ -35,9 +51,25 @@ public:
 	// Initializer
 	static void Init(UART_HandleTypeDef*);
 
-	// I/O
-	static std::string ReadLine();
-	static void WriteLine(const std::string&);
+	// I/O. Called from tasks (kernel.hpp), each task formats into a TX buffer of its own, a line or
+	// block goes out whole under a mutex, and the task sleeps while it is sent by interrupt.
+	static std::pmr::string ReadLine(std::pmr::memory_resource* = std::pmr::get_default_resource());
+	static void WriteLine(std::string_view);
+	static void Write(std::span<const uint8_t>);
+	static std::span<char> GetTxBuffer();
+	static void WriteTxBuffer(size_t);
+	static HAL_StatusTypeDef WriteIT(std::span<const uint8_t>);
+	static void Flush();
+
+	// Frame CRC (CRC-32 from CRCUnit): lines end in "*XXXXXXXX", each Write() is followed by
+	// the CRC as 4 bytes, little endian. WriteIT() is left as is.
+	static void SetChecksum(bool);
+	static bool IsChecksum();
+
+	// CycleCounter stamps of the first and the last (LF) character of the line ReadLine() returned,
+	// taken in the receive interrupt
+	static uint32_t GetLineStart();
+	static uint32_t GetLineEnd();
 
 	// Interrupt Callback
 	friend void HAL_UART_RxCpltCallback(UART_HandleTypeDef*);
@@ -8,14 +8,26 @@ extern "C" {
 #include "main.h"
 extern SPI_HandleTypeDef hspi1;
 extern UART_HandleTypeDef huart3;
+extern CRC_HandleTypeDef hcrc;
+extern TIM_HandleTypeDef htim4;
 }
 #include <constants.hpp>
 #include <application.hpp>
-#include <sstream>
+#include <irq_priority.hpp>
+#include <cycle_counter.hpp>
+#include <event.hpp>
+#include <boot_timeline.hpp>
+#include <crc_unit.hpp>
+#include <conversion_clock.hpp>
+#include <kernel.hpp>
+extern "C" {
+#include "sysmem.h"
+}
+#include <charconv>
+#include <limits>
 #include <string>
 #include <array>
 #include <algorithm>
-#include <bitset>
 
 Application app;
 
@@ -30,23 +42,58 @@ extern "C" void application_run()
 
 void Application::Init()
 {
+	IRQPriority::Apply();
+	CycleCounter::Init();
+	Event::Init();
+
 	GPIOWrapper cs0(GPIOD, GPIO_PIN_14),  cs1(GPIOF, GPIO_PIN_12);
 
 	spi_driver_.Init(&hspi1, {cs0, cs1});
 	UARTDriver::Init(&huart3);
+	CRCUnit::Init(&hcrc);
+	ConversionClock::Init(&htim4);
+	// CubeMX enables the data-ready EXTI at boot; it stays off until RADC arms it
+	StopAcquisition();
+
+	vref_uv_ = adc_constants::kVref_uV;
+
+	// Configure the ADC from the boot profile before the first command arrives
+	ProfileStore::Init();
+	BootTimeline::Mark("application");
+	if(ProfileTypeDef profile; ProfileStore::GetBoot(profile)) {
+		WriteRegisters(profile.value);
+	}
+	for(size_t i = 0; i < calibration_.size(); ++i) {
+		ProfileStore::FindCalibration(i, calibration_[i]);
+	}
+	BootTimeline::Mark("profile");
 
-	buffer_.fill(0);
+#if defined(USE_TASK_KERNEL)
+	Kernel::Create(acquisition_task_);
+	Kernel::Create(output_task_);
+	Kernel::Create(command_task_);
+#endif
 }
 
-Application::Tokens Application::InputTokenizer(std::string s)
+// The whole token has to be a decimal integer; anything else is no value
+std::optional<int64_t> Application::ToInteger(std::string_view s)
 {
-	std::stringstream	ss{s};
-	std::string			tmp;
-	Tokens				tokens;
+	int64_t value = 0;
+	const auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+	if(ec != std::errc() || end != s.data() + s.size()) return std::nullopt;
+	return value;
+}
+Application::Tokens Application::InputTokenizer(std::string_view s)
+{
+	constexpr std::string_view kDelimiter = " \t\r\n";
+	Tokens tokens(&arena_);
 
-	while(ss >> tmp)
+	size_t begin = s.find_first_not_of(kDelimiter);
+	while(begin != std::string_view::npos)
 	{
-		tokens.push_back(tmp);
+		const size_t end = s.find_first_of(kDelimiter, begin);
+		tokens.push_back(s.substr(begin, end - begin));
+		begin = s.find_first_not_of(kDelimiter, end);
 	}
 	return tokens;
 }
@@ -55,7 +102,10 @@ void Application::CommandDispatcher(const Tokens& tokens)
 	if(tokens.empty()) return;
 
 	Command command = tokens.front();
-	Args args		= Args(tokens.begin() + 1, tokens.end());
+	Args args		= Args(tokens).subspan(1);
+
+	const bool is_exclusive = std::find(app_constants::kExclusive.begin(), app_constants::kExclusive.end(), command) != app_constants::kExclusive.end();
+	if(is_exclusive) bus_.Lock();
 
 	if(command == "WREG") {
 		Wreg(args);
@@ -66,38 +116,180 @@ void Application::CommandDispatcher(const Tokens& tokens)
 	else if(command == "RADC") {
 		Radc(args);
 	}
+	else if(command == "SCLK") {
+		Sclk(args);
+	}
+	else if(command == "SWEEP") {
+		Sweep(args);
+	}
+	else if(command == "IRQTEST") {
+		Irqtest(args);
+	}
+	else if(command == "IDLE") {
+		Idle(args);
+	}
+	else if(command == "HEAP") {
+		Heap(args);
+	}
+	else if(command == "FMT") {
+		Fmt(args);
+	}
+	else if(command == "CMP") {
+		Cmp(args);
+	}
+	else if(command == "SCAN") {
+		Scan(args);
+	}
+	else if(command == "PSAVE") {
+		Psave(args);
+	}
+	else if(command == "PLOAD") {
+		Pload(args);
+	}
+	else if(command == "PBOOT") {
+		Pboot(args);
+	}
+	else if(command == "PLIST") {
+		Plist(args);
+	}
+	else if(command == "BOOT") {
+		Boot(args);
+	}
+	else if(command == "CRC") {
+		Crc(args);
+	}
+	else if(command == "STAT") {
+		Stat(args);
+	}
+	else if(command == "RATE") {
+		Rate(args);
+	}
+	else if(command == "CAL") {
+		Cal(args);
+	}
+	else if(command == "RXONLY") {
+		Rxonly(args);
+	}
+	else if(command == "RXBENCH") {
+		Rxbench(args);
+	}
+	else if(command == "LAT") {
+		Lat(args);
+	}
+	else if(command == "STATUS") {
+		Status(args);
+	}
+	else if(command == "STOP") {
+		Stop(args);
+	}
+	else if(command == "TASKS") {
+		Tasks(args);
+	}
+
+	if(is_exclusive) bus_.Unlock();
+}
+size_t Application::FormatRegister(std::span<char> out, uint64_t value) const
+{
+	switch(format_) {
+	case FormatTypeDef::kHex:	return Format::Hex(out, value, 40);
+	case FormatTypeDef::kDec:
+	case FormatTypeDef::kVolt:	return Format::Udec(out, value);
+	default:					return Format::Bin(out, value, 40);
+	}
+}
+void Application::WriteStatistics()
+{
+	UARTDriver::WriteLine(
+		"STAT EDGES " + std::to_string(acquisition_.edges.load()) +
+		" SAMPLES " + std::to_string(acquisition_.samples.load()) +
+		" BUSY " + std::to_string(acquisition_.busy.load()) +
+		" SPIERR " + std::to_string(acquisition_.spi_errors.load()) +
+		" OVERRUN " + std::to_string(acquisition_.overruns.load()));
 }
 void Application::Run()
 {
-	CommandDispatcher(InputTokenizer(UARTDriver::ReadLine()));
+#if defined(USE_TASK_KERNEL)
+	Kernel::Start();
+#else
+	ReadCommand();
+#endif
 }
-
-void Application::Wreg(const Args& args)
+void Application::ReadCommand()
 {
-	if(args.size() != 3) return;
-
-	std::array<uint64_t, 3> reg;
-	for(size_t i = 0; i < 3; ++i)
 	{
-		reg[i] = ((reg_constants::kWriteFlag | reg_constants::kRegAddr[i]) << 32) | static_cast<uint64_t>(std::stoll(args[i]));
+		const auto line = UARTDriver::ReadLine(&arena_);
+		CommandDispatcher(InputTokenizer(line));
 	}
+	arena_.Reset();
 
-	std::array<std::array<uint8_t, 8>, 3> cast;
-	for(size_t i = 0; i < 3; ++i)
+	// Receiving the line, then everything up to the last reply byte handed to the UART
+	if(is_latency_) {
+		UARTDriver::Flush();
+		const uint32_t done = CycleCounter::Now();
+		UARTDriver::WriteLine(
+			"LAT RX " + std::to_string(CycleCounter::ToMicroseconds(UARTDriver::GetLineEnd() - UARTDriver::GetLineStart())) +
+			" EXEC " + std::to_string(CycleCounter::ToMicroseconds(done - UARTDriver::GetLineEnd())));
+	}
+}
+
+HAL_StatusTypeDef Application::WriteRegister(uint8_t addr, uint32_t value)
+{
+	const std::array<uint8_t, 5> write = {
+		static_cast<uint8_t>(reg_constants::kWriteFlag | addr),
+		static_cast<uint8_t>(value >> 24),
+		static_cast<uint8_t>(value >> 16),
+		static_cast<uint8_t>(value >> 8),
+		static_cast<uint8_t>(value)
+	};
+	return SPIDriver::Transfer(cs_constants::kReg, write, {});
+}
+// Registers kRegAddr[0], kRegAddr[1], ... in one burst, one CS frame per register
+HAL_StatusTypeDef Application::WriteRegisters(std::span<const uint32_t> value)
+{
+	if(value.size() > reg_constants::kRegAddr.size()) return HAL_ERROR;
+
+	std::array<uint8_t, reg_constants::kFrameSize * reg_constants::kRegAddr.size()> frames;
+	for(size_t i = 0; i < value.size(); ++i)
 	{
-		cast.at(i) = std::bit_cast<std::array<uint8_t, 8>>(reg.at(i));
-		std::reverse(cast.at(i).begin(), cast.at(i).end());
+		const auto frame = std::span<uint8_t>(frames).subspan(i * reg_constants::kFrameSize, reg_constants::kFrameSize);
+		frame[0] = static_cast<uint8_t>(reg_constants::kWriteFlag | reg_constants::kRegAddr[i]);
+		frame[1] = static_cast<uint8_t>(value[i] >> 24);
+		frame[2] = static_cast<uint8_t>(value[i] >> 16);
+		frame[3] = static_cast<uint8_t>(value[i] >> 8);
+		frame[4] = static_cast<uint8_t>(value[i]);
 	}
+	return SPIDriver::WriteBurst(cs_constants::kReg, std::span<const uint8_t>(frames).first(value.size() * reg_constants::kFrameSize), reg_constants::kFrameSize);
+}
+HAL_StatusTypeDef Application::ReadRegister(uint8_t addr, uint32_t& value)
+{
+	std::array<uint8_t, 5> write;
+	write.fill(0);
+	write.at(0) = static_cast<uint8_t>(reg_constants::kReadFlag | addr);
+
+	std::array<uint8_t, 5> read;
+	if(const auto state = SPIDriver::Transfer(cs_constants::kReg, write, read); state != HAL_OK) return state;
+
+	value =
+		(static_cast<uint32_t>(read[1]) << 24) | (static_cast<uint32_t>(read[2]) << 16) |
+		(static_cast<uint32_t>(read[3]) << 8)  | static_cast<uint32_t>(read[4]);
+	return HAL_OK;
+}
+
+void Application::Wreg(const Args& args)
+{
+	if(args.size() != 3) return;
 
-	std::array<uint8_t, 5> tmp;
+	std::array<uint32_t, 3> value;
 	for(size_t i = 0; i < 3; ++i)
 	{
-		std::copy_n(cast.at(i).begin() + 3, 5, tmp.begin());
-		//spi_driver_.Write<5>(tmp, cs_constants::kReg);
-
-		SPIDriver::SetTxBuffer(std::vector<uint8_t>(tmp.begin(), tmp.end()));
-		spi_driver_.Write(cs_constants::kReg);
+		const auto v = ToInteger(args[i]);
+		if(!v) {
+			UARTDriver::WriteLine("WREG NG");
+			return;
+		}
+		value[i] = static_cast<uint32_t>(*v);
 	}
+	WriteRegisters(value);
 	UARTDriver::WriteLine("WREG OK");
 }
 
@@ -105,64 +297,935 @@ void Application::Rreg(const Args& args)
 {
 	if(args.size() != 1) return;
 
+	const auto addr = ToInteger(args.front());
+	if(!addr) {
+		UARTDriver::WriteLine("RREG NG");
+		return;
+	}
+
 	std::array<uint8_t, 5> write;
 	write.fill(0);
 
-	write.at(0) = static_cast<uint8_t>(reg_constants::kReadFlag) | static_cast<uint8_t>(std::stol(args.front()));
+	write.at(0) = static_cast<uint8_t>(reg_constants::kReadFlag) | static_cast<uint8_t>(*addr);
 
-	// spi_driver_.ReadWrite<5>(write, cs_constants::kReg);
-
-	SPIDriver::SetTxBuffer(std::vector<uint8_t>(write.begin(), write.end()));
-	spi_driver_.ReadWrite(cs_constants::kReg);
+	// Queued behind acquisition reads, so this also works while RADC is capturing
+	std::array<uint8_t, 5> read;
+	read.fill(0);
+	SPIDriver::Transfer(cs_constants::kReg, write, read);
 
 	uint64_t out = 0;
 	uint64_t shift = 32;
-	for(const auto& reg : SPIDriver::GetBuffer()) {
+	for(const auto& reg : read) {
 		out 	|= (static_cast<uint64_t>(reg) << shift);
 		shift 	-= 8;
 	}
 
-	UARTDriver::WriteLine(std::bitset<40>(out).to_string());
+	UARTDriver::WriteTxBuffer(FormatRegister(UARTDriver::GetTxBuffer(), out));
+}
+
+// Captures `length` scans into the record, corrected as set by CAL if `is_calibrated`.
+// Returns false (nothing captured) if they do not fit or the calibration cannot be applied.
+bool Application::Acquire(size_t length, bool is_calibrated)
+{
+	if(length > app_constants::kMax / std::max<size_t>(SPIDriver::GetScanList().size(), 1)) return false;
+	if(!StartAcquisition(length, is_calibrated)) return false;
+	while(record_.Size() < record_length_ * channel_count_) Event::Wait(event_constants::kSample);
+	return true;
+}
+// Clears the record and arms the data-ready interrupt (or the conversion timer). The record is a
+// ring: a capture longer than it has to be drained while it runs, scans that find it full are
+// counted as overruns. Returns false, with nothing changed, if the capture cannot start.
+bool Application::StartAcquisition(size_t length, bool is_calibrated)
+{
+	// One record entry per device and data-ready edge, interleaved in scan order
+	const size_t channel_count = std::max<size_t>(SPIDriver::GetScanList().size(), 1);
+	if(length > app_constants::kMaxStream / channel_count) return false;
+	term_count_ = 0;
+	if(is_calibrated && !PrepareCalibration()) return false;
+
+	SPIDriver::InitReadCount();
+	SPIDriver::InitReadState();
+	PrepareRead();
+	channel_count_ = channel_count;
+	record_length_ = length;
+	record_.Clear();
+	for(auto* counter : {&acquisition_.edges, &acquisition_.samples, &acquisition_.busy, &acquisition_.spi_errors, &acquisition_.overruns}) {
+		counter->store(0);
+	}
+	decoded_count_ = 0;
+
+	is_armed_.store(true);
+	if(ConversionClock::GetSource() == ClockSourceTypeDef::kTriggered) ConversionClock::EnableTrigger();
+	else HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+	return true;
 }
 
 void Application::Radc(const Args& args)
 {
 	if(args.size() != 1) return;
+	const auto length = ToInteger(args.front());
+	if(!length || *length < 0) {
+		UARTDriver::WriteLine("RADC NG");
+		return;
+	}
+#if defined(USE_TASK_KERNEL)
+	capture_queue_.Send({static_cast<size_t>(*length)});
+#else
+	written_count_.store(0);
+	if(!Acquire(static_cast<size_t>(*length), true)) {
+		UARTDriver::WriteLine("RADC NG");
+		return;
+	}
 
-	SPIDriver::InitReadCount();
-	SPIDriver::SetBufferSize(3);
-	SPIDriver::SetCallbackPinIndex(cs_constants::kADC);
+	if(is_compressed_) {
+		SamplePipeline::WriteRecordCompressed<UARTDriver>(record_, record_length_ * channel_count_, channel_count_, compression_order_, block_, encoded_);
+	}
+	else {
+		SamplePipeline::WriteRecord<UARTDriver>(record_, record_length_ * channel_count_, channel_count_, format_, vref_uv_);
+	}
+	written_count_.store(record_length_ * channel_count_);
+	WriteStatistics();
+#endif
+}
+
+#if defined(USE_TASK_KERNEL)
+/*----- Tasks -----*/
+void Application::AcquisitionTask(void* argument)
+{
+	auto& self = *static_cast<Application*>(argument);
+	while(true) self.Capture(self.capture_queue_.Receive());
+}
+void Application::OutputTask(void* argument)
+{
+	auto& self = *static_cast<Application*>(argument);
+	while(true) self.WriteCapture(self.output_queue_.Receive());
+}
+void Application::CommandTask(void* argument)
+{
+	auto& self = *static_cast<Application*>(argument);
+	while(true) self.ReadCommand();
+}
+
+// One RADC: the bus stays locked until the output task has written the STAT line, so the
+// record and the SPI settings are not touched by anything else meanwhile. The output task
+// drains the record as it fills, so the capture may be longer than the record.
+void Application::Capture(const CaptureRequestTypeDef& request)
+{
+	Mutex::Guard lock(bus_);
+	if(!StartAcquisition(request.length, true)) {
+		UARTDriver::WriteLine("RADC NG");
+		return;
+	}
+	is_stop_requested_.store(false);
+	written_count_.store(0);
+	capture_state_.store(CaptureStateTypeDef::kRun);
+	output_queue_.Send({record_length_ * channel_count_, channel_count_, format_, vref_uv_, is_compressed_, compression_order_});
+
+	// Armed until the edge after the last scan, which also posts kSample
+	while(is_armed_.load() && !is_stop_requested_.load()) {
+		Event::Wait(event_constants::kSample);
+	}
+	StopAcquisition();
+	capture_state_.store(CaptureStateTypeDef::kOutput);
+	Event::Post(event_constants::kSample);
+	while(capture_state_.load() != CaptureStateTypeDef::kIdle) Event::Wait(event_constants::kSample);
+}
+// Writes the record while it fills: text a whole scan at a time, RICE a full block at a time
+// (the last one may be shorter). After STOP only what was captured is written.
+void Application::WriteCapture(const CaptureTypeDef& capture)
+{
+	if(capture.is_compressed) {
+		UARTDriver::WriteLine("RADC RICE " + std::to_string(capture.count) + " " + std::to_string(capture.channel_count));
+	}
+	for(size_t remaining = capture.count; remaining > 0;)
+	{
+		// State first: whatever the record holds once the capture has ended is all there will be
+		const bool is_running = capture_state_.load() == CaptureStateTypeDef::kRun;
+		const size_t size = std::min(record_.Size(), remaining);
+		const size_t n = capture.is_compressed ?
+			std::min(size, rice_constants::kBlockSamples) : size - size % capture.channel_count;
+		const bool is_ready = capture.is_compressed ? (n == std::min(remaining, rice_constants::kBlockSamples)) : (n != 0);
+		if(!is_ready && is_running) {
+			Event::Wait(event_constants::kSample);
+			continue;
+		}
+		if(n == 0) break;
+
+		if(capture.is_compressed) {
+			SamplePipeline::WriteBlocks<UARTDriver>(record_, n, capture.order, block_, encoded_);
+		}
+		else {
+			SamplePipeline::WriteRecord<UARTDriver>(record_, n, capture.channel_count, capture.format, capture.vref_uv);
+		}
+		remaining -= n;
+		written_count_ += n;
+	}
+	// The last scan is written before the edge that ends the capture; STAT waits for that
+	while(capture_state_.load() == CaptureStateTypeDef::kRun) Event::Wait(event_constants::kSample);
+	WriteStatistics();
+	capture_state_.store(CaptureStateTypeDef::kIdle);
+	Event::Post(event_constants::kSample);
+}
+#endif
+
+void Application::Sclk(const Args& args)
+{
+	if(args.size() > 1) return;
+
+	if(args.size() == 1) {
+		const auto divider = ToInteger(args.front());
+		if(!divider || *divider < 0 || *divider > std::numeric_limits<uint16_t>::max() ||
+			SPIDriver::SetBaudRateDivider(static_cast<uint16_t>(*divider)) != HAL_OK) {
+			UARTDriver::WriteLine("SCLK NG");
+			return;
+		}
+	}
+
+	const auto divider = SPIDriver::GetBaudRateDivider();
+	if(divider == 0) {
+		UARTDriver::WriteLine("SCLK NG");
+		return;
+	}
+	UARTDriver::WriteLine("SCLK " + std::to_string(divider) + " " + std::to_string(HAL_RCC_GetPCLK2Freq() / divider));
+}
+
+void Application::Sweep(const Args& args)
+{
+	if(args.empty() || args.size() > 2) return;
+
+	const auto addr_arg = ToInteger(args.front());
+	const auto iteration_arg = (args.size() == 2) ? ToInteger(args.back()) : std::optional<int64_t>(sweep_constants::kDefaultIteration);
+	if(!addr_arg || !iteration_arg || *iteration_arg < 0) {
+		UARTDriver::WriteLine("SWEEP NG");
+		return;
+	}
+	const auto addr = static_cast<uint8_t>(*addr_arg);
+	const auto iteration = static_cast<size_t>(*iteration_arg);
+
+	// Reference values are taken at the slowest rate, so reserved bits of the register do not count as errors.
+	const auto original_divider = SPIDriver::GetBaudRateDivider();
+	const auto slowest_divider = spi_constants::kBaudRatePrescaler.back().divider;
+	SPIDriver::SetBaudRateDivider(slowest_divider);
+
+	uint32_t original_value = 0;
+	if(ReadRegister(addr, original_value) != HAL_OK) {
+		SPIDriver::SetBaudRateDivider(original_divider);
+		UARTDriver::WriteLine("SWEEP NG");
+		return;
+	}
+	std::array<uint32_t, sweep_constants::kPattern.size()> expected;
+	for(size_t i = 0; i < sweep_constants::kPattern.size(); ++i) {
+		if(WriteRegister(addr, sweep_constants::kPattern[i]) != HAL_OK || ReadRegister(addr, expected[i]) != HAL_OK) {
+			WriteRegister(addr, original_value);
+			SPIDriver::SetBaudRateDivider(original_divider);
+			UARTDriver::WriteLine("SWEEP NG");
+			return;
+		}
+	}
+
+	uint16_t fastest_divider = 0;
+	for(auto it = spi_constants::kBaudRatePrescaler.rbegin(); it != spi_constants::kBaudRatePrescaler.rend(); ++it)
+	{
+		SPIDriver::SetBaudRateDivider(it->divider);
+
+		size_t error = 0;
+		for(size_t n = 0; n < iteration && error == 0; ++n) {
+			for(size_t i = 0; i < sweep_constants::kPattern.size(); ++i) {
+				uint32_t read = 0;
+				if(WriteRegister(addr, sweep_constants::kPattern[i]) != HAL_OK ||
+					ReadRegister(addr, read) != HAL_OK || read != expected[i]) {
+					++error;
+				}
+			}
+		}
+
+		const std::string rate = std::to_string(it->divider) + " " + std::to_string(HAL_RCC_GetPCLK2Freq() / it->divider);
+		UARTDriver::WriteLine("SWEEP " + rate + (error == 0 ? " OK" : " NG"));
+		if(error != 0) break;
+		fastest_divider = it->divider;
+	}
+
+	SPIDriver::SetBaudRateDivider(slowest_divider);
+	WriteRegister(addr, original_value);
+	SPIDriver::SetBaudRateDivider(original_divider);
+
+	if(fastest_divider == 0) {
+		UARTDriver::WriteLine("SWEEP NG");
+		return;
+	}
+	UARTDriver::WriteLine("SWEEP MAX " + std::to_string(fastest_divider) + " " + std::to_string(HAL_RCC_GetPCLK2Freq() / fastest_divider));
+}
+
+void Application::Irqtest(const Args& args)
+{
+	if(args.size() > 1) return;
+	const auto iteration_arg = (args.size() == 1) ? ToInteger(args.front()) : std::optional<int64_t>(irq_test_constants::kDefaultIteration);
+	if(!iteration_arg || *iteration_arg < 0) {
+		UARTDriver::WriteLine("IRQTEST NG");
+		return;
+	}
+	const auto iteration = static_cast<size_t>(*iteration_arg);
+
+	PrepareRead();
+
+	// UART load: "IRQLOAD ....", framed like any other line (checksum included under CRC ON),
+	// so the host can tell it from the reply and skip it
+	std::array<char, irq_test_constants::kTrafficLength> traffic;
+	size_t length = traffic.size() - 2 - (UARTDriver::IsChecksum() ? uart_constants::kChecksumSize : 0);
+	traffic.fill('.');
+	std::copy(irq_test_constants::kTrafficPrefix.begin(), irq_test_constants::kTrafficPrefix.end(), traffic.begin());
+	if(UARTDriver::IsChecksum()) {
+		const uint32_t crc = CRCUnit::Calculate(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(traffic.data()), length));
+		traffic[length++] = '*';
+		length += Format::Hex(std::span<char>(traffic).subspan(length), crc, 32);
+	}
+	traffic[length++] = uart_constants::kCR;
+	traffic[length++] = uart_constants::kLF;
+
+	// Software-triggered data-ready edges on the CLKDEC line, issued at a pseudo-random
+	// phase while the UART transmits in interrupt mode.
+	uint32_t max = 0;
+	uint64_t sum = 0;
+	size_t count = 0;
+	uint32_t seed = CycleCounter::Now();
+
+	is_irq_test_.store(true);
+	HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+	for(size_t n = 0; n < iteration; ++n)
+	{
+		UARTDriver::WriteIT(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(traffic.data()), length));
+
+		seed = seed * 1'664'525 + 1'013'904'223;
+		const uint32_t phase = CycleCounter::Now();
+		while(CycleCounter::Now() - phase < seed % irq_test_constants::kMaxPhase);
+
+		SPIDriver::InitReadCount();
+		const uint32_t trigger = CycleCounter::Now();
+		EXTI->SWIER = CLKDEC_Pin;
+
+		while(SPIDriver::GetReadCount() == 0 && CycleCounter::Now() - trigger < irq_test_constants::kTimeOut);
+		if(SPIDriver::GetReadCount() == 0) continue;
+
+		// A real CLKDEC edge may have won the race against the software trigger
+		const auto latency = static_cast<int32_t>(SPIDriver::GetAssertCycle() - trigger);
+		if(latency < 0) continue;
+
+		max = std::max(max, static_cast<uint32_t>(latency));
+		sum += static_cast<uint32_t>(latency);
+		++count;
+	}
+	HAL_NVIC_DisableIRQ(EXTI15_10_IRQn);
+	is_irq_test_.store(false);
+	UARTDriver::Flush();
+
+	if(count == 0) {
+		UARTDriver::WriteLine("IRQTEST NG");
+		return;
+	}
+	UARTDriver::WriteLine(
+		"IRQTEST " + std::to_string(count) +
+		" MAX " + std::to_string(CycleCounter::ToNanoseconds(max)) +
+		" MEAN " + std::to_string(CycleCounter::ToNanoseconds(static_cast<uint32_t>(sum / count))));
+}
+
+void Application::Idle(const Args& args)
+{
+	if(args.size() > 1) return;
+	if(args.size() == 1) {
+		if(args.front() != "RESET") return;
+		Event::ResetStatistics();
+		UARTDriver::WriteLine("IDLE OK");
+		return;
+	}
+
+	const auto stat = Event::GetStatistics();
+	const uint64_t total = stat.sleep_cycles + stat.busy_cycles;
+	const uint64_t cycles_per_us = SystemCoreClock / 1'000'000;
+	const uint64_t permille = (total == 0) ? 0 : (stat.sleep_cycles * 1000) / total;
+
+	UARTDriver::WriteLine(
+		"IDLE SLEEP " + std::to_string(stat.sleep_cycles / cycles_per_us) +
+		" BUSY " + std::to_string(stat.busy_cycles / cycles_per_us) +
+		" " + std::to_string(permille / 10) + "." + std::to_string(permille % 10) + "%");
+}
+
+void Application::Heap(const Args& args)
+{
+	if(!args.empty()) return;
 
-	std::array<uint8_t, 3> write;
+	sbrk_statistics_t heap;
+	sbrk_get_statistics(&heap);
+	const auto arena = arena_.GetStatistics();
+
+	UARTDriver::WriteLine(
+		"HEAP USED " + std::to_string(heap.used) +
+		" PEAK " + std::to_string(heap.peak) +
+		" LIMIT " + std::to_string(heap.limit) +
+		" SBRK " + std::to_string(heap.call_count) +
+		" FAIL " + std::to_string(heap.fail_count) +
+		" STACK " + std::to_string(((Kernel::Current() != nullptr) ? Kernel::GetMainStack() : __get_MSP()) - heap.end));
+	UARTDriver::WriteLine(
+		"ARENA USED " + std::to_string(arena.used) +
+		" PEAK " + std::to_string(arena.peak) +
+		" SIZE " + std::to_string(arena_constants::kSize) +
+		" ALLOC " + std::to_string(arena.allocation_count) +
+		" OVERFLOW " + std::to_string(arena.overflow_count));
+}
+
+void Application::Fmt(const Args& args)
+{
+	if(args.empty() || args.size() > 2) return;
+
+	FormatTypeDef format;
+	const auto& type = args.front();
+	if(type == "BIN")		format = FormatTypeDef::kBin;
+	else if(type == "HEX")	format = FormatTypeDef::kHex;
+	else if(type == "DEC")	format = FormatTypeDef::kDec;
+	else if(type == "VOLT")	format = FormatTypeDef::kVolt;
+	else return;
+
+	if(args.size() == 2) {
+		if(format != FormatTypeDef::kVolt) return;
+		const auto vref_uv = ToInteger(args.back());
+		if(!vref_uv || *vref_uv < 0 || *vref_uv > std::numeric_limits<uint32_t>::max()) {
+			UARTDriver::WriteLine("FMT NG");
+			return;
+		}
+		vref_uv_ = static_cast<uint32_t>(*vref_uv);
+	}
+	format_ = format;
+	UARTDriver::WriteLine("FMT OK");
+}
+
+void Application::Cmp(const Args& args)
+{
+	if(args.size() != 1) return;
+
+	if(args.front() == "OFF") {
+		is_compressed_ = false;
+	}
+	else {
+		const auto order = ToInteger(args.front());
+		if(!order) {
+			UARTDriver::WriteLine("CMP NG");
+			return;
+		}
+		if(*order < 0 || *order > rice_constants::kMaxOrder) return;
+		compression_order_ = static_cast<uint8_t>(*order);
+		is_compressed_ = true;
+	}
+	UARTDriver::WriteLine("CMP OK");
+}
+
+void Application::Scan(const Args& args)
+{
+	if(args.size() > spi_constants::kMaxPin) return;
+
+	std::array<size_t, spi_constants::kMaxPin> list;
+	for(size_t i = 0; i < args.size(); ++i) {
+		const auto pin = ToInteger(args[i]);
+		if(!pin || *pin < 0) {
+			UARTDriver::WriteLine("SCAN NG");
+			return;
+		}
+		list[i] = static_cast<size_t>(*pin);
+	}
+	if(SPIDriver::SetScanList(std::span<const size_t>(list).first(args.size())) != HAL_OK) {
+		UARTDriver::WriteLine("SCAN NG");
+		return;
+	}
+	UARTDriver::WriteLine("SCAN OK");
+}
+
+// Saves the registers written by WREG, read back from the device
+void Application::Psave(const Args& args)
+{
+	if(args.size() != 1) return;
+
+	std::array<uint32_t, profile_constants::kRegisterCount> value;
+	for(size_t i = 0; i < value.size(); ++i)
+	{
+		if(ReadRegister(static_cast<uint8_t>(reg_constants::kRegAddr[i]), value[i]) != HAL_OK) {
+			UARTDriver::WriteLine("PSAVE NG");
+			return;
+		}
+	}
+	if(ProfileStore::Save(args.front(), value) != HAL_OK) {
+		UARTDriver::WriteLine("PSAVE NG");
+		return;
+	}
+	UARTDriver::WriteLine("PSAVE OK");
+}
+
+void Application::Pload(const Args& args)
+{
+	if(args.size() != 1) return;
+
+	ProfileTypeDef profile;
+	if(!ProfileStore::Find(args.front(), profile) || WriteRegisters(profile.value) != HAL_OK) {
+		UARTDriver::WriteLine("PLOAD NG");
+		return;
+	}
+	UARTDriver::WriteLine("PLOAD OK");
+}
+
+void Application::Pboot(const Args& args)
+{
+	if(args.size() != 1) return;
+
+	const auto name = (args.front() == "OFF") ? std::string_view() : args.front();
+	if(ProfileStore::SetBoot(name) != HAL_OK) {
+		UARTDriver::WriteLine("PBOOT NG");
+		return;
+	}
+	UARTDriver::WriteLine("PBOOT OK");
+}
+
+void Application::Plist(const Args& args)
+{
+	if(!args.empty()) return;
+
+	std::array<ProfileTypeDef, profile_constants::kMaxProfiles> profiles;
+	const size_t count = ProfileStore::List(profiles);
+	for(const auto& profile : std::span<const ProfileTypeDef>(profiles).first(count))
+	{
+		std::string line = "PLIST " + std::string(profile.GetName());
+		for(const auto value : profile.value) {
+			line += " " + std::to_string(value);
+		}
+		UARTDriver::WriteLine(line);
+	}
+
+	ProfileTypeDef boot;
+	const auto stat = ProfileStore::GetStatistics();
+	UARTDriver::WriteLine(
+		"PLIST BOOT " + (ProfileStore::GetBoot(boot) ? std::string(boot.GetName()) : std::string("OFF")) +
+		" USED " + std::to_string(stat.used) +
+		" SIZE " + std::to_string(stat.size));
+}
+
+// One line per boot mark: time since the previous mark and since main() entry, in microseconds
+void Application::Boot(const Args& args)
+{
+	if(!args.empty()) return;
+
+	const auto marks = BootTimeline::GetMarks();
+	uint32_t total = 0;
+	for(size_t i = 0; i < marks.size(); ++i)
+	{
+		const uint32_t delta = (i == 0) ? 0 : BootTimeline::ToMicroseconds(marks[i - 1], marks[i]);
+		total += delta;
+		UARTDriver::WriteLine(
+			"BOOT " + std::string(marks[i].name) +
+			" " + std::to_string(delta) +
+			" " + std::to_string(total));
+	}
+}
+
+// Frame CRC on every line and binary block sent afterwards, including this reply
+void Application::Crc(const Args& args)
+{
+	if(args.size() != 1) return;
+
+	if(args.front() == "ON")		UARTDriver::SetChecksum(true);
+	else if(args.front() == "OFF")	UARTDriver::SetChecksum(false);
+	else return;
+	UARTDriver::WriteLine("CRC OK");
+}
+
+// Acquisition counters of the last RADC, the same line RADC ends with
+void Application::Stat(const Args& args)
+{
+	if(!args.empty()) return;
+	WriteStatistics();
+}
+
+// Conversion clock: "RATE EXT" (CLKDEC from the board), "RATE <Hz>" (TIM4 PWM on CONVST),
+// "RATE <Hz> TRIG" (TIM4 also starts the reads); no argument reports the current setting
+void Application::Rate(const Args& args)
+{
+	if(args.size() > 2) return;
+
+	if(args.size() == 1 && args.front() == "EXT") {
+		ConversionClock::SetSource(ClockSourceTypeDef::kExternal);
+	}
+	else if(!args.empty())
+	{
+		if(args.size() == 2 && args.back() != "TRIG") return;
+		const auto source = (args.size() == 2) ? ClockSourceTypeDef::kTriggered : ClockSourceTypeDef::kTimer;
+		const auto rate = ToInteger(args.front());
+		if(!rate || *rate <= 0 || *rate > clock_constants::kMaxRate ||
+			ConversionClock::SetRate(static_cast<uint32_t>(*rate)) != HAL_OK || ConversionClock::SetSource(source) != HAL_OK) {
+			UARTDriver::WriteLine("RATE NG");
+			return;
+		}
+	}
+
+	const auto source = ConversionClock::GetSource();
+	if(source == ClockSourceTypeDef::kExternal) {
+		UARTDriver::WriteLine("RATE EXT");
+		return;
+	}
+	const uint64_t rate = ConversionClock::GetRate_mHz();
+	std::string fraction = std::to_string(rate % 1000);
+	fraction.insert(0, 3 - fraction.size(), '0');
+	UARTDriver::WriteLine(
+		std::string((source == ClockSourceTypeDef::kTriggered) ? "RATE TRIG " : "RATE PWM ") +
+		std::to_string(rate / 1000) + "." + fraction);
+}
+
+// One ADC frame per device of the scan list, clocked as the profile's SPI words (adc_device.hpp);
+// the zeros are only clocked out without RXONLY
+void Application::PrepareRead()
+{
+	std::array<uint8_t, adc_constants::kBufferSize> write;
 	write.fill(0);
 	SPIDriver::SetTxBuffer(write);
+	SPIDriver::SetWordSize(adc_constants::kWordBits);
+	SPIDriver::SetCallbackPinIndex(cs_constants::kADC);
+}
+void Application::StartRead()
+{
+	if(is_rx_only_) spi_driver_.ReadIT();
+	else spi_driver_.ReadWriteIT();
+}
+SPIDriver::InterruptStatusTypeDef Application::GetReadState() const
+{
+	return is_rx_only_ ? SPIDriver::GetReadITState() : SPIDriver::GetReadWriteITState();
+}
 
-	record_length_ = static_cast<size_t>(std::stol(args.front()));
-	if(record_length_ > app_constants::kMax) return;
+// "RXONLY ON": RADC reads the ADCs in receive-only mode, MOSI is not driven (the ADC's DIN
+// needs a pull to its idle level). "RXONLY OFF" (default) clocks zeros out in full duplex.
+void Application::Rxonly(const Args& args)
+{
+	if(args.size() != 1) return;
 
-	HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
-	while(SPIDriver::GetReadCount() < record_length_);
+	if(args.front() == "ON")		is_rx_only_ = true;
+	else if(args.front() == "OFF")	is_rx_only_ = false;
+	else return;
+	UARTDriver::WriteLine("RXONLY OK");
+}
 
-	for(size_t i = 0; i < record_length_; ++i) {
-		UARTDriver::WriteLine(std::bitset<32>(record_[i]).to_string());
+// Back-to-back scans of the scan list in both read modes, started from thread context:
+// "RXBENCH TXRX|RX <scans/s> <samples/s> CPU <%>", where CPU is the share of each scan spent
+// in interrupts (estimated from how often the idle loop could poll the completion meanwhile).
+void Application::Rxbench(const Args& args)
+{
+	if(args.size() > 1) return;
+	const auto scans_arg = (args.size() == 1) ? ToInteger(args.front()) : std::optional<int64_t>(rx_bench_constants::kDefaultScans);
+	if(!scans_arg || *scans_arg <= 0) {
+		UARTDriver::WriteLine("RXBENCH NG");
+		return;
 	}
+	const auto scans = static_cast<size_t>(*scans_arg);
+
+	PrepareRead();
+	const size_t channel_count = std::max<size_t>(SPIDriver::GetScanList().size(), 1);
+	const bool original = is_rx_only_;
+	for(const bool is_rx_only : {false, true})
+	{
+		is_rx_only_ = is_rx_only;
+
+		uint64_t cycles = 0;
+		uint64_t polls = 0;
+		bool is_ok = true;
+		for(size_t n = 0; n < scans && is_ok; ++n)
+		{
+			const uint32_t start = CycleCounter::Now();
+			StartRead();
+			uint32_t count = 0;
+			auto state = GetReadState();
+			for(; !state.done && state.state == HAL_OK; state = GetReadState()) {
+				if(CycleCounter::Now() - start >= rx_bench_constants::kTimeOut) break;
+				++count;
+			}
+			cycles += CycleCounter::Now() - start;
+			polls += count;
+			is_ok = state.done;
+		}
+		if(!is_ok) {
+			UARTDriver::WriteLine("RXBENCH NG");
+			break;
+		}
+
+		// The same poll with the bus idle
+		uint32_t idle = 0;
+		const uint32_t start = CycleCounter::Now();
+		for(size_t i = 0; i < rx_bench_constants::kCalibrationPolls; ++i) {
+			if(const auto state = GetReadState(); state.done && state.state == HAL_OK) ++idle;
+		}
+		const uint64_t poll_cycles = CycleCounter::Now() - start;
+		const uint64_t free_cycles = polls * poll_cycles / std::max<uint32_t>(idle, 1);
+		const uint64_t busy = (free_cycles >= cycles) ? 0 : 100 - free_cycles * 100 / cycles;
+
+		const uint64_t rate = static_cast<uint64_t>(scans) * SystemCoreClock / std::max<uint64_t>(cycles, 1);
+		UARTDriver::WriteLine(
+			std::string(is_rx_only ? "RXBENCH RX " : "RXBENCH TXRX ") + std::to_string(rate) + " " +
+			std::to_string(rate * channel_count) + " CPU " + std::to_string(busy));
+	}
+	is_rx_only_ = original;
 }
+// "LAT ON|OFF": with ON every reply is followed by "LAT RX <us> EXEC <us>", the time from the first
+// to the last character of the command line and from there until the reply has left the UART
+void Application::Lat(const Args& args)
+{
+	if(args.size() != 1) return;
 
-extern "C" void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
-	if(SPIDriver::GetSPIState() != HAL_SPI_STATE_READY) return;
-	if(const size_t count = SPIDriver::GetReadCount(); count == 0)
+	if(args.front() == "ON")		is_latency_ = true;
+	else if(args.front() == "OFF")	is_latency_ = false;
+	else return;
+	UARTDriver::WriteLine("LAT OK");
+}
+
+// "STATUS IDLE|RUN|OUTPUT <scans captured> <scans written> <scans requested>" of the current (or
+// last) RADC. Only the task build answers while a capture runs; STOP likewise.
+void Application::Status(const Args& args)
+{
+	if(!args.empty()) return;
+
+	constexpr std::array<std::string_view, 3> kState = {"IDLE", "RUN", "OUTPUT"};
+	const auto state = capture_state_.load();
+	const size_t channel_count = std::max<size_t>(channel_count_, 1);
+	UARTDriver::WriteLine(
+		"STATUS " + std::string(kState[static_cast<size_t>(state)]) +
+		" " + std::to_string(acquisition_.samples.load() / channel_count) +
+		" " + std::to_string(written_count_.load() / channel_count) +
+		" " + std::to_string(record_length_));
+}
+// Ends the running RADC; the scans captured so far are still written, then its STAT line
+void Application::Stop(const Args& args)
+{
+	if(!args.empty()) return;
+
+	if(capture_state_.load() != CaptureStateTypeDef::kRun) {
+		UARTDriver::WriteLine("STOP NG");
+		return;
+	}
+	StopAcquisition();
+	is_stop_requested_.store(true);
+	Event::Post(event_constants::kSample);
+	UARTDriver::WriteLine("STOP OK");
+}
+// "TASKS <name> PRI <priority> <effective priority> STACK <used> <size> SWITCH <count>" per task,
+// then "TASKS <count>" (0 in the superloop build)
+void Application::Tasks(const Args& args)
+{
+	if(!args.empty()) return;
+
+	const auto tasks = Kernel::GetTasks();
+	for(const auto* task : tasks)
 	{
-		app.spi_driver_.ReadWriteIT();
+		UARTDriver::WriteLine(
+			"TASKS " + std::string(task->GetName()) +
+			" PRI " + std::to_string(task->GetPriority()) +
+			" " + std::to_string(task->GetEffectivePriority()) +
+			" STACK " + std::to_string(task->GetStackUsed()) +
+			" " + std::to_string(task->GetStackSize()) +
+			" SWITCH " + std::to_string(task->GetSwitchCount()));
 	}
-	else if(count != 0 && (count - 1) < app.record_length_) {
-		std::copy(SPIDriver::GetBuffer().begin(), SPIDriver::GetBuffer().end(), app.buffer_.begin());
-		const auto data =
-			(static_cast<uint32_t>(app.buffer_[0]) << 16) |
-			(static_cast<uint32_t>(app.buffer_[1]) << 8)	| static_cast<uint32_t>(app.buffer_[2]);
-		app.record_.at(count - 1) = data;
-		app.spi_driver_.ReadWriteIT();
+	UARTDriver::WriteLine("TASKS " + std::to_string(tasks.size()));
+}
+
+// Offset/gain correction:
+// "CAL ON|UV|OFF"			corrected codes, corrected microvolts (full scale = FMT vref) or raw codes in RADC
+// "CAL ZERO [scans]"		offset of every scanned ADC from a capture with the inputs shorted
+// "CAL REF <uV> [scans]"	gain from a capture with `uV` applied, after CAL ZERO
+// "CAL SAVE"				keeps the coefficients of the scanned ADCs in flash; they are loaded at boot
+// No argument reports "CAL <cs> <offset> <gain Q2.30>" per scanned ADC and the mode.
+void Application::Cal(const Args& args)
+{
+	const auto scan_count = std::max<size_t>(SPIDriver::GetScanList().size(), 1);
+	if(args.empty())
+	{
+		for(size_t i = 0; i < scan_count; ++i)
+		{
+			const size_t device = GetScanDevice(i);
+			UARTDriver::WriteLine("CAL " + std::to_string(device) + " " +
+				std::to_string(calibration_[device].offset) + " " + std::to_string(calibration_[device].gain));
+		}
+		constexpr std::array<std::string_view, 3> kMode = {"OFF", "ON", "UV"};
+		UARTDriver::WriteLine("CAL " + std::string(kMode[static_cast<size_t>(calibration_mode_)]));
+		return;
 	}
-	else {
-		HAL_NVIC_DisableIRQ(EXTI15_10_IRQn);
+
+	const auto sub = args.front();
+	if(args.size() == 1 && (sub == "ON" || sub == "UV" || sub == "OFF"))
+	{
+		const auto previous = calibration_mode_;
+		calibration_mode_ = (sub == "ON") ? CalibrationModeTypeDef::kOn :
+			(sub == "UV") ? CalibrationModeTypeDef::kMicrovolt : CalibrationModeTypeDef::kOff;
+		if(!PrepareCalibration()) {
+			calibration_mode_ = previous;
+			UARTDriver::WriteLine("CAL NG");
+			return;
+		}
+		UARTDriver::WriteLine("CAL OK");
+	}
+	else if(sub == "ZERO" && args.size() <= 2)
+	{
+		const auto scans = (args.size() == 2) ? ToInteger(args[1]) : std::optional<int64_t>(calibration_constants::kDefaultScans);
+		std::array<int32_t, spi_constants::kMaxPin> mean;
+		if(!scans || *scans < 0 || !MeasureMean(static_cast<size_t>(*scans), mean)) {
+			UARTDriver::WriteLine("CAL NG");
+			return;
+		}
+		for(size_t i = 0; i < scan_count; ++i) {
+			calibration_[GetScanDevice(i)].offset = mean[i];
+		}
+		UARTDriver::WriteLine("CAL ZERO OK");
+	}
+	else if(sub == "REF" && (args.size() == 2 || args.size() == 3))
+	{
+		const auto uv_arg = ToInteger(args[1]);
+		const auto scans = (args.size() == 3) ? ToInteger(args[2]) : std::optional<int64_t>(calibration_constants::kDefaultScans);
+		std::array<int32_t, spi_constants::kMaxPin> mean;
+		if(!uv_arg || *uv_arg <= 0 || *uv_arg >= vref_uv_ || !scans || *scans < 0 ||
+			!MeasureMean(static_cast<size_t>(*scans), mean)) {
+			UARTDriver::WriteLine("CAL NG");
+			return;
+		}
+		const int64_t uv = *uv_arg;
+		// The code an ideal ADC gives for `uv`, over what this one gives after the offset
+		const int64_t expected = (uv << (adc_constants::kResolution - 1)) / vref_uv_;
+		std::array<int32_t, spi_constants::kMaxPin> gain;
+		for(size_t i = 0; i < scan_count; ++i)
+		{
+			const int64_t measured = static_cast<int64_t>(mean[i]) - calibration_[GetScanDevice(i)].offset;
+			const int64_t g = (measured <= 0) ? 0 : ((expected << calibration_constants::kGainFraction) + measured / 2) / measured;
+			if(g <= 0 || g >= INT32_MAX) {
+				UARTDriver::WriteLine("CAL NG");
+				return;
+			}
+			gain[i] = static_cast<int32_t>(g);
+		}
+		for(size_t i = 0; i < scan_count; ++i) {
+			calibration_[GetScanDevice(i)].gain = gain[i];
+		}
+		UARTDriver::WriteLine("CAL REF OK");
+	}
+	else if(sub == "SAVE" && args.size() == 1)
+	{
+		for(size_t i = 0; i < scan_count; ++i)
+		{
+			const size_t device = GetScanDevice(i);
+			if(ProfileStore::SaveCalibration(device, calibration_[device]) != HAL_OK) {
+				UARTDriver::WriteLine("CAL NG");
+				return;
+			}
+		}
+		UARTDriver::WriteLine("CAL SAVE OK");
+	}
+}
+// CS index of a scan position; without a scan list RADC reads the ADC alone
+size_t Application::GetScanDevice(size_t position)
+{
+	const auto list = SPIDriver::GetScanList();
+	return list.empty() ? cs_constants::kADC : list[position];
+}
+// Terms of the current scan list for the mode; none when it is off
+bool Application::PrepareCalibration()
+{
+	term_count_ = 0;
+	if(calibration_mode_ == CalibrationModeTypeDef::kOff) return true;
+
+	const auto scan_count = std::max<size_t>(SPIDriver::GetScanList().size(), 1);
+	const uint32_t vref_uv = (calibration_mode_ == CalibrationModeTypeDef::kMicrovolt) ? vref_uv_ : 0;
+	for(size_t i = 0; i < scan_count; ++i) {
+		if(!Calibration::Prepare<adc_constants::kResolution>(calibration_[GetScanDevice(i)], vref_uv, terms_[i])) return false;
+	}
+	term_count_ = scan_count;
+	return true;
+}
+// Mean raw code of every scan position over `scans` scans
+bool Application::MeasureMean(size_t scans, std::span<int32_t> mean)
+{
+	if(scans < calibration_constants::kMinScans || !Acquire(scans, false)) return false;
+
+	std::array<int64_t, spi_constants::kMaxPin> sum = {};
+	size_t channel = 0;
+	for(size_t remaining = record_length_ * channel_count_; remaining > 0;)
+	{
+		const auto samples = record_.ReadSpan();
+		const size_t n = std::min(samples.size(), remaining);
+		for(const auto data : samples.first(n))
+		{
+			sum[channel] += Format::SignExtend(data, adc_constants::kResolution);
+			if(++channel == channel_count_) channel = 0;
+		}
+		record_.Consume(n);
+		remaining -= n;
+	}
+	for(size_t i = 0; i < channel_count_; ++i)
+	{
+		const int64_t n = static_cast<int64_t>(scans);
+		mean[i] = static_cast<int32_t>((sum[i] >= 0) ? (sum[i] + n / 2) / n : (sum[i] - n / 2) / n);
+	}
+	return true;
+}
+
+// One scan per data-ready edge (or timer period): decode the scan read at the previous one
+// and start the next read
+void Application::OnDataReady()
+{
+	if(!is_armed_.load()) return;
+	const size_t count = SPIDriver::GetReadCount();
+	if(count > record_length_)
+	{
+		StopAcquisition();
+		Event::Post(event_constants::kSample);
+		return;
+	}
+	++acquisition_.edges;
+
+	// The previous read may still wait behind a register transfer; skip this edge then
+	if(SPIDriver::GetPendingCount(SPIPriorityTypeDef::kAcquisition) != 0)
+	{
+		++acquisition_.busy;
+		return;
 	}
+	// A read that failed to start or complete never counts; its bank still holds an older scan
+	if(const auto previous = GetReadState(); !previous.done && previous.state != HAL_OK)
+	{
+		if(previous.state == HAL_BUSY) ++acquisition_.overruns;
+		else ++acquisition_.spi_errors;
+	}
+	if(count == decoded_count_)
+	{
+		StartRead();
+		return;
+	}
+	decoded_count_ = count;
+
+	// Take the completed scan first so the next read goes to the other bank and
+	// runs on the bus while this one is decoded.
+	const auto scan = SPIDriver::TakeBuffer();
+	StartRead();
+
+	const size_t stored = (term_count_ != 0) ?
+		SamplePipeline::DecodeScan(scan, record_, std::span<const Calibration::TermTypeDef>(terms_).first(term_count_)) :
+		SamplePipeline::DecodeScan(scan, record_);
+	SPIDriver::ReleaseBuffer(scan);
+	acquisition_.samples += stored;
+	if(stored * adc_constants::kBufferSize < scan.size()) ++acquisition_.overruns;
+	Event::Post(event_constants::kSample);
+}
+void Application::StopAcquisition()
+{
+	is_armed_.store(false);
+	HAL_NVIC_DisableIRQ(EXTI15_10_IRQn);
+	ConversionClock::DisableTrigger();
+}
+
+extern "C" void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
+	if(app.is_irq_test_.load())
+	{
+		if(SPIDriver::GetPendingCount(SPIPriorityTypeDef::kAcquisition) != 0) return;
+		if(SPIDriver::GetReadCount() == 0) app.StartRead();
+		return;
+	}
+	app.OnDataReady();
+}
+extern "C" void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef* htim) {
+	if(htim != &htim4) return;
+	app.OnDataReady();
 }
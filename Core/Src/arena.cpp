@@ -0,0 +1,29 @@
+/*
+ * arena.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#include <arena.hpp>
+#include <algorithm>
+
+void* ArenaResource::do_allocate(size_t bytes, size_t alignment)
+{
+	++allocation_count_;
+
+	const size_t begin = (offset_ + alignment - 1) & ~(alignment - 1);
+	if(begin + bytes > buffer_.size())
+	{
+		++overflow_count_;
+		return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	}
+
+	offset_ = begin + bytes;
+	peak_ = std::max(peak_, offset_);
+	return buffer_.data() + begin;
+}
+void ArenaResource::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+	const auto* byte = static_cast<std::byte*>(p);
+	if(byte >= buffer_.data() && byte < buffer_.data() + buffer_.size()) return;
+	std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
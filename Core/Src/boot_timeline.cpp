@@ -0,0 +1,31 @@
+/*
+ * boot_timeline.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#include <boot_timeline.hpp>
+#include <cycle_counter.hpp>
+
+/*----- Variables -----*/
+std::array<BootTimeline::MarkTypeDef, boot_constants::kMaxMarks> BootTimeline::mark_ = {};
+size_t BootTimeline::count_ = 0;
+
+
+/*----- Timeline -----*/
+void BootTimeline::Mark(const char* name)
+{
+	if(count_ == 0) CycleCounter::Init();
+	if(count_ >= mark_.size()) return;
+	mark_[count_++] = {name, CycleCounter::Now(), SystemCoreClock};
+}
+std::span<const BootTimeline::MarkTypeDef> BootTimeline::GetMarks() { return std::span<const MarkTypeDef>(mark_).first(count_); }
+uint32_t BootTimeline::ToMicroseconds(const MarkTypeDef& from, const MarkTypeDef& to)
+{
+	if(from.clock_hz == 0) return 0;
+	return static_cast<uint32_t>((static_cast<uint64_t>(to.cycle - from.cycle) * 1'000'000) / from.clock_hz);
+}
+
+extern "C" void boot_timeline_mark(const char* name)
+{
+	BootTimeline::Mark(name);
+}
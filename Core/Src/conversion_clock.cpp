@@ -0,0 +1,86 @@
+/*
+ * conversion_clock.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#include <conversion_clock.hpp>
+
+/*----- Variables -----*/
+TIM_HandleTypeDef* ConversionClock::htim_ = nullptr;
+ClockSourceTypeDef ConversionClock::source_ = ClockSourceTypeDef::kExternal;
+
+
+/*----- Private Functions -----*/
+// APB1 timers run at twice PCLK1 whenever the APB1 prescaler is not 1
+uint32_t ConversionClock::GetTimerClock()
+{
+	RCC_ClkInitTypeDef clock;
+	uint32_t latency;
+	HAL_RCC_GetClockConfig(&clock, &latency);
+	return HAL_RCC_GetPCLK1Freq() * ((clock.APB1CLKDivider == RCC_HCLK_DIV1) ? 1 : 2);
+}
+
+
+/*----- Initializer -----*/
+void ConversionClock::Init(TIM_HandleTypeDef* htim) { htim_ = htim; }
+
+
+/*----- Setter -----*/
+// Nearest rate the timer can make: the smallest prescaler that lets the period fit in 16 bits,
+// then the rounded period. The duty stays at 50 %, so CONVST also works as a clock input.
+HAL_StatusTypeDef ConversionClock::SetRate(uint32_t rate)
+{
+	if(htim_ == nullptr) return HAL_ERROR;
+	if(rate < clock_constants::kMinRate || rate > clock_constants::kMaxRate) return HAL_ERROR;
+
+	const uint64_t ticks = (static_cast<uint64_t>(GetTimerClock()) + rate / 2) / rate;
+	const uint64_t prescaler = (ticks + clock_constants::kMaxCount - 1) / clock_constants::kMaxCount;
+	const uint64_t period = (ticks + prescaler / 2) / prescaler;
+	if(prescaler > clock_constants::kMaxCount || period < 2 || period > clock_constants::kMaxCount) return HAL_ERROR;
+
+	__HAL_TIM_SET_PRESCALER(htim_, static_cast<uint32_t>(prescaler - 1));
+	__HAL_TIM_SET_AUTORELOAD(htim_, static_cast<uint32_t>(period - 1));
+	__HAL_TIM_SET_COMPARE(htim_, TIM_CHANNEL_1, static_cast<uint32_t>(period / 2));
+	// Load PSC now instead of at the next update; the flag UG sets must not count as a trigger
+	htim_->Instance->EGR = TIM_EGR_UG;
+	__HAL_TIM_CLEAR_FLAG(htim_, TIM_FLAG_UPDATE);
+	return HAL_OK;
+}
+HAL_StatusTypeDef ConversionClock::SetSource(ClockSourceTypeDef source)
+{
+	if(htim_ == nullptr) return HAL_ERROR;
+
+	DisableTrigger();
+	if(source == ClockSourceTypeDef::kExternal) {
+		HAL_TIM_PWM_Stop(htim_, TIM_CHANNEL_1);
+	}
+	else if(source_ == ClockSourceTypeDef::kExternal) {
+		if(const auto state = HAL_TIM_PWM_Start(htim_, TIM_CHANNEL_1); state != HAL_OK) return state;
+	}
+	source_ = source;
+	return HAL_OK;
+}
+
+
+/*----- Getter -----*/
+uint64_t ConversionClock::GetRate_mHz()
+{
+	if(htim_ == nullptr || source_ == ClockSourceTypeDef::kExternal) return 0;
+	const uint64_t ticks = static_cast<uint64_t>(htim_->Instance->PSC + 1) * (htim_->Instance->ARR + 1);
+	return (static_cast<uint64_t>(GetTimerClock()) * 1000 + ticks / 2) / ticks;
+}
+ClockSourceTypeDef ConversionClock::GetSource() { return source_; }
+
+
+/*----- Acquisition -----*/
+void ConversionClock::EnableTrigger()
+{
+	if(htim_ == nullptr || source_ != ClockSourceTypeDef::kTriggered) return;
+	__HAL_TIM_CLEAR_FLAG(htim_, TIM_FLAG_UPDATE);
+	__HAL_TIM_ENABLE_IT(htim_, TIM_IT_UPDATE);
+}
+void ConversionClock::DisableTrigger()
+{
+	if(htim_ == nullptr) return;
+	__HAL_TIM_DISABLE_IT(htim_, TIM_IT_UPDATE);
+}
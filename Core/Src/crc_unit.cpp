@@ -0,0 +1,39 @@
+/*
+ * crc_unit.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#include <crc_unit.hpp>
+#include <cstring>
+
+/*----- Variables -----*/
+CRC_HandleTypeDef* CRCUnit::hcrc_ = nullptr;
+
+
+/*----- Initializer -----*/
+void CRCUnit::Init(CRC_HandleTypeDef* hcrc) { hcrc_ = hcrc; }
+
+
+/*----- Calculation -----*/
+void CRCUnit::Reset() { __HAL_CRC_DR_RESET(hcrc_); }
+// Same feed order as HAL_CRC_Accumulate() with CRC_INPUTDATA_FORMAT_BYTES, without the handle locking
+void CRCUnit::Accumulate(std::span<const uint8_t> data)
+{
+	size_t i = 0;
+	for(; i + sizeof(uint32_t) <= data.size(); i += sizeof(uint32_t))
+	{
+		uint32_t word;
+		std::memcpy(&word, data.data() + i, sizeof(word));
+		hcrc_->Instance->DR = __REV(word);
+	}
+	for(; i < data.size(); ++i) {
+		*reinterpret_cast<__IO uint8_t*>(&hcrc_->Instance->DR) = data[i];
+	}
+}
+uint32_t CRCUnit::Get() { return ~hcrc_->Instance->DR; }
+uint32_t CRCUnit::Calculate(std::span<const uint8_t> data)
+{
+	Reset();
+	Accumulate(data);
+	return Get();
+}
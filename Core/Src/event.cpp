@@ -0,0 +1,91 @@
+/*
+ * event.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#include <event.hpp>
+#include <kernel.hpp>
+
+/*----- Variables -----*/
+std::atomic<uint32_t> Event::pending_{0};
+uint64_t Event::sleep_cycles_ = 0;
+uint64_t Event::busy_cycles_ = 0;
+uint32_t Event::wake_stamp_ = 0;
+
+
+/*----- Private Functions -----*/
+uint32_t Event::Timestamp()
+{
+	// HCLK cycles since boot, modulo 2^32. Must be called with interrupts enabled
+	// so that uwTick is consistent with the SysTick reload.
+	uint32_t tick, val;
+	do {
+		tick = HAL_GetTick();
+		val = SysTick->VAL;
+	} while(tick != HAL_GetTick());
+
+	const uint32_t load = SysTick->LOAD;
+	return tick * (load + 1) + (load - val);
+}
+
+
+/*----- Initializer -----*/
+void Event::Init()
+{
+	pending_.store(0);
+	ResetStatistics();
+}
+
+
+/*----- Event -----*/
+void Event::Post(uint32_t event) { pending_.fetch_or(Kernel::Notify(event) ? (event | event_constants::kReady) : event); }
+uint32_t Event::Wait(uint32_t mask, uint32_t timeout)
+{
+	if(Kernel::Current() != nullptr) return Kernel::Wait(mask, timeout);
+
+	const uint32_t begin = HAL_GetTick();
+	busy_cycles_ += Timestamp() - wake_stamp_;
+	while(true)
+	{
+		const uint32_t start = Timestamp();
+
+		// Check and sleep with PRIMASK set: a pending interrupt still wakes WFI,
+		// and its handler runs right after __enable_irq(), so no event is lost in between.
+		__disable_irq();
+		if(const uint32_t event = pending_.load() & mask; event != 0)
+		{
+			pending_.fetch_and(~event);
+			__enable_irq();
+			wake_stamp_ = Timestamp();
+			return event;
+		}
+		if(timeout != event_constants::kForever && HAL_GetTick() - begin >= timeout)
+		{
+			__enable_irq();
+			wake_stamp_ = Timestamp();
+			return 0;
+		}
+		__DSB();
+		__WFI();
+		__enable_irq();
+
+		wake_stamp_ = Timestamp();
+		sleep_cycles_ += wake_stamp_ - start;
+	}
+}
+
+
+/*----- Statistics -----*/
+Event::StatisticsTypeDef Event::GetStatistics()
+{
+	const uint32_t now = Timestamp();
+	busy_cycles_ += now - wake_stamp_;
+	wake_stamp_ = now;
+	return {sleep_cycles_, busy_cycles_};
+}
+void Event::ResetStatistics()
+{
+	sleep_cycles_ = 0;
+	busy_cycles_ = 0;
+	wake_stamp_ = Timestamp();
+}
@@ -0,0 +1,260 @@
+/*
+ * kernel.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#include <kernel.hpp>
+#include <critical_section.hpp>
+#include <algorithm>
+
+/*----- Variables -----*/
+std::array<Task*, kernel_constants::kMaxTask> Kernel::task_ = {};
+size_t Kernel::task_count_ = 0;
+Task* Kernel::current_ = nullptr;
+size_t Kernel::last_index_ = 0;
+uint32_t Kernel::main_stack_ = 0;
+
+
+/*----- Task -----*/
+size_t Task::GetStackUsed() const
+{
+	// The stack grows down from the end of the span
+	const auto untouched = std::find_if(stack_.begin(), stack_.end(), [](uint32_t word) { return word != kernel_constants::kStackFill; });
+	return static_cast<size_t>(stack_.end() - untouched) * sizeof(uint32_t);
+}
+
+
+/*----- Private Functions -----*/
+// First code of every task; a task whose function returns waits forever
+void Kernel::Entry()
+{
+	current_->entry_(current_->argument_);
+	while(true) Wait(0, event_constants::kForever);
+}
+bool Kernel::IsExpired(const Task& task)
+{
+	return task.wait_timeout_ != event_constants::kForever && HAL_GetTick() - task.wait_start_ >= task.wait_timeout_;
+}
+// Highest effective priority among the ready tasks, round robin from the last one that ran.
+// A task whose timeout has passed is ready again.
+Task* Kernel::Pick()
+{
+	CriticalSection lock;
+	Task* next = nullptr;
+	size_t next_index = 0;
+	for(size_t k = 1; k <= task_count_; ++k)
+	{
+		const size_t i = (last_index_ + k) % task_count_;
+		Task* task = task_[i];
+		if(task->is_waiting_ && IsExpired(*task)) task->is_waiting_ = false;
+		if(task->is_waiting_) continue;
+		if(next == nullptr || task->effective_priority_ > next->effective_priority_) {
+			next = task;
+			next_index = i;
+		}
+	}
+	if(next != nullptr) last_index_ = next_index;
+	return next;
+}
+// Back to the scheduler; returns when the current task is picked again
+void Kernel::Switch()
+{
+	kernel_port_switch(current_->slot_, 0);
+}
+
+
+/*----- Initializer -----*/
+HAL_StatusTypeDef Kernel::Create(Task& task)
+{
+	if(task_count_ == task_.size()) return HAL_ERROR;
+	if(task.priority_ > kernel_constants::kMaxPriority || task.stack_.empty()) return HAL_ERROR;
+
+	std::fill(task.stack_.begin(), task.stack_.end(), kernel_constants::kStackFill);
+	task.slot_ = task_count_ + 1;
+	task.effective_priority_ = task.priority_;
+	kernel_port_prepare(task.slot_, task.stack_, Entry);
+	task_[task_count_++] = &task;
+	return HAL_OK;
+}
+void Kernel::Start()
+{
+	main_stack_ = __get_MSP();
+	while(true)
+	{
+		Task* next = (task_count_ == 0) ? nullptr : Pick();
+		if(next == nullptr) {
+			const bool is_timed = std::any_of(task_.begin(), task_.begin() + task_count_,
+				[](const Task* task) { return task->wait_timeout_ != event_constants::kForever; });
+			Event::Wait(event_constants::kReady, is_timed ? 1 : event_constants::kForever);
+			continue;
+		}
+		current_ = next;
+		++next->switch_count_;
+		kernel_port_switch(0, next->slot_);
+		current_ = nullptr;
+	}
+}
+
+
+/*----- Getter -----*/
+Task* Kernel::Current() { return current_; }
+size_t Kernel::CurrentSlot() { return (current_ == nullptr) ? 0 : current_->slot_; }
+std::span<Task* const> Kernel::GetTasks() { return std::span<Task* const>(task_).first(task_count_); }
+uint32_t Kernel::GetMainStack() { return main_stack_; }
+
+
+/*----- Task context -----*/
+uint32_t Kernel::Wait(uint32_t mask, uint32_t timeout)
+{
+	Task& task = *current_;
+	task.wait_start_ = HAL_GetTick();
+	task.wait_timeout_ = timeout;
+	while(true)
+	{
+		{
+			CriticalSection lock;
+			if(const uint32_t event = task.events_ & mask; event != 0)
+			{
+				task.events_ &= ~event;
+				task.wait_timeout_ = event_constants::kForever;
+				return event;
+			}
+			if(IsExpired(task))
+			{
+				task.wait_timeout_ = event_constants::kForever;
+				return 0;
+			}
+			task.wait_mask_ = mask;
+			task.is_waiting_ = true;
+		}
+		Switch();
+	}
+}
+void Kernel::Yield()
+{
+	if(current_ == nullptr) return;
+	bool is_preempted = false;
+	{
+		CriticalSection lock;
+		for(const auto* task : GetTasks())
+		{
+			if(!task->is_waiting_ && task->effective_priority_ > current_->effective_priority_) is_preempted = true;
+		}
+	}
+	if(is_preempted) Switch();
+}
+
+
+/*----- Event -----*/
+// Every task sees every event; one that waits for it becomes ready
+bool Kernel::Notify(uint32_t event)
+{
+	CriticalSection lock;
+	bool is_ready = false;
+	for(auto* task : std::span<Task* const>(task_).first(task_count_))
+	{
+		task->events_ |= event;
+		if(task->is_waiting_ && (task->wait_mask_ & event) != 0)
+		{
+			task->is_waiting_ = false;
+			is_ready = true;
+		}
+	}
+	return is_ready;
+}
+
+
+/*----- Mutex -----*/
+void Mutex::Lock()
+{
+	Task* task = Kernel::Current();
+	if(task == nullptr) return;
+
+	while(owner_ != nullptr && owner_ != task)
+	{
+		// Lend the priority down the chain of owners
+		task->waiting_for_ = this;
+		for(Task* owner = owner_; owner != nullptr && owner->effective_priority_ < task->effective_priority_;)
+		{
+			owner->effective_priority_ = task->effective_priority_;
+			owner = (owner->waiting_for_ == nullptr) ? nullptr : owner->waiting_for_->owner_;
+		}
+		Event::Wait(event_constants::kWake);
+	}
+	task->waiting_for_ = nullptr;
+	owner_ = task;
+}
+void Mutex::Unlock()
+{
+	Task* task = Kernel::Current();
+	if(task == nullptr || owner_ != task) return;
+
+	owner_ = nullptr;
+	Restore(*task);
+	Event::Post(event_constants::kWake);
+	Kernel::Yield();
+}
+// Own priority, or the highest of the tasks still waiting for a mutex it owns
+void Mutex::Restore(Task& task)
+{
+	uint8_t priority = task.priority_;
+	for(const auto* waiter : Kernel::GetTasks())
+	{
+		if(waiter->waiting_for_ != nullptr && waiter->waiting_for_->owner_ == &task) {
+			priority = std::max(priority, waiter->effective_priority_);
+		}
+	}
+	task.effective_priority_ = priority;
+}
+
+
+/*----- Port: Cortex-M7 -----*/
+#if defined(__arm__)
+namespace {
+
+	// Callee-saved registers as kernel_port_swap() pushes them: s16-s31 (FPU builds), then
+	// r3-r11 and the return address. r3 only keeps the frame a multiple of 8 bytes.
+#if defined(__VFP_FP__) && !defined(__SOFTFP__)
+	constexpr size_t kFrameWords = 16 + 10;
+#else
+	constexpr size_t kFrameWords = 10;
+#endif
+
+	std::array<uint32_t*, kernel_constants::kMaxTask + 1> stack_pointer = {};
+
+}
+
+// Saves the callee-saved registers on the current stack and its pointer to *save, then
+// continues on `load` where the same frame was saved. Thread mode only; an interrupt taken
+// in between stacks below whichever pointer is current and leaves both frames alone.
+extern "C" __attribute__((naked)) void kernel_port_swap(uint32_t** save, uint32_t* load)
+{
+	__asm volatile(
+		"push	{r3-r11, lr}	\n"
+#if defined(__VFP_FP__) && !defined(__SOFTFP__)
+		"vpush	{s16-s31}		\n"
+#endif
+		"str	sp, [r0]		\n"
+		"mov	sp, r1			\n"
+#if defined(__VFP_FP__) && !defined(__SOFTFP__)
+		"vpop	{s16-s31}		\n"
+#endif
+		"pop	{r3-r11, pc}	\n"
+	);
+}
+
+// A saved frame at the top of the stack whose return address is the entry
+void kernel_port_prepare(size_t slot, std::span<uint32_t> stack, void (*entry)())
+{
+	uint32_t* top = stack.data() + stack.size();
+	top = reinterpret_cast<uint32_t*>(reinterpret_cast<uintptr_t>(top) & ~uintptr_t{7});
+	uint32_t* frame = top - kFrameWords;
+	std::fill(frame, top, 0);
+	frame[kFrameWords - 1] = reinterpret_cast<uint32_t>(entry);
+	stack_pointer[slot] = frame;
+}
+void kernel_port_switch(size_t from, size_t to)
+{
+	kernel_port_swap(&stack_pointer[from], stack_pointer[to]);
+}
+#endif
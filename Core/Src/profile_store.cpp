@@ -0,0 +1,241 @@
+/*
+ * profile_store.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+#include <profile_store.hpp>
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cstddef>
+#include <cstring>
+
+/*----- Variables -----*/
+uint32_t ProfileStore::end_ = 0;
+std::array<ProfileTypeDef, profile_constants::kMaxProfiles> ProfileStore::profiles_ = {};
+size_t ProfileStore::profile_count_ = 0;
+ProfileStore::RecordTypeDef ProfileStore::boot_ = {};
+std::array<ProfileStore::RecordTypeDef, profile_constants::kMaxDevices> ProfileStore::calibrations_ = {};
+
+
+/*----- Profile -----*/
+std::string_view ProfileTypeDef::GetName() const
+{
+	return std::string_view(name.data(), std::find(name.begin(), name.end(), '\0') - name.begin());
+}
+
+
+/*----- Private Functions -----*/
+// CRC-32 (IEEE 802.3, reflected) of everything but the crc field
+uint32_t ProfileStore::Checksum(const RecordTypeDef& record)
+{
+	const auto bytes = std::bit_cast<std::array<uint8_t, sizeof(RecordTypeDef)>>(record);
+	uint32_t crc = 0xFFFF'FFFF;
+	for(size_t i = 0; i < offsetof(RecordTypeDef, crc); ++i)
+	{
+		crc ^= bytes[i];
+		for(size_t bit = 0; bit < 8; ++bit) {
+			crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB8'8320 : 0);
+		}
+	}
+	return ~crc;
+}
+bool ProfileStore::ReadRecord(uint32_t offset, RecordTypeDef& record)
+{
+	std::memcpy(&record, reinterpret_cast<const void*>(profile_constants::kAddress + offset), sizeof(RecordTypeDef));
+	return record.magic == profile_constants::kMagic && record.crc == Checksum(record);
+}
+// Takes a valid record, newer than every one indexed so far
+void ProfileStore::Index(const RecordTypeDef& record)
+{
+	if(record.kind == RecordKindTypeDef::kProfile)
+	{
+		const auto list = std::span<ProfileTypeDef>(profiles_).first(profile_count_);
+		const auto it = std::find_if(list.begin(), list.end(),
+			[&record](const auto& p) { return p.GetName() == record.profile.GetName(); });
+		if(it != list.end()) {
+			*it = record.profile;
+		}
+		else if(profile_count_ < profiles_.size()) {
+			profiles_[profile_count_++] = record.profile;
+		}
+	}
+	else if(record.kind == RecordKindTypeDef::kBoot) {
+		boot_ = record;
+	}
+	else if(record.kind == RecordKindTypeDef::kCalibration && record.profile.value[0] < calibrations_.size()) {
+		calibrations_[record.profile.value[0]] = record;
+	}
+}
+HAL_StatusTypeDef ProfileStore::Program(uint32_t offset, const RecordTypeDef& record)
+{
+	const auto words = std::bit_cast<std::array<uint32_t, sizeof(RecordTypeDef) / sizeof(uint32_t)>>(record);
+
+	HAL_FLASH_Unlock();
+	__HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_ERSERR);
+	HAL_StatusTypeDef state = HAL_OK;
+	for(size_t i = 0; i < words.size() && state == HAL_OK; ++i) {
+		state = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, profile_constants::kAddress + offset + i * sizeof(uint32_t), words[i]);
+	}
+	HAL_FLASH_Lock();
+	return state;
+}
+// Stalls the core for the whole sector erase (up to a few seconds); never call it while capturing
+HAL_StatusTypeDef ProfileStore::Erase()
+{
+	FLASH_EraseInitTypeDef erase = {};
+	erase.TypeErase		= FLASH_TYPEERASE_SECTORS;
+	erase.Sector		= profile_constants::kSector;
+	erase.NbSectors		= 1;
+	erase.VoltageRange	= FLASH_VOLTAGE_RANGE_3;
+	uint32_t sector_error = 0;
+
+	HAL_FLASH_Unlock();
+	__HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_ERSERR);
+	const auto state = HAL_FLASHEx_Erase(&erase, &sector_error);
+	HAL_FLASH_Lock();
+	return state;
+}
+// Writes back the indexed records: the newest of every profile, the boot selection and every
+// calibration. A reset between the erase and the rewrite loses the profiles held in RAM.
+HAL_StatusTypeDef ProfileStore::Compact()
+{
+	if(const auto state = Erase(); state != HAL_OK) return state;
+	end_ = 0;
+
+	for(const auto& profile : std::span<const ProfileTypeDef>(profiles_).first(profile_count_))
+	{
+		RecordTypeDef record = {profile_constants::kMagic, RecordKindTypeDef::kProfile, profile, 0};
+		record.crc = Checksum(record);
+		if(const auto state = Program(end_, record); state != HAL_OK) return state;
+		end_ += sizeof(RecordTypeDef);
+	}
+	if(boot_.magic == profile_constants::kMagic)
+	{
+		if(const auto state = Program(end_, boot_); state != HAL_OK) return state;
+		end_ += sizeof(RecordTypeDef);
+	}
+	for(const auto& calibration : calibrations_)
+	{
+		if(calibration.magic != profile_constants::kMagic) continue;
+		if(const auto state = Program(end_, calibration); state != HAL_OK) return state;
+		end_ += sizeof(RecordTypeDef);
+	}
+	return HAL_OK;
+}
+HAL_StatusTypeDef ProfileStore::Append(RecordKindTypeDef kind, const ProfileTypeDef& profile)
+{
+	if(end_ + sizeof(RecordTypeDef) > profile_constants::kSize)
+	{
+		if(const auto state = Compact(); state != HAL_OK) return state;
+		if(end_ + sizeof(RecordTypeDef) > profile_constants::kSize) return HAL_ERROR;
+	}
+
+	RecordTypeDef record = {profile_constants::kMagic, kind, profile, 0};
+	record.crc = Checksum(record);
+
+	// The slot is used up even if programming fails half way
+	const auto state = Program(end_, record);
+	end_ += sizeof(RecordTypeDef);
+	if(state == HAL_OK) Index(record);
+	return state;
+}
+
+
+/*----- Initializer -----*/
+// One pass over the log: indexes every valid record and finds the end, the first slot whose
+// magic word is still erased. The lookups below never read the flash again.
+void ProfileStore::Init()
+{
+	end_ = 0;
+	profile_count_ = 0;
+	boot_ = {};
+	calibrations_ = {};
+	while(end_ + sizeof(RecordTypeDef) <= profile_constants::kSize)
+	{
+		RecordTypeDef record;
+		if(ReadRecord(end_, record)) Index(record);
+		else if(record.magic == profile_constants::kErased) break;
+		end_ += sizeof(RecordTypeDef);
+	}
+}
+
+
+/*----- Profile -----*/
+bool ProfileStore::IsValidName(std::string_view name)
+{
+	if(name.empty() || name.size() > profile_constants::kNameSize) return false;
+	return std::all_of(name.begin(), name.end(),
+		[](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-'; });
+}
+HAL_StatusTypeDef ProfileStore::Save(std::string_view name, std::span<const uint32_t, profile_constants::kRegisterCount> value)
+{
+	if(!IsValidName(name)) return HAL_ERROR;
+
+	ProfileTypeDef profile = {};
+	if(!Find(name, profile))
+	{
+		std::array<ProfileTypeDef, profile_constants::kMaxProfiles> profiles;
+		if(List(profiles) == profile_constants::kMaxProfiles) return HAL_ERROR;
+	}
+
+	profile = {};
+	std::copy(name.begin(), name.end(), profile.name.begin());
+	std::copy(value.begin(), value.end(), profile.value.begin());
+	return Append(RecordKindTypeDef::kProfile, profile);
+}
+bool ProfileStore::Find(std::string_view name, ProfileTypeDef& profile)
+{
+	const auto list = std::span<const ProfileTypeDef>(profiles_).first(profile_count_);
+	const auto it = std::find_if(list.begin(), list.end(), [name](const auto& p) { return p.GetName() == name; });
+	if(it == list.end()) return false;
+	profile = *it;
+	return true;
+}
+// Newest version of every profile, in order of first appearance
+size_t ProfileStore::List(std::span<ProfileTypeDef> profiles)
+{
+	const size_t count = std::min(profiles.size(), profile_count_);
+	std::copy_n(profiles_.begin(), count, profiles.begin());
+	return count;
+}
+
+
+/*----- Boot Profile -----*/
+HAL_StatusTypeDef ProfileStore::SetBoot(std::string_view name)
+{
+	ProfileTypeDef profile = {};
+	if(!name.empty() && !Find(name, profile)) return HAL_ERROR;
+	return Append(RecordKindTypeDef::kBoot, profile);
+}
+bool ProfileStore::GetBoot(ProfileTypeDef& profile)
+{
+	if(boot_.magic != profile_constants::kMagic || boot_.profile.GetName().empty()) return false;
+	return Find(boot_.profile.GetName(), profile);
+}
+
+
+/*----- Calibration -----*/
+HAL_StatusTypeDef ProfileStore::SaveCalibration(size_t device, const CalibrationTypeDef& calibration)
+{
+	if(device >= profile_constants::kMaxDevices) return HAL_ERROR;
+
+	ProfileTypeDef profile = {};
+	profile.value = {
+		static_cast<uint32_t>(device),
+		std::bit_cast<uint32_t>(calibration.offset),
+		std::bit_cast<uint32_t>(calibration.gain)
+	};
+	return Append(RecordKindTypeDef::kCalibration, profile);
+}
+bool ProfileStore::FindCalibration(size_t device, CalibrationTypeDef& calibration)
+{
+	if(device >= calibrations_.size() || calibrations_[device].magic != profile_constants::kMagic) return false;
+	calibration.offset = std::bit_cast<int32_t>(calibrations_[device].profile.value[1]);
+	calibration.gain = std::bit_cast<int32_t>(calibrations_[device].profile.value[2]);
+	return true;
+}
+
+
+/*----- Statistics -----*/
+ProfileStore::StatisticsTypeDef ProfileStore::GetStatistics() { return {end_, profile_constants::kSize}; }
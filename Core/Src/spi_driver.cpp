@@ -14,10 +14,8 @@ const size_t SPIDriver::GetReadCount() { return read_count_.load(); }
 void SPIDriver::RxInterruptCallback(SPI_HandleTypeDef* hspi)
 {
 	++read_count_;
-	Deassert(GetCallbackPinIndex());
 }
 void SPIDriver::TxRxInterruptCallback(SPI_HandleTypeDef* hspi)
 {
 	++read_count_;
-	Deassert(GetCallbackPinIndex());
 }
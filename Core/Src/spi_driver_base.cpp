@@ -4,43 +4,282 @@
  *  Created on: Dec 16, 2025
  */
 #include <spi_driver_base.hpp>
+#include <event.hpp>
 
 /*----- Variables -----*/
 SPI_HandleTypeDef* SPIDriverBase::hspi_ = nullptr;
-std::array<uint8_t, spi_constants::kMax> SPIDriverBase::rx_buffer_ = {};
+std::array<std::array<uint8_t, spi_constants::kMax>, spi_constants::kRxBufferCount> SPIDriverBase::rx_buffer_ = {};
+std::atomic<size_t> SPIDriverBase::rx_ready_index_{0};
+std::atomic<uint32_t> SPIDriverBase::rx_owned_{0};
+std::atomic<uint32_t> SPIDriverBase::rx_busy_{0};
 std::array<uint8_t, spi_constants::kMax> SPIDriverBase::tx_buffer_ = {};
 uint16_t SPIDriverBase::buffer_size_ = 0;
+uint8_t SPIDriverBase::word_bits_ = 8;
 size_t SPIDriverBase::callback_pin_index_ = 0;
+std::atomic<uint32_t> SPIDriverBase::assert_cycle_{0};
+std::array<size_t, spi_constants::kMaxPin> SPIDriverBase::scan_list_ = {};
+size_t SPIDriverBase::scan_length_ = 0;
+
+std::array<SPIDriverBase::TransactionQueueTypeDef, static_cast<size_t>(SPIPriorityTypeDef::kCount)> SPIDriverBase::queue_ = {};
+SPITransactionTypeDef SPIDriverBase::current_ = {};
+SPIPriorityTypeDef SPIDriverBase::current_priority_ = SPIPriorityTypeDef::kControl;
+bool SPIDriverBase::is_busy_ = false;
+bool SPIDriverBase::is_aborting_ = false;
 
 SPIDriverBase::AtomicInterruptStatusTypeDef SPIDriverBase::rx_{HAL_OK, true};
 SPIDriverBase::AtomicInterruptStatusTypeDef SPIDriverBase::txrx_{HAL_OK, true};
 SPIDriverBase* SPIDriverBase::active_ = nullptr;
+std::array<SPIDriverBase::ScanContextTypeDef, spi_constants::kRxBufferCount> SPIDriverBase::scan_context_ = {};
 
 /*----- Private Functions -----*/
 HAL_StatusTypeDef SPIDriverBase::Assert(size_t i)
 {
-	if(i >= cs_pin_.size()) return HAL_ERROR;
+	if(i >= cs_pin_count_) return HAL_ERROR;
 	cs_pin_[i].Low();
 
 	return HAL_OK;
 }
 HAL_StatusTypeDef SPIDriverBase::Deassert(size_t i)
 {
-	if(i >= cs_pin_.size()) return HAL_ERROR;
+	if(i >= cs_pin_count_) return HAL_ERROR;
 	cs_pin_[i].High();
 	return HAL_OK;
 }
 
+// Starts the highest-priority queued transaction if the bus is idle.
+// Transactions that fail to start are completed with their error and the next one is tried.
+void SPIDriverBase::StartNext()
+{
+	CriticalSection lock;
+	while(!is_busy_)
+	{
+		const auto queue = std::find_if(queue_.begin(), queue_.end(), [](const auto& q) { return q.count != 0; });
+		if(queue == queue_.end()) return;
+
+		const auto transaction = queue->entry[queue->head];
+		queue->head = (queue->head + 1) % spi_constants::kQueueDepth;
+		--queue->count;
+
+		if(active_->Assert(transaction.pin_index) != HAL_OK)
+		{
+			if(transaction.callback != nullptr) transaction.callback(transaction.context, HAL_ERROR);
+			continue;
+		}
+		assert_cycle_.store(CycleCounter::Now());
+
+		HAL_StatusTypeDef state;
+		SetDirection(transaction.tx.empty() ? SPI_DIRECTION_2LINES_RXONLY : SPI_DIRECTION_2LINES);
+		SetDataSize(transaction.word_bits);
+		if(transaction.tx.empty()) {
+			state = HAL_SPI_Receive_IT(hspi_, transaction.rx.data(), transaction.length);
+		}
+		else if(transaction.rx.empty()) {
+			state = HAL_SPI_Transmit_IT(hspi_, transaction.tx.data(), transaction.length);
+		}
+		else {
+			state = HAL_SPI_TransmitReceive_IT(hspi_, transaction.tx.data(), transaction.rx.data(), transaction.length);
+		}
+		if(state != HAL_OK)
+		{
+			active_->Deassert(transaction.pin_index);
+			if(transaction.callback != nullptr) transaction.callback(transaction.context, state);
+			continue;
+		}
+
+		current_ = transaction;
+		current_priority_ = static_cast<SPIPriorityTypeDef>(queue - queue_.begin());
+		is_busy_ = true;
+	}
+}
+// In full duplex HAL_SPI_Receive_IT() falls back to a transmit-receive of the rx buffer, with a
+// TXE interrupt per frame. In 2-line receive-only the master clocks as long as SPE is set, so
+// only RXNE is serviced; HAL clears SPE after the last frame, which lets a few extra SCLK
+// cycles through while CS is still asserted. RXONLY may only change with SPE cleared.
+// Called inside CriticalSection with the bus idle.
+void SPIDriverBase::SetDirection(uint32_t direction)
+{
+	if(hspi_->Init.Direction == direction) return;
+	__HAL_SPI_DISABLE(hspi_);
+	MODIFY_REG(hspi_->Instance->CR1, SPI_CR1_RXONLY, (direction == SPI_DIRECTION_2LINES_RXONLY) ? SPI_CR1_RXONLY : 0);
+	hspi_->Init.Direction = direction;
+}
+// HAL takes the FIFO access width and the RXNE threshold from Init.DataSize: above 8 bits every
+// word is one halfword access and one RXNE. DS may only change with SPE cleared.
+// Called inside CriticalSection with the bus idle.
+void SPIDriverBase::SetDataSize(uint8_t bits)
+{
+	const uint32_t data_size = static_cast<uint32_t>(bits - 1) << SPI_CR2_DS_Pos;
+	if(hspi_->Init.DataSize == data_size) return;
+	__HAL_SPI_DISABLE(hspi_);
+	MODIFY_REG(hspi_->Instance->CR2, SPI_CR2_DS, data_size);
+	hspi_->Init.DataSize = data_size;
+}
+// Called from the HAL callbacks. The next transaction is put on the bus before the
+// finished one is reported, so the gap between queued transfers stays short.
+void SPIDriverBase::Complete(HAL_StatusTypeDef state)
+{
+	SPITransactionTypeDef done;
+	{
+		CriticalSection lock;
+		if(!is_busy_ || is_aborting_) return;
+		done = current_;
+		active_->Deassert(done.pin_index);
+		is_busy_ = false;
+		StartNext();
+	}
+	if(done.callback != nullptr) done.callback(done.context, state);
+	Event::Post(event_constants::kSPI);
+}
+// Drops every transaction carrying this context. A transfer already on the bus is aborted.
+// HAL_SPI_Abort() polls HAL_GetTick(), so it runs with interrupts enabled: the bus stays
+// claimed meanwhile and a completion that races the abort is ignored. Thread context only.
+void SPIDriverBase::Cancel(void* context)
+{
+	size_t pin_index;
+	{
+		CriticalSection lock;
+		for(auto& queue : queue_)
+		{
+			size_t kept = 0;
+			for(size_t i = 0; i < queue.count; ++i)
+			{
+				const auto transaction = queue.entry[(queue.head + i) % spi_constants::kQueueDepth];
+				if(transaction.context != context) queue.entry[(queue.head + kept++) % spi_constants::kQueueDepth] = transaction;
+			}
+			queue.count = kept;
+		}
+		if(!is_busy_ || is_aborting_ || current_.context != context) return;
+		is_aborting_ = true;
+		pin_index = current_.pin_index;
+	}
+
+	HAL_SPI_Abort(hspi_);
+
+	CriticalSection lock;
+	active_->Deassert(pin_index);
+	is_aborting_ = false;
+	is_busy_ = false;
+	StartNext();
+}
+// Picks the bank for the next receive and marks it busy: the oldest one that the consumer does
+// not own and no transfer is filling. A completed bank that was never taken is reused.
+// Called inside CriticalSection.
+bool SPIDriverBase::SelectRxBuffer(size_t& bank)
+{
+	const size_t ready = rx_ready_index_.load();
+	for(size_t k = 1; k <= spi_constants::kRxBufferCount; ++k)
+	{
+		const size_t i = (ready + k) % spi_constants::kRxBufferCount;
+		if(((rx_owned_.load() | rx_busy_.load()) & (1u << i)) == 0)
+		{
+			rx_busy_.fetch_or(1u << i);
+			bank = i;
+			return true;
+		}
+	}
+	return false;
+}
+HAL_StatusTypeDef SPIDriverBase::TransferToRxBuffer(size_t pin_index, std::span<const uint8_t> tx)
+{
+	size_t bank;
+	{
+		CriticalSection lock;
+		if(!SelectRxBuffer(bank)) return HAL_BUSY;
+	}
+
+	const auto state = Transfer(pin_index, tx, std::span<uint8_t>(rx_buffer_[bank]).first(tx.size()));
+	if(state == HAL_OK) rx_ready_index_.store(bank);
+	rx_busy_.fetch_and(~(1u << bank));
+	return state;
+}
+// Queues one acquisition transaction per device of the scan list (or the callback pin alone),
+// each into its own slice of a free receive bank. The last one completes the ReadIT()/ReadWriteIT() call.
+HAL_StatusTypeDef SPIDriverBase::SubmitScan(bool is_rx, void (*complete)(void*, HAL_StatusTypeDef), AtomicInterruptStatusTypeDef& status)
+{
+	const size_t length = std::max<size_t>(scan_length_, 1);
+	const auto words = static_cast<uint16_t>(buffer_size_ / ((word_bits_ > 8) ? 2 : 1));
+
+	CriticalSection lock;
+	if(queue_[static_cast<size_t>(SPIPriorityTypeDef::kAcquisition)].count + length > spi_constants::kQueueDepth) return HAL_BUSY;
+	size_t bank;
+	if(!SelectRxBuffer(bank)) return HAL_BUSY;
+	scan_context_[bank] = {&status, bank};
+	for(size_t i = 0; i < length; ++i)
+	{
+		const SPITransactionTypeDef transaction = {
+			(scan_length_ != 0) ? scan_list_[i] : callback_pin_index_,
+			is_rx ? std::span<const uint8_t>() : std::span<const uint8_t>(tx_buffer_).first(buffer_size_),
+			std::span<uint8_t>(rx_buffer_[bank]).subspan(i * buffer_size_, buffer_size_),
+			words,
+			(i + 1 == length) ? complete : OnScanStep,
+			&scan_context_[bank],
+			word_bits_
+		};
+		if(const auto state = Submit(transaction, SPIPriorityTypeDef::kAcquisition); state != HAL_OK)
+		{
+			// Every transaction of a scan passes the same checks, so only the first one can fail
+			if(i == 0) rx_busy_.fetch_and(~(1u << bank));
+			return state;
+		}
+	}
+	return HAL_OK;
+}
+
+
+/*----- Transaction Callback -----*/
+void SPIDriverBase::OnScanStep(void* context, HAL_StatusTypeDef state)
+{
+	if(state != HAL_OK) static_cast<ScanContextTypeDef*>(context)->status->state.store(state);
+}
+void SPIDriverBase::OnBurstStep(void* context, HAL_StatusTypeDef state)
+{
+	if(state != HAL_OK) static_cast<AtomicInterruptStatusTypeDef*>(context)->state.store(state);
+}
+void SPIDriverBase::OnReadComplete(void* context, HAL_StatusTypeDef state)
+{
+	const size_t bank = static_cast<ScanContextTypeDef*>(context)->bank;
+	rx_busy_.fetch_and(~(1u << bank));
+	if(state != HAL_OK)
+	{
+		rx_.state.store(state);
+		return;
+	}
+	rx_ready_index_.store(bank);
+	active_->RxInterruptCallback(hspi_);
+	rx_.done.store(true);
+}
+void SPIDriverBase::OnReadWriteComplete(void* context, HAL_StatusTypeDef state)
+{
+	const size_t bank = static_cast<ScanContextTypeDef*>(context)->bank;
+	rx_busy_.fetch_and(~(1u << bank));
+	if(state != HAL_OK)
+	{
+		txrx_.state.store(state);
+		return;
+	}
+	rx_ready_index_.store(bank);
+	active_->TxRxInterruptCallback(hspi_);
+	txrx_.done.store(true);
+}
+void SPIDriverBase::OnTransferComplete(void* context, HAL_StatusTypeDef state)
+{
+	auto* completion = static_cast<AtomicInterruptStatusTypeDef*>(context);
+	completion->state.store(state);
+	completion->done.store(true);
+}
+
 
 /*----- Initializer -----*/
-void SPIDriverBase::Init(SPI_HandleTypeDef* hspi, std::vector<GPIOWrapper> cs_pin)
+void SPIDriverBase::Init(SPI_HandleTypeDef* hspi, std::initializer_list<GPIOWrapper> cs_pin)
 {
 	if(is_initialized_) return;
+	if(cs_pin.size() > spi_constants::kMaxPin) return;
 	active_ = this;
 	hspi_ = hspi;
-	this->cs_pin_ = std::move(cs_pin);
-	for(auto& pin: this->cs_pin_) {
-		pin.High();
+	std::copy(cs_pin.begin(), cs_pin.end(), this->cs_pin_.begin());
+	this->cs_pin_count_ = cs_pin.size();
+	for(size_t i = 0; i < this->cs_pin_count_; ++i) {
+		this->cs_pin_[i].High();
 	}
 	is_initialized_ = true;
 }
@@ -48,7 +287,17 @@ void SPIDriverBase::InitBuffer() {
 	if(hspi_ == nullptr) return;
 	if(HAL_SPI_GetState(hspi_) != HAL_SPI_STATE_READY) return;
 	tx_buffer_.fill(0);
-	rx_buffer_.fill(0);
+	for(auto& bank : rx_buffer_) {
+		bank.fill(0);
+	}
+}
+// Forgets the outcome of earlier interrupt reads, so a new capture starts without an error
+void SPIDriverBase::InitReadState()
+{
+	for(auto* status : {&rx_, &txrx_}) {
+		status->state.store(HAL_OK);
+		status->done.store(true);
+	}
 }
 
 
@@ -57,7 +306,7 @@ void SPIDriverBase::SetCallbackPinIndex(size_t i)
 {
 	if(hspi_ == nullptr) return;
 	if(HAL_SPI_GetState(hspi_) != HAL_SPI_STATE_READY) return;
-	if(i >= SPIDriverBase::active_->cs_pin_.size()) return;
+	if(i >= SPIDriverBase::active_->cs_pin_count_) return;
 	callback_pin_index_ = i;
 }
 HAL_StatusTypeDef SPIDriverBase::SetBufferSize(size_t n)
@@ -70,6 +319,18 @@ HAL_StatusTypeDef SPIDriverBase::SetBufferSize(size_t n)
 
 	return HAL_OK;
 }
+// SPI word size of ReadIT()/ReadWriteIT(); the buffer size must be a whole number of words
+// (two bytes each above 8 bits). Register transfers always use 8 bits.
+HAL_StatusTypeDef SPIDriverBase::SetWordSize(uint8_t bits)
+{
+	if(hspi_ == nullptr) return HAL_ERROR;
+	if(HAL_SPI_GetState(hspi_) != HAL_SPI_STATE_READY) return HAL_ERROR;
+	if(bits < spi_constants::kMinWordBits || bits > spi_constants::kMaxWordBits) return HAL_ERROR;
+
+	word_bits_ = bits;
+
+	return HAL_OK;
+}
 HAL_StatusTypeDef SPIDriverBase::SetTxBuffer(std::span<const uint8_t> buffer) {
 	if(hspi_ == nullptr) return HAL_ERROR;
 	if(HAL_SPI_GetState(hspi_) != HAL_SPI_STATE_READY) return HAL_ERROR;
@@ -80,6 +341,39 @@ HAL_StatusTypeDef SPIDriverBase::SetTxBuffer(std::span<const uint8_t> buffer) {
 
 	return HAL_OK;
 }
+HAL_StatusTypeDef SPIDriverBase::SetBaudRateDivider(uint16_t divider)
+{
+	if(hspi_ == nullptr) return HAL_ERROR;
+	if(HAL_SPI_GetState(hspi_) != HAL_SPI_STATE_READY) return HAL_ERROR;
+
+	const auto it = std::find_if(spi_constants::kBaudRatePrescaler.begin(), spi_constants::kBaudRatePrescaler.end(),
+		[divider](const auto& p) { return p.divider == divider; });
+	if(it == spi_constants::kBaudRatePrescaler.end()) return HAL_ERROR;
+
+	// BR[2:0] may only be changed while the peripheral is disabled.
+	// HAL re-enables SPE at the start of the next transfer.
+	__HAL_SPI_DISABLE(hspi_);
+	MODIFY_REG(hspi_->Instance->CR1, SPI_CR1_BR, it->prescaler);
+	hspi_->Init.BaudRatePrescaler = it->prescaler;
+
+	return HAL_OK;
+}
+// An empty list returns to single-device mode on the callback pin.
+HAL_StatusTypeDef SPIDriverBase::SetScanList(std::span<const size_t> list)
+{
+	if(hspi_ == nullptr) return HAL_ERROR;
+	if(HAL_SPI_GetState(hspi_) != HAL_SPI_STATE_READY) return HAL_ERROR;
+	if(list.size() > spi_constants::kMaxPin) return HAL_ERROR;
+	for(const auto i : list) {
+		if(i >= SPIDriverBase::active_->cs_pin_count_) return HAL_ERROR;
+	}
+
+	std::copy(list.begin(), list.end(), scan_list_.begin());
+	scan_length_ = list.size();
+	if(scan_length_ != 0) callback_pin_index_ = scan_list_[0];
+
+	return HAL_OK;
+}
 
 
 /*----- Getter -----*/
@@ -88,10 +382,138 @@ const HAL_SPI_StateTypeDef SPIDriverBase::GetSPIState()
 	if(SPIDriverBase::hspi_ == nullptr) return HAL_SPI_STATE_ERROR;
 	return HAL_SPI_GetState(SPIDriverBase::hspi_);
 }
-std::span<const uint8_t> SPIDriverBase::GetBuffer() { return std::span<const uint8_t>(rx_buffer_).first(buffer_size_); }
+std::span<const uint8_t> SPIDriverBase::GetBuffer() { return std::span<const uint8_t>(rx_buffer_[rx_ready_index_.load()]).first(buffer_size_); }
 size_t SPIDriverBase::GetCallbackPinIndex() { return callback_pin_index_; }
 SPIDriverBase::InterruptStatusTypeDef SPIDriverBase::GetReadITState() { return {rx_.state.load(), rx_.done.load()}; }
 SPIDriverBase::InterruptStatusTypeDef SPIDriverBase::GetReadWriteITState() { return {txrx_.state.load(), txrx_.done.load()}; }
+std::span<const size_t> SPIDriverBase::GetScanList() { return std::span<const size_t>(scan_list_).first(scan_length_); }
+std::span<const uint8_t> SPIDriverBase::GetScanBuffer()
+{
+	return std::span<const uint8_t>(rx_buffer_[rx_ready_index_.load()]).first(buffer_size_ * std::max<size_t>(scan_length_, 1));
+}
+uint32_t SPIDriverBase::GetAssertCycle() { return assert_cycle_.load(); }
+// Queued plus in-flight transactions of one priority
+size_t SPIDriverBase::GetPendingCount(SPIPriorityTypeDef priority)
+{
+	if(priority >= SPIPriorityTypeDef::kCount) return 0;
+
+	CriticalSection lock;
+	const bool is_current = is_busy_ && current_priority_ == priority;
+	return queue_[static_cast<size_t>(priority)].count + (is_current ? 1 : 0);
+}
+uint16_t SPIDriverBase::GetBaudRateDivider()
+{
+	if(hspi_ == nullptr) return 0;
+	for(const auto& p : spi_constants::kBaudRatePrescaler) {
+		if(p.prescaler == hspi_->Init.BaudRatePrescaler) return p.divider;
+	}
+	return 0;
+}
+
+
+/*----- Receive Buffer -----*/
+// Hands the latest completed receive (one whole scan) to the caller. The bank is not written
+// again until ReleaseBuffer(), so it can be decoded while the next transfer already runs.
+std::span<const uint8_t> SPIDriverBase::TakeBuffer()
+{
+	CriticalSection lock;
+	const size_t i = rx_ready_index_.load();
+	rx_owned_.fetch_or(1u << i);
+	return std::span<const uint8_t>(rx_buffer_[i]).first(buffer_size_ * std::max<size_t>(scan_length_, 1));
+}
+void SPIDriverBase::ReleaseBuffer(std::span<const uint8_t> buffer)
+{
+	for(size_t i = 0; i < spi_constants::kRxBufferCount; ++i)
+	{
+		if(buffer.data() == rx_buffer_[i].data()) rx_owned_.fetch_and(~(1u << i));
+	}
+}
+
+
+/*----- Transaction -----*/
+// Safe from any context. The transaction starts at once when the bus is idle,
+// otherwise it runs from the completion interrupt of the transfers ahead of it.
+HAL_StatusTypeDef SPIDriverBase::Submit(const SPITransactionTypeDef& transaction, SPIPriorityTypeDef priority)
+{
+	if(hspi_ == nullptr || active_ == nullptr) return HAL_ERROR;
+	if(priority >= SPIPriorityTypeDef::kCount) return HAL_ERROR;
+	if(transaction.pin_index >= active_->cs_pin_count_) return HAL_ERROR;
+	if(transaction.length == 0) return HAL_ERROR;
+	if(transaction.word_bits < spi_constants::kMinWordBits || transaction.word_bits > spi_constants::kMaxWordBits) return HAL_ERROR;
+	if(transaction.tx.empty() && transaction.rx.empty()) return HAL_ERROR;
+	const size_t bytes = static_cast<size_t>(transaction.length) * ((transaction.word_bits > 8) ? 2 : 1);
+	if(!transaction.tx.empty() && transaction.tx.size() < bytes) return HAL_ERROR;
+	if(!transaction.rx.empty() && transaction.rx.size() < bytes) return HAL_ERROR;
+
+	CriticalSection lock;
+	auto& queue = queue_[static_cast<size_t>(priority)];
+	if(queue.count == spi_constants::kQueueDepth) return HAL_BUSY;
+	queue.entry[(queue.head + queue.count) % spi_constants::kQueueDepth] = transaction;
+	++queue.count;
+	StartNext();
+
+	return HAL_OK;
+}
+// Blocking transfer at control priority. It waits behind acquisition reads instead of
+// failing while a capture runs. Thread context only.
+HAL_StatusTypeDef SPIDriverBase::Transfer(size_t pin_index, std::span<const uint8_t> tx, std::span<uint8_t> rx)
+{
+	const size_t length = tx.empty() ? rx.size() : tx.size();
+	if(length > std::numeric_limits<uint16_t>::max()) return HAL_ERROR;
+
+	AtomicInterruptStatusTypeDef completion{HAL_OK, false};
+	const SPITransactionTypeDef transaction = {pin_index, tx, rx, static_cast<uint16_t>(length), OnTransferComplete, &completion};
+	if(const auto state = Submit(transaction, SPIPriorityTypeDef::kControl); state != HAL_OK) return state;
+
+	return WaitFor(completion);
+}
+// Writes a run of equally sized frames, each framed by its own CS pulse. All frames are queued
+// at once, so they go out back to back from the completion interrupt. Thread context only.
+HAL_StatusTypeDef SPIDriverBase::WriteBurst(size_t pin_index, std::span<const uint8_t> frames, size_t frame_size)
+{
+	if(frame_size == 0 || frame_size > std::numeric_limits<uint16_t>::max()) return HAL_ERROR;
+	if(frames.empty() || frames.size() % frame_size != 0) return HAL_ERROR;
+	const size_t count = frames.size() / frame_size;
+	if(count > spi_constants::kQueueDepth) return HAL_ERROR;
+
+	AtomicInterruptStatusTypeDef completion{HAL_OK, false};
+	{
+		CriticalSection lock;
+		if(queue_[static_cast<size_t>(SPIPriorityTypeDef::kControl)].count + count > spi_constants::kQueueDepth) return HAL_BUSY;
+		for(size_t i = 0; i < count; ++i)
+		{
+			const SPITransactionTypeDef transaction = {
+				pin_index,
+				frames.subspan(i * frame_size, frame_size),
+				{},
+				static_cast<uint16_t>(frame_size),
+				(i + 1 == count) ? OnTransferComplete : OnBurstStep,
+				&completion
+			};
+			if(const auto state = Submit(transaction, SPIPriorityTypeDef::kControl); state != HAL_OK)
+			{
+				Cancel(&completion);
+				return state;
+			}
+		}
+	}
+	return WaitFor(completion);
+}
+HAL_StatusTypeDef SPIDriverBase::WaitFor(AtomicInterruptStatusTypeDef& completion)
+{
+	const uint32_t start = HAL_GetTick();
+	while(!completion.done.load())
+	{
+		const uint32_t elapsed = HAL_GetTick() - start;
+		if(elapsed >= spi_constants::kTimeOut)
+		{
+			Cancel(&completion);
+			return HAL_TIMEOUT;
+		}
+		Event::Wait(event_constants::kSPI, spi_constants::kTimeOut - elapsed);
+	}
+	return completion.state.load();
+}
 
 
 /*----- I/O -----*/
@@ -99,21 +521,15 @@ HAL_StatusTypeDef SPIDriverBase::Write(size_t pin_index)
 {
 	if(hspi_ == nullptr) return HAL_ERROR;
 	if(buffer_size_ == 0) return HAL_ERROR;
-	if(Assert(pin_index) != HAL_OK) return HAL_ERROR;
 
-	const auto state = HAL_SPI_Transmit(hspi_, tx_buffer_.data(), buffer_size_, spi_constants::kTimeOut);
-	Deassert(pin_index);
-	return state;
+	return Transfer(pin_index, std::span<const uint8_t>(tx_buffer_).first(buffer_size_), {});
 }
 HAL_StatusTypeDef SPIDriverBase::ReadWrite(size_t pin_index)
 {
 	if(hspi_ == nullptr) return HAL_ERROR;
 	if(buffer_size_ == 0) return HAL_ERROR;
-	if(Assert(pin_index) != HAL_OK) return HAL_ERROR;
 
-	const auto state = HAL_SPI_TransmitReceive(hspi_, tx_buffer_.data(), rx_buffer_.data(), buffer_size_, spi_constants::kTimeOut);
-	Deassert(pin_index);
-	return state;
+	return TransferToRxBuffer(pin_index, std::span<const uint8_t>(tx_buffer_).first(buffer_size_));
 }
 void SPIDriverBase::ReadIT()
 {
@@ -124,22 +540,16 @@ void SPIDriverBase::ReadIT()
 		rx_.state.store(HAL_ERROR);
 		return;
 	}
-	if(buffer_size_ == 0)
-	{
-		rx_.state.store(HAL_ERROR);
-		return;
-	}
-	if(Assert(callback_pin_index_) != HAL_OK)
+	if(buffer_size_ == 0 || buffer_size_ * std::max<size_t>(scan_length_, 1) > spi_constants::kMax ||
+		(word_bits_ > 8 && buffer_size_ % 2 != 0))
 	{
 		rx_.state.store(HAL_ERROR);
 		return;
 	}
 
-	rx_.state.store(HAL_SPI_Receive_IT(hspi_, rx_buffer_.data(), buffer_size_));
-
-	if(rx_.state.load() != HAL_OK)
+	if(const auto state = SubmitScan(true, OnReadComplete, rx_); state != HAL_OK)
 	{
-		Deassert(callback_pin_index_);
+		rx_.state.store(state);
 	}
 	return;
 }
@@ -152,39 +562,43 @@ void SPIDriverBase::ReadWriteIT()
 		txrx_.state.store(HAL_ERROR);
 		return;
 	}
-	if(buffer_size_ == 0)
+	if(buffer_size_ == 0 || buffer_size_ * std::max<size_t>(scan_length_, 1) > spi_constants::kMax ||
+		(word_bits_ > 8 && buffer_size_ % 2 != 0))
 	{
 		txrx_.state.store(HAL_ERROR);
 		return;
 	}
-	if(Assert(callback_pin_index_) != HAL_OK)
-	{
-		txrx_.state.store(HAL_ERROR);
-		return;
-	}
-
-	txrx_.state.store(HAL_SPI_TransmitReceive_IT(hspi_, tx_buffer_.data(), rx_buffer_.data(), buffer_size_));
 
-	if(txrx_.state.load() != HAL_OK)
+	if(const auto state = SubmitScan(false, OnReadWriteComplete, txrx_); state != HAL_OK)
 	{
-		Deassert(callback_pin_index_);
+		txrx_.state.store(state);
 	}
 	return;
 }
 
 
 /*----- Interrupt Callback -----*/
+extern "C" void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef* hspi)
+{
+	if(SPIDriverBase::active_ == nullptr) return;
+	if(SPIDriverBase::hspi_ != hspi) return;
+	SPIDriverBase::Complete(HAL_OK);
+}
 extern "C" void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef* hspi)
 {
 	if(SPIDriverBase::active_ == nullptr) return;
 	if(SPIDriverBase::hspi_ != hspi) return;
-	SPIDriverBase::active_->RxInterruptCallback(hspi);
-	SPIDriverBase::active_->rx_.done.store(true);
+	SPIDriverBase::Complete(HAL_OK);
 }
 extern "C" void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef* hspi)
 {
 	if(SPIDriverBase::active_ == nullptr) return;
 	if(SPIDriverBase::hspi_ != hspi) return;
-	SPIDriverBase::active_->TxRxInterruptCallback(hspi);
-	SPIDriverBase::active_->txrx_.done.store(true);
+	SPIDriverBase::Complete(HAL_OK);
+}
+extern "C" void HAL_SPI_ErrorCallback(SPI_HandleTypeDef* hspi)
+{
+	if(SPIDriverBase::active_ == nullptr) return;
+	if(SPIDriverBase::hspi_ != hspi) return;
+	SPIDriverBase::Complete(HAL_ERROR);
 }
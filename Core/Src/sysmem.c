@@ -23,12 +23,20 @@
 /* Includes */
 #include <errno.h>
 #include <stdint.h>
+#include "sysmem.h"
 
 /**
  * Pointer to the current high watermark of the heap usage
  */
 static uint8_t *__sbrk_heap_end = NULL;
 
+/**
+ * Instrumentation, read by sbrk_get_statistics()
+ */
+static uint8_t *__sbrk_heap_peak = NULL;
+static uint32_t __sbrk_call_count = 0;
+static uint32_t __sbrk_fail_count = 0;
+
 /**
  * @brief _sbrk() allocates memory to the newlib heap and is used by malloc
  *        and others from the C library
@@ -63,17 +71,49 @@ void *_sbrk(ptrdiff_t incr)
   if (NULL == __sbrk_heap_end)
   {
     __sbrk_heap_end = &_end;
+    __sbrk_heap_peak = &_end;
   }
+  ++__sbrk_call_count;
 
   /* Protect heap from growing into the reserved MSP stack */
   if (__sbrk_heap_end + incr > max_heap)
   {
+    ++__sbrk_fail_count;
     errno = ENOMEM;
     return (void *)-1;
   }
 
   prev_heap_end = __sbrk_heap_end;
   __sbrk_heap_end += incr;
+  if (__sbrk_heap_end > __sbrk_heap_peak)
+  {
+    __sbrk_heap_peak = __sbrk_heap_end;
+  }
 
   return (void *)prev_heap_end;
 }
+
+/**
+ * @brief Reports newlib heap usage as seen by _sbrk()
+ *
+ * Sizes are in bytes, counted from the '_end' linker symbol. 'limit' is the
+ * largest heap _sbrk() will hand out before reaching the reserved MSP stack.
+ *
+ * @param stat Destination of the statistics
+ */
+void sbrk_get_statistics(sbrk_statistics_t *stat)
+{
+  extern uint8_t _end; /* Symbol defined in the linker script */
+  extern uint8_t _estack; /* Symbol defined in the linker script */
+  extern uint32_t _Min_Stack_Size; /* Symbol defined in the linker script */
+  const uint32_t stack_limit = (uint32_t)&_estack - (uint32_t)&_Min_Stack_Size;
+  const uint8_t *heap_end = (NULL == __sbrk_heap_end) ? &_end : __sbrk_heap_end;
+  const uint8_t *heap_peak = (NULL == __sbrk_heap_peak) ? &_end : __sbrk_heap_peak;
+
+  stat->used = (uint32_t)(heap_end - &_end);
+  stat->peak = (uint32_t)(heap_peak - &_end);
+  stat->limit = stack_limit - (uint32_t)&_end;
+  stat->end = (uint32_t)heap_end;
+  stat->call_count = __sbrk_call_count;
+  stat->fail_count = __sbrk_fail_count;
+}
@@ -4,15 +4,46 @@
  *  Created on: Dec 16, 2025
  */
 #include <uart_driver.hpp>
+#include <crc_unit.hpp>
+#include <format.hpp>
+#include <event.hpp>
+#include <cycle_counter.hpp>
+#include <algorithm>
 
 /*----- Variables -----*/
 UART_HandleTypeDef* UARTDriver::huart_ = nullptr;
 std::atomic<bool> UARTDriver::is_char_received_{false};
 uint8_t UARTDriver::buffer_ = 0;
+std::array<std::array<char, uart_constants::kTxBufferSize>, kernel_constants::kMaxTask + 1> UARTDriver::tx_buffer_ = {};
+Mutex UARTDriver::mutex_;
+bool UARTDriver::is_checksum_ = false;
+std::atomic<uint32_t> UARTDriver::rx_cycles_{0};
+uint32_t UARTDriver::line_start_ = 0;
+uint32_t UARTDriver::line_end_ = 0;
 
 
 /*----- Private Functions -----*/
 void UARTDriver::ReadChar() { HAL_UART_Receive_IT(huart_, &buffer_, 1); }
+void UARTDriver::Transmit(const uint8_t* data, size_t size)
+{
+	if(Kernel::Current() != nullptr)
+	{
+		WaitTransmit();
+		if(HAL_UART_Transmit_IT(huart_, data, static_cast<uint16_t>(size)) == HAL_OK) {
+			WaitTransmit();
+			return;
+		}
+	}
+	HAL_UART_Transmit(huart_, data, static_cast<uint16_t>(size), uart_constants::kTimeOut);
+}
+// A task sleeps until the transmit complete interrupt, the superloop spins
+void UARTDriver::WaitTransmit()
+{
+	while(huart_->gState != HAL_UART_STATE_READY)
+	{
+		if(Kernel::Current() != nullptr) Event::Wait(event_constants::kUARTTx);
+	}
+}
 
 
 /*----- Initializer -----*/
@@ -20,31 +51,106 @@ void UARTDriver::Init(UART_HandleTypeDef* huart) { huart_ = huart; }
 
 
 /*----- I/O -----*/
-std::string UARTDriver::ReadLine()
+std::pmr::string UARTDriver::ReadLine(std::pmr::memory_resource* resource)
 {
-	if(huart_ == nullptr) return std::string();
-	std::string res;
+	if(huart_ == nullptr) return std::pmr::string(resource);
+	std::pmr::string res(resource);
+	res.reserve(uart_constants::kLineReserve);
 	while(true) {
 		is_char_received_.store(false);
 		ReadChar();
-		while(!is_char_received_.load());
+		while(!is_char_received_.load()) Event::Wait(event_constants::kUARTRx);
+		if(res.empty()) line_start_ = rx_cycles_.load();
 		res.push_back(buffer_);
 
 		if(buffer_ == uart_constants::kLF) {
+			line_end_ = rx_cycles_.load();
 			break;
 		}
 	}
 
 	return res;
 }
-void UARTDriver::WriteLine(const std::string& out)
+void UARTDriver::WriteLine(std::string_view out)
 {
 	if(huart_ == nullptr) return;
-	HAL_UART_Transmit(huart_, reinterpret_cast<const uint8_t*>(out.c_str()), out.size(), uart_constants::kTimeOut);
-	HAL_UART_Transmit(huart_, &uart_constants::kCR, 1, uart_constants::kTimeOut);
-	HAL_UART_Transmit(huart_, &uart_constants::kLF, 1, uart_constants::kTimeOut);
+	if(out.size() <= GetTxBuffer().size())
+	{
+		std::copy(out.begin(), out.end(), GetTxBuffer().begin());
+		WriteTxBuffer(out.size());
+		return;
+	}
+	Mutex::Guard lock(mutex_);
+	Transmit(reinterpret_cast<const uint8_t*>(out.data()), out.size());
+	if(is_checksum_)
+	{
+		std::array<char, uart_constants::kChecksumSize> suffix;
+		suffix[0] = '*';
+		Format::Hex(std::span<char>(suffix).subspan(1), CRCUnit::Calculate(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(out.data()), out.size())), 32);
+		Transmit(reinterpret_cast<const uint8_t*>(suffix.data()), suffix.size());
+	}
+	Transmit(&uart_constants::kCR, 1);
+	Transmit(&uart_constants::kLF, 1);
+}
+void UARTDriver::Write(std::span<const uint8_t> out)
+{
+	if(huart_ == nullptr) return;
+	Mutex::Guard lock(mutex_);
+	Transmit(out.data(), out.size());
+	if(is_checksum_)
+	{
+		const uint32_t crc = CRCUnit::Calculate(out);
+		const std::array<uint8_t, 4> trailer = {
+			static_cast<uint8_t>(crc), static_cast<uint8_t>(crc >> 8), static_cast<uint8_t>(crc >> 16), static_cast<uint8_t>(crc >> 24)
+		};
+		Transmit(trailer.data(), trailer.size());
+	}
+}
+// Line buffer for in-place formatting (the calling task's own); room for CR+LF (and the checksum) is kept back
+std::span<char> UARTDriver::GetTxBuffer()
+{
+	return std::span<char>(tx_buffer_[Kernel::CurrentSlot()]).first(uart_constants::kTxBufferSize - 2 - (is_checksum_ ? uart_constants::kChecksumSize : 0));
 }
+void UARTDriver::WriteTxBuffer(size_t n)
+{
+	if(huart_ == nullptr) return;
+	if(n > GetTxBuffer().size()) return;
+
+	auto& buffer = tx_buffer_[Kernel::CurrentSlot()];
+	if(is_checksum_) {
+		const uint32_t crc = CRCUnit::Calculate(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(buffer.data()), n));
+		buffer[n++] = '*';
+		n += Format::Hex(std::span<char>(buffer).subspan(n), crc, 32);
+	}
+	buffer[n++] = uart_constants::kCR;
+	buffer[n++] = uart_constants::kLF;
+	Mutex::Guard lock(mutex_);
+	Transmit(reinterpret_cast<const uint8_t*>(buffer.data()), n);
+}
+HAL_StatusTypeDef UARTDriver::WriteIT(std::span<const uint8_t> out)
+{
+	if(huart_ == nullptr) return HAL_ERROR;
+	return HAL_UART_Transmit_IT(huart_, out.data(), static_cast<uint16_t>(out.size()));
+}
+void UARTDriver::Flush()
+{
+	if(huart_ == nullptr) return;
+	WaitTransmit();
+}
+void UARTDriver::SetChecksum(bool is_checksum) { is_checksum_ = is_checksum; }
+bool UARTDriver::IsChecksum() { return is_checksum_; }
+uint32_t UARTDriver::GetLineStart() { return line_start_; }
+uint32_t UARTDriver::GetLineEnd() { return line_end_; }
 
 
 /*----- Interrupt Callback -----*/
-extern "C" void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) { UARTDriver::is_char_received_.store(true); }
+extern "C" void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+	UARTDriver::rx_cycles_.store(CycleCounter::Now());
+	UARTDriver::is_char_received_.store(true);
+	Event::Post(event_constants::kUARTRx);
+}
+extern "C" void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+	Event::Post(event_constants::kUARTTx);
+}
@@ -0,0 +1,592 @@
+/*
+ * board.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Peripheral models and the bus thread of the emulator. Everything here is guarded by
+ * Board's mutex; the CPU thread takes it through Board::Lock only.
+ */
+#include "emulator.hpp"
+#include <constants.hpp>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/prctl.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+namespace {
+
+	using namespace emu_constants;
+
+	constexpr uint64_t kNever = std::numeric_limits<uint64_t>::max();
+	constexpr size_t kGainRegister = 1;			// PGA gain 2^(value & 7)
+	constexpr uint32_t kClkdecPin = GPIO_PIN_15;	// PD15, EXTI line 15
+
+	struct ChipSelectTypeDef {
+		GPIO_TypeDef* port{nullptr};
+		uint16_t pin{0};
+	};
+	struct StatisticsTypeDef {
+		uint64_t edges{0};
+		uint64_t edges_lost{0};			// still pending from the previous edge
+		uint64_t edges_late{0};			// skipped because the bus thread fell behind
+		uint64_t updates{0};
+		uint64_t updates_lost{0};
+		uint64_t updates_late{0};
+		uint64_t transfers{0};
+		uint64_t misaligned{0};
+		uint64_t rx_bytes{0};
+		uint64_t tx_bytes{0};
+	};
+
+	emu::BoardConfigTypeDef config;
+	int pty = -1;
+	int epoll_fd = -1;
+	int event_fd = -1;
+	int timer_fd = -1;
+	int signal_fd = -1;
+	uint32_t pty_events = 0;
+	uint64_t byte_ns = 0;				// one UART character, 10 bits
+
+	std::array<ChipSelectTypeDef, kChipSelectCount> chip_select;
+	std::array<uint32_t, kRegisterCount> registers{};
+
+	// CLKDEC edge k at edge_origin + k * edge_period
+	double edge_origin = 0.0;
+	double edge_period = 0.0;
+	uint64_t edge_next = 0;
+
+	// TIM4, update k >= 1 at timer_origin + k * timer_period
+	bool is_timer_running = false;
+	double timer_origin = 0.0;
+	double timer_period = 0.0;
+	uint64_t update_next = 0;
+
+	// SPI
+	bool is_transferring = false;
+	bool is_transfer_done = false;
+	uint64_t transfer_end = 0;
+	size_t transfer_bytes = 0;
+	std::array<uint8_t, kMaxTransfer> miso;
+
+	// UART receive: bytes from the pty wait in the queue, then enter RDR one character time apart
+	std::array<uint8_t, kRxQueueSize> rx_queue;
+	size_t rx_head = 0;
+	size_t rx_count = 0;
+	uint64_t rx_ready_at = 0;
+	bool is_rdr_full = false;
+	uint8_t rdr = 0;
+
+	// UART transmit: one transfer at a time, written to the pty as its characters complete
+	std::array<uint8_t, kTxSize> tx_buffer;
+	size_t tx_size = 0;
+	size_t tx_written = 0;
+	uint64_t tx_start = 0;
+	bool is_transmitting = false;
+	bool is_tx_it = false;
+	bool is_tx_done = false;
+	bool is_pty_full = false;
+	std::atomic<uint32_t> tx_sequence{0};
+
+	StatisticsTypeDef statistics;
+
+	void Wake()
+	{
+		const uint64_t one = 1;
+		[[maybe_unused]] const auto w = ::write(event_fd, &one, sizeof(one));
+	}
+
+	/*----- ADC -----*/
+	uint64_t Mix(uint64_t x)
+	{
+		x += 0x9E37'79B9'7F4A'7C15;
+		x = (x ^ (x >> 30)) * 0xBF58'476D'1CE4'E5B9;
+		x = (x ^ (x >> 27)) * 0x94D0'49BB'1331'11EB;
+		return x ^ (x >> 31);
+	}
+	// Same value for the same conversion, however often it is read
+	double Noise(uint64_t t, size_t channel)
+	{
+		const uint64_t a = Mix(config.adc.seed ^ Mix(t ^ (uint64_t{channel} << 56)));
+		const uint64_t b = Mix(a);
+		const double u1 = (static_cast<double>(a >> 11) + 1.0) / 9007199254740993.0;
+		const double u2 = static_cast<double>(b >> 11) / 9007199254740992.0;
+		return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * M_PI * u2);
+	}
+	uint32_t Sample(uint64_t t, size_t channel)
+	{
+		const auto& adc = config.adc;
+		const double phase = adc.frequency * static_cast<double>(t) * 1e-9 + static_cast<double>(channel) / 8.0;
+		const double fraction = phase - std::floor(phase);
+
+		double wave = 1.0;
+		switch(adc.waveform)
+		{
+		case emu::WaveformTypeDef::kSine:	wave = std::sin(2.0 * M_PI * fraction); break;
+		case emu::WaveformTypeDef::kRamp:	wave = 2.0 * fraction - 1.0; break;
+		case emu::WaveformTypeDef::kSquare:	wave = (fraction < 0.5) ? 1.0 : -1.0; break;
+		case emu::WaveformTypeDef::kDC:		break;
+		}
+		const double gain = static_cast<double>(1u << (registers[kGainRegister] & 0x7));
+		double x = gain * (adc.amplitude * wave + adc.offset);
+		if(adc.noise > 0.0) x += adc.noise * Noise(t, channel);
+
+		constexpr double kFullScale = static_cast<double>(int64_t{1} << (adc_constants::kResolution - 1));
+		const double code = std::clamp(std::nearbyint(x * kFullScale), -kFullScale, kFullScale - 1.0);
+		return static_cast<uint32_t>(static_cast<int64_t>(code));
+	}
+	// Start of the newest conversion whose data is ready at `now`
+	uint64_t LatestConversion(uint64_t now)
+	{
+		if(is_timer_running && timer_period > 0.0) {
+			const double since = static_cast<double>(now) - timer_origin - config.conversion_ns;
+			if(since < 0.0) return static_cast<uint64_t>(timer_origin);
+			return static_cast<uint64_t>(timer_origin + std::floor(since / timer_period) * timer_period);
+		}
+		if(config.clkdec_rate > 0.0) {
+			const double period = 1e9 / config.clkdec_rate;
+			return static_cast<uint64_t>(std::floor(static_cast<double>(now) / period) * period);
+		}
+		return now;
+	}
+
+	/*----- Edges and updates -----*/
+	uint64_t EdgesUpTo(uint64_t t)
+	{
+		const double since = static_cast<double>(t) - edge_origin;
+		return (since < 0.0) ? 0 : static_cast<uint64_t>(std::floor(since / edge_period)) + 1;
+	}
+	uint64_t UpdatesUpTo(uint64_t t)
+	{
+		const double since = static_cast<double>(t) - timer_origin;
+		return (since < 0.0) ? 0 : static_cast<uint64_t>(std::floor(since / timer_period));
+	}
+	// Data-ready edges follow CONVST while TIM4 runs, otherwise the free-running clock
+	void ResetEdges(uint64_t now)
+	{
+		if(is_timer_running && timer_period > 0.0) {
+			edge_origin = timer_origin + config.conversion_ns;
+			edge_period = timer_period;
+		}
+		else if(config.clkdec_rate > 0.0) {
+			edge_origin = 0.0;
+			edge_period = 1e9 / config.clkdec_rate;
+		}
+		else {
+			edge_period = 0.0;
+		}
+		if(edge_period > 0.0) edge_next = EdgesUpTo(now);
+	}
+	bool IsEdgeActive() { return edge_period > 0.0 && emu::Core::IsEnabled(EXTI15_10_IRQn); }
+	bool IsUpdateActive() { return is_timer_running && timer_period > 0.0 && (TIM4->DIER & TIM_DIER_UIE) != 0; }
+
+	void Edge()
+	{
+		++statistics.edges;
+		if(EXTI->PR & kClkdecPin) {
+			++statistics.edges_lost;
+			return;
+		}
+		EXTI->PR = EXTI->PR | kClkdecPin;
+		emu::Core::Raise(EXTI15_10_IRQn);
+	}
+	void Update()
+	{
+		++statistics.updates;
+		if(TIM4->SR & TIM_SR_UIF) {
+			++statistics.updates_lost;
+			return;
+		}
+		TIM4->SR = TIM4->SR | TIM_SR_UIF;
+		emu::Core::Raise(TIM4_IRQn);
+	}
+
+	/*----- SPI -----*/
+	size_t SelectedDevice()
+	{
+		for(size_t i = 0; i < chip_select.size(); ++i) {
+			const auto& cs = chip_select[i];
+			if(cs.port != nullptr && (cs.port->ODR & cs.pin) == 0) return i;
+		}
+		return chip_select.size();
+	}
+
+	/*----- UART -----*/
+	void Push(const uint8_t* data, size_t n, uint64_t now)
+	{
+		if(rx_count == 0 && !is_rdr_full && rx_ready_at < now) rx_ready_at = now + byte_ns;
+		for(size_t i = 0; i < n; ++i) rx_queue[(rx_head + rx_count++) % rx_queue.size()] = data[i];
+	}
+	void WritePty(uint64_t now)
+	{
+		const size_t due = (byte_ns == 0) ? tx_size : std::min<size_t>(tx_size, (now - tx_start) / byte_ns);
+		if(due > tx_written && !is_pty_full)
+		{
+			const ssize_t w = ::write(pty, tx_buffer.data() + tx_written, due - tx_written);
+			if(w > 0) {
+				tx_written += static_cast<size_t>(w);
+				statistics.tx_bytes += static_cast<uint64_t>(w);
+			}
+			else if(w < 0 && errno == EAGAIN) is_pty_full = true;
+		}
+		if(tx_written < tx_size) return;
+
+		// The last character is out
+		is_transmitting = false;
+		if(is_tx_it) {
+			is_tx_done = true;
+			emu::Core::Raise(USART3_IRQn);
+		}
+		else {
+			tx_sequence.fetch_add(1);
+			tx_sequence.notify_all();
+		}
+	}
+
+	/*----- Bus thread -----*/
+	void Step(uint64_t now)
+	{
+		if(edge_period > 0.0)
+		{
+			const uint64_t due = EdgesUpTo(now);
+			if(due > edge_next && IsEdgeActive()) {
+				statistics.edges_late += due - edge_next - 1;
+				Edge();
+			}
+			edge_next = std::max(edge_next, due);
+		}
+		if(is_timer_running && timer_period > 0.0)
+		{
+			const uint64_t due = UpdatesUpTo(now);
+			if(due > update_next && IsUpdateActive()) {
+				statistics.updates_late += due - update_next - 1;
+				Update();
+			}
+			update_next = std::max(update_next, due);
+		}
+		if(is_transferring && !is_transfer_done && now >= transfer_end) {
+			is_transfer_done = true;
+			emu::Core::Raise(SPI1_IRQn);
+		}
+		if(!is_rdr_full && rx_count != 0 && now >= rx_ready_at) {
+			rdr = rx_queue[rx_head];
+			rx_head = (rx_head + 1) % rx_queue.size();
+			--rx_count;
+			is_rdr_full = true;
+			++statistics.rx_bytes;
+			rx_ready_at = std::max(rx_ready_at + byte_ns, now);
+			emu::Core::Raise(USART3_IRQn);
+		}
+		if(is_transmitting) WritePty(now);
+	}
+	uint64_t NextDeadline()
+	{
+		uint64_t deadline = kNever;
+		if(IsEdgeActive()) deadline = std::min(deadline, static_cast<uint64_t>(std::ceil(edge_origin + edge_next * edge_period)));
+		if(IsUpdateActive()) deadline = std::min(deadline, static_cast<uint64_t>(std::ceil(timer_origin + (update_next + 1) * timer_period)));
+		if(is_transferring && !is_transfer_done) deadline = std::min(deadline, transfer_end);
+		if(!is_rdr_full && rx_count != 0) deadline = std::min(deadline, rx_ready_at);
+		if(is_transmitting && !is_pty_full && byte_ns != 0) deadline = std::min(deadline, tx_start + (tx_written + 1) * byte_ns);
+		if(is_transmitting && !is_pty_full && byte_ns == 0) deadline = 0;
+		return deadline;
+	}
+	void UpdateInterest()
+	{
+		uint32_t events = 0;
+		if(rx_count < rx_queue.size()) events |= EPOLLIN;
+		if(is_pty_full) events |= EPOLLOUT;
+		if(events == pty_events) return;
+
+		epoll_event event = {};
+		event.events = events;
+		event.data.fd = pty;
+		epoll_ctl(epoll_fd, EPOLL_CTL_MOD, pty, &event);
+		pty_events = events;
+	}
+	void Add(int fd, uint32_t events)
+	{
+		epoll_event event = {};
+		event.events = events;
+		event.data.fd = fd;
+		epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+	}
+
+}
+
+namespace emu {
+
+	std::mutex Board::mutex_;
+
+	Board::Lock::Lock() : lock_(Board::mutex_) {}
+
+	void Board::Init(const BoardConfigTypeDef& board_config, int pty_fd)
+	{
+		config = board_config;
+		pty = pty_fd;
+		byte_ns = (config.baud == 0) ? 0 : 10'000'000'000 / config.baud;
+
+		// SIGINT and SIGTERM go to the bus thread's signalfd, SIGUSR1 to the CPU thread only
+		sigset_t mask;
+		sigemptyset(&mask);
+		sigaddset(&mask, SIGINT);
+		sigaddset(&mask, SIGTERM);
+		pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+		signal_fd = signalfd(-1, &mask, SFD_CLOEXEC);
+
+		epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+		event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		Add(event_fd, EPOLLIN);
+		Add(timer_fd, EPOLLIN);
+		Add(signal_fd, EPOLLIN);
+		Add(pty, EPOLLIN);
+		pty_events = EPOLLIN;
+	}
+	void Board::SetChipSelect(size_t i, GPIO_TypeDef* port, uint16_t pin)
+	{
+		if(i < chip_select.size()) chip_select[i] = {port, pin};
+	}
+
+	void Board::Start()
+	{
+		std::thread([] {
+			sigset_t mask;
+			sigemptyset(&mask);
+			sigaddset(&mask, SIGUSR1);
+			pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+			prctl(PR_SET_TIMERSLACK, 1);
+
+			std::array<epoll_event, 8> events;
+			for(;;)
+			{
+				int timeout = -1;
+				{
+					std::lock_guard lock(mutex_);
+					Step(Clock::Now());
+					UpdateInterest();
+
+					itimerspec timer = {};
+					if(const uint64_t deadline = NextDeadline(); deadline != kNever)
+					{
+						const int64_t host = Clock::ToHost(deadline);
+						if(host - Clock::HostNow() <= kSpinThreshold_ns) timeout = 0;
+						else {
+							timer.it_value.tv_sec = host / 1'000'000'000;
+							timer.it_value.tv_nsec = host % 1'000'000'000;
+						}
+					}
+					timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &timer, nullptr);
+				}
+
+				const int n = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), timeout);
+				for(int e = 0; e < n; ++e)
+				{
+					const int fd = events[e].data.fd;
+					if(fd == signal_fd) {
+						PrintStatistics();
+						std::_Exit(0);
+					}
+					if(fd == pty)
+					{
+						std::lock_guard lock(mutex_);
+						if(events[e].events & EPOLLOUT) is_pty_full = false;
+						if((events[e].events & EPOLLIN) && rx_count < rx_queue.size())
+						{
+							std::array<uint8_t, 256> chunk;
+							const ssize_t r = ::read(pty, chunk.data(), std::min(chunk.size(), rx_queue.size() - rx_count));
+							if(r > 0) Push(chunk.data(), static_cast<size_t>(r), Clock::Now());
+						}
+						continue;
+					}
+					uint64_t count;
+					[[maybe_unused]] const auto r = ::read(fd, &count, sizeof(count));
+				}
+			}
+		}).detach();
+	}
+	void Board::PrintStatistics()
+	{
+		std::lock_guard lock(mutex_);
+		std::fprintf(stderr,
+			"fw_emu: %.3f s, edges %llu (lost %llu, late %llu), updates %llu (lost %llu, late %llu), "
+			"transfers %llu (misaligned %llu), uart rx %llu tx %llu bytes\n",
+			static_cast<double>(Clock::Now()) * 1e-9,
+			static_cast<unsigned long long>(statistics.edges), static_cast<unsigned long long>(statistics.edges_lost),
+			static_cast<unsigned long long>(statistics.edges_late),
+			static_cast<unsigned long long>(statistics.updates), static_cast<unsigned long long>(statistics.updates_lost),
+			static_cast<unsigned long long>(statistics.updates_late),
+			static_cast<unsigned long long>(statistics.transfers), static_cast<unsigned long long>(statistics.misaligned),
+			static_cast<unsigned long long>(statistics.rx_bytes), static_cast<unsigned long long>(statistics.tx_bytes));
+	}
+
+	/*----- NVIC / TIM4 -----*/
+	void Board::OnNvicEnable(IRQn_Type irqn)
+	{
+		if(irqn != EXTI15_10_IRQn) return;
+		ResetEdges(Clock::Now());
+		Wake();
+	}
+	// UG: the counter restarts with the current PSC and ARR
+	void Board::OnTimerReload()
+	{
+		const uint64_t now = Clock::Now();
+		const double ticks = static_cast<double>(TIM4->PSC + 1) * (TIM4->ARR + 1);
+		timer_origin = static_cast<double>(now);
+		timer_period = ticks * 1e9 / (2.0 * kPCLK1);
+		update_next = 0;
+		ResetEdges(now);
+
+		TIM4->SR = TIM4->SR | TIM_SR_UIF;
+		if(TIM4->DIER & TIM_DIER_UIE) emu::Core::Raise(TIM4_IRQn);
+		Wake();
+	}
+	void Board::OnTimerRun(bool is_running)
+	{
+		const uint64_t now = Clock::Now();
+		if(is_running && !is_timer_running) {
+			const double ticks = static_cast<double>(TIM4->PSC + 1) * (TIM4->ARR + 1);
+			timer_origin = static_cast<double>(now);
+			timer_period = ticks * 1e9 / (2.0 * kPCLK1);
+			update_next = 0;
+		}
+		is_timer_running = is_running;
+		ResetEdges(now);
+		Wake();
+	}
+	void Board::OnTimerInterrupt()
+	{
+		if(is_timer_running && timer_period > 0.0) update_next = UpdatesUpTo(Clock::Now());
+		Wake();
+	}
+
+	/*----- SPI -----*/
+	// The slave shifts out a bit stream MSB first: a register value for a 5-byte register
+	// frame, otherwise the newest conversion followed by zeros. Above max_sclk it comes one bit
+	// early, as a read sampled too late would.
+	HAL_StatusTypeDef Board::StartTransfer(SPI_HandleTypeDef* hspi, const uint8_t* tx, uint8_t* rx, uint16_t size)
+	{
+		const size_t bits = ((hspi->Init.DataSize >> SPI_CR2_DS_Pos) & 0xF) + 1;
+		const size_t bytes = size * ((bits > 8) ? 2 : 1);
+		if(size == 0 || bytes > miso.size()) return HAL_ERROR;
+
+		const uint64_t now = Clock::Now();
+		const uint32_t divider = 2u << ((hspi->Instance->CR1 & SPI_CR1_BR) >> SPI_CR1_BR_Pos);
+		const uint32_t sclk = kPCLK2 / divider;
+		const size_t device = SelectedDevice();
+
+		std::array<uint8_t, kMaxTransfer * 2> stream{};
+		if(device < chip_select.size())
+		{
+			if(bits == 8 && size == reg_constants::kFrameSize && tx != nullptr)
+			{
+				const size_t addr = tx[0] & ~reg_constants::kReadFlag & 0x7F;
+				uint32_t& reg = registers[addr];
+				if(tx[0] & reg_constants::kReadFlag) {
+					for(size_t i = 0; i < 4; ++i) stream[1 + i] = static_cast<uint8_t>(reg >> (24 - 8 * i));
+				}
+				else {
+					reg = (uint32_t{tx[1]} << 24) | (uint32_t{tx[2]} << 16) | (uint32_t{tx[3]} << 8) | tx[4];
+				}
+			}
+			else
+			{
+				std::array<uint8_t, AdcProfile::kBufferSize> frame;
+				AdcProfile::Encode(Sample(LatestConversion(now), device), frame.data());
+				const auto raw = AdcProfile::Gather(frame.data());
+				for(size_t i = 0; i < AdcProfile::kFrameSize; ++i) {
+					stream[i] = static_cast<uint8_t>(raw >> (8 * (AdcProfile::kFrameSize - 1 - i)));
+				}
+			}
+		}
+
+		const size_t shift = (sclk > config.max_sclk) ? 1 : 0;
+		statistics.misaligned += shift;
+		auto bit = [&](size_t i) -> uint32_t {
+			i += shift;
+			return (i / 8 < stream.size()) ? (stream[i / 8] >> (7 - i % 8)) & 1 : 0;
+		};
+		for(size_t w = 0; w < size; ++w)
+		{
+			uint32_t word = 0;
+			for(size_t b = 0; b < bits; ++b) word = (word << 1) | bit(w * bits + b);
+			if(bits > 8) {
+				const auto half = static_cast<uint16_t>(word);
+				std::memcpy(miso.data() + 2 * w, &half, sizeof(half));
+			}
+			else {
+				miso[w] = static_cast<uint8_t>(word);
+			}
+		}
+
+		hspi->pRxBuffPtr = rx;
+		is_transferring = true;
+		is_transfer_done = false;
+		transfer_bytes = bytes;
+		transfer_end = now + (static_cast<uint64_t>(bits) * size * 1'000'000'000 + sclk - 1) / sclk;
+		++statistics.transfers;
+		Wake();
+		return HAL_OK;
+	}
+	bool Board::FinishTransfer(SPI_HandleTypeDef* hspi)
+	{
+		if(!is_transfer_done) return false;
+		if(hspi->pRxBuffPtr != nullptr) std::memcpy(hspi->pRxBuffPtr, miso.data(), transfer_bytes);
+		is_transferring = false;
+		is_transfer_done = false;
+		return true;
+	}
+	void Board::AbortTransfer()
+	{
+		is_transferring = false;
+		is_transfer_done = false;
+	}
+
+	/*----- UART -----*/
+	bool Board::Receive(uint8_t& c)
+	{
+		if(!is_rdr_full) return false;
+		c = rdr;
+		is_rdr_full = false;
+		if(rx_count != 0) Wake();
+		return true;
+	}
+	void Board::OnReceiveArmed()
+	{
+		if(is_rdr_full) Core::Raise(USART3_IRQn);
+	}
+	uint32_t Board::StartTransmit(const uint8_t* data, uint16_t size, bool is_it)
+	{
+		std::memcpy(tx_buffer.data(), data, size);
+		tx_size = size;
+		tx_written = 0;
+		tx_start = Clock::Now();
+		is_transmitting = true;
+		is_tx_it = is_it;
+		is_tx_done = false;
+		Wake();
+		return tx_sequence.load();
+	}
+	bool Board::FinishTransmit()
+	{
+		if(!is_tx_done) return false;
+		is_tx_done = false;
+		return true;
+	}
+	void Board::WaitTransmit(uint32_t sequence)
+	{
+		while(tx_sequence.load() == sequence) tx_sequence.wait(sequence);
+	}
+
+}
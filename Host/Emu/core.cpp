@@ -0,0 +1,225 @@
+/*
+ * core.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Virtual clock, NVIC and PRIMASK of the emulated Cortex-M7.
+ */
+#include "emulator.hpp"
+#include <pthread.h>
+#include <sched.h>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <ctime>
+
+namespace {
+
+	// Only touched by the CPU thread, also from its signal handler
+	volatile std::sig_atomic_t primask = 0;
+	volatile std::sig_atomic_t is_dispatching = 0;
+
+	// IRQn 0..63, set from both threads
+	std::atomic<uint64_t> pending{0};
+	std::atomic<uint64_t> enabled{0};
+	std::array<uint8_t, 64> priority{};
+	std::array<emu::Core::VectorTypeDef, 64> vector{};
+
+	pthread_t cpu_thread;
+	thread_local bool is_cpu_thread = false;
+
+	uint32_t cycle_offset = 0;
+
+	uint64_t Bit(IRQn_Type irqn) { return (irqn >= 0 && irqn < 64) ? (uint64_t{1} << irqn) : 0; }
+
+	// Runs every pending and enabled line, most urgent first (lowest priority value, then
+	// lowest IRQn). Handlers do not nest: a line raised meanwhile waits for the current one.
+	void Dispatch()
+	{
+		do {
+			is_dispatching = 1;
+			std::atomic_signal_fence(std::memory_order_seq_cst);
+			for(;;)
+			{
+				uint64_t ready = pending.load() & enabled.load();
+				if(ready == 0) break;
+
+				int best = -1;
+				while(ready != 0)
+				{
+					const int i = __builtin_ctzll(ready);
+					ready &= ready - 1;
+					if(best < 0 || priority[i] < priority[best]) best = i;
+				}
+				pending.fetch_and(~(uint64_t{1} << best));
+				if(vector[best] != nullptr) vector[best]();
+			}
+			std::atomic_signal_fence(std::memory_order_seq_cst);
+			is_dispatching = 0;
+			std::atomic_signal_fence(std::memory_order_seq_cst);
+		} while(primask == 0 && (pending.load() & enabled.load()) != 0);
+	}
+	void Poll()
+	{
+		if(primask != 0 || is_dispatching != 0) return;
+		if((pending.load() & enabled.load()) != 0) Dispatch();
+	}
+	void OnSignal(int)
+	{
+		const int saved = errno;
+		Poll();
+		errno = saved;
+	}
+
+}
+
+DWT_Type emu_dwt = {};
+CoreDebug_Type emu_core_debug = {};
+SysTick_Type emu_systick = {0x7, emu_constants::kSysTickLoad, {}, 0};
+uint32_t SystemCoreClock = emu_constants::kHCLK;
+
+namespace emu {
+
+	/*----- Clock -----*/
+	double Clock::speed_ = 1.0;
+	int64_t Clock::origin_ns_ = 0;
+
+	void Clock::Init(double speed)
+	{
+		speed_ = speed;
+		origin_ns_ = HostNow();
+	}
+	int64_t Clock::HostNow()
+	{
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+	}
+	uint64_t Clock::Now()
+	{
+		const int64_t elapsed = HostNow() - origin_ns_;
+		if(speed_ == 1.0) return static_cast<uint64_t>(elapsed);
+		return static_cast<uint64_t>(static_cast<double>(elapsed) * speed_);
+	}
+	uint64_t Clock::Cycles()
+	{
+		return static_cast<uint64_t>(static_cast<unsigned __int128>(Now()) * SystemCoreClock / 1'000'000'000);
+	}
+	int64_t Clock::ToHost(uint64_t t)
+	{
+		if(speed_ == 1.0) return origin_ns_ + static_cast<int64_t>(t);
+		return origin_ns_ + static_cast<int64_t>(static_cast<double>(t) / speed_);
+	}
+	double Clock::GetSpeed() { return speed_; }
+
+	/*----- Core -----*/
+	Core::Section::Section() : primask_(GetPrimask()) { SetPrimask(1); }
+	Core::Section::~Section() { SetPrimask(primask_); }
+
+	void Core::Init()
+	{
+		cpu_thread = pthread_self();
+		is_cpu_thread = true;
+
+		struct sigaction action = {};
+		action.sa_handler = OnSignal;
+		action.sa_flags = SA_RESTART;
+		sigemptyset(&action.sa_mask);
+		sigaction(SIGUSR1, &action, nullptr);
+	}
+	void Core::SetVector(IRQn_Type irqn, VectorTypeDef handler)
+	{
+		if(Bit(irqn) != 0) vector[irqn] = handler;
+	}
+
+	void Core::SetPriority(IRQn_Type irqn, uint32_t preempt)
+	{
+		if(Bit(irqn) != 0) priority[irqn] = static_cast<uint8_t>(preempt);
+	}
+	void Core::Enable(IRQn_Type irqn)
+	{
+		enabled.fetch_or(Bit(irqn));
+		if(is_cpu_thread) Poll();
+	}
+	void Core::Disable(IRQn_Type irqn) { enabled.fetch_and(~Bit(irqn)); }
+	bool Core::IsEnabled(IRQn_Type irqn) { return (enabled.load() & Bit(irqn)) != 0; }
+	// A line raised from the CPU thread is taken as soon as PRIMASK allows; from the bus thread
+	// the CPU thread is signalled once per newly pending line.
+	void Core::Raise(IRQn_Type irqn)
+	{
+		const uint64_t bit = Bit(irqn);
+		if(bit == 0) return;
+
+		const uint64_t before = pending.fetch_or(bit);
+		if(is_cpu_thread) {
+			Poll();
+			return;
+		}
+		if((before & bit) == 0 && (enabled.load() & bit) != 0) pthread_kill(cpu_thread, SIGUSR1);
+	}
+
+	uint32_t Core::GetPrimask() { return static_cast<uint32_t>(primask); }
+	void Core::SetPrimask(uint32_t value)
+	{
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+		primask = (value != 0) ? 1 : 0;
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+		if(value == 0) Poll();
+	}
+	// Sleeps until a line is pending; with PRIMASK set it wakes without taking the interrupt
+	void Core::WaitForInterrupt()
+	{
+		sigset_t block, old;
+		sigemptyset(&block);
+		sigaddset(&block, SIGUSR1);
+		pthread_sigmask(SIG_BLOCK, &block, &old);
+		if((pending.load() & enabled.load()) == 0) sigsuspend(&old);
+		pthread_sigmask(SIG_SETMASK, &old, nullptr);
+		Poll();
+	}
+
+	/*----- Registers -----*/
+	CycleCountRegister::operator uint32_t() const { return static_cast<uint32_t>(Clock::Cycles()) - cycle_offset; }
+	CycleCountRegister& CycleCountRegister::operator=(uint32_t value)
+	{
+		cycle_offset = static_cast<uint32_t>(Clock::Cycles()) - value;
+		return *this;
+	}
+
+	SysTickValueRegister::operator uint32_t() const
+	{
+		return emu_constants::kSysTickLoad - static_cast<uint32_t>(Clock::Cycles() % (emu_constants::kSysTickLoad + 1));
+	}
+
+}
+
+/*----- CMSIS -----*/
+uint32_t __get_PRIMASK(void) { return emu::Core::GetPrimask(); }
+void __set_PRIMASK(uint32_t value) { emu::Core::SetPrimask(value); }
+void __disable_irq(void) { emu::Core::SetPrimask(1); }
+void __enable_irq(void) { emu::Core::SetPrimask(0); }
+void __WFI(void) { emu::Core::WaitForInterrupt(); }
+void __DSB(void) { std::atomic_thread_fence(std::memory_order_seq_cst); }
+uint32_t __get_MSP(void) { return emu_constants::kStackTop - 0x100; }
+
+/*----- HAL -----*/
+uint32_t HAL_GetTick(void) { return static_cast<uint32_t>(emu::Clock::Cycles() / (SystemCoreClock / 1000)); }
+void HAL_Delay(uint32_t delay)
+{
+	const uint32_t start = HAL_GetTick();
+	while(HAL_GetTick() - start < delay) sched_yield();
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void) { return SystemCoreClock; }
+uint32_t HAL_RCC_GetPCLK1Freq(void) { return emu_constants::kPCLK1; }
+uint32_t HAL_RCC_GetPCLK2Freq(void) { return emu_constants::kPCLK2; }
+void HAL_RCC_GetClockConfig(RCC_ClkInitTypeDef* config, uint32_t* latency)
+{
+	config->ClockType = 0xF;
+	config->SYSCLKSource = 0x2;
+	config->AHBCLKDivider = 0;
+	config->APB1CLKDivider = RCC_HCLK_DIV2;
+	config->APB2CLKDivider = RCC_HCLK_DIV1;
+	*latency = 3;
+}
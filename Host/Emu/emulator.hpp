@@ -0,0 +1,182 @@
+/*
+ * emulator.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * The board behind the emulated HAL (stm32f7xx_hal.h).
+ * The firmware runs unchanged on the CPU thread. Interrupts are SIGUSR1 sent to that thread and
+ * dispatched from the signal handler unless PRIMASK is set, so polling loops and WFI behave as
+ * on the part. The bus thread owns the peripherals' timing: CLKDEC edges, TIM4 updates, SPI
+ * transfer ends and UART bytes, all on a virtual clock that may run faster than real time.
+ */
+#ifndef HOST_EMU_EMULATOR_HPP_
+#define HOST_EMU_EMULATOR_HPP_
+
+#include "stm32f7xx_hal.h"
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+
+namespace emu_constants {
+
+	constexpr uint32_t kHCLK = 96'000'000;					// as SystemClock_Config(): HSE 8 MHz, PLL 96 MHz
+	constexpr uint32_t kPCLK1 = kHCLK / 2;
+	constexpr uint32_t kPCLK2 = kHCLK;
+	constexpr uint32_t kSysTickLoad = kHCLK / 1000 - 1;
+	constexpr size_t kRegisterCount = 128;
+	constexpr size_t kMaxTransfer = 1024;					// SPI bytes per transfer
+	constexpr size_t kRxQueueSize = 4096;					// UART bytes read from the pty, not yet received
+	constexpr size_t kTxSize = 0x1'0000;					// one HAL_UART_Transmit()
+	constexpr size_t kChipSelectCount = 2;
+	constexpr uint32_t kStackTop = 0x2008'0000;				// _estack
+	constexpr int64_t kSpinThreshold_ns = 20'000;			// host time below which the bus thread spins
+
+}
+
+namespace emu {
+
+	enum class WaveformTypeDef {
+		kSine,
+		kRamp,
+		kSquare,
+		kDC
+	};
+
+	// Input of the ADC. Levels are fractions of full scale before the PGA, whose gain is
+	// 2^(register 1 & 7); each chip select sees the waveform shifted by 1/8 period per index.
+	struct AdcModelTypeDef {
+		WaveformTypeDef waveform{WaveformTypeDef::kSine};
+		double amplitude{0.1};
+		double frequency{10.0};		// Hz
+		double noise{0.0};			// rms
+		double offset{0.0};
+		uint64_t seed{1};
+	};
+
+	struct BoardConfigTypeDef {
+		double speed{1.0};					// virtual seconds per real second
+		uint32_t baud{115200};				// 0: the UART is not paced
+		double clkdec_rate{1000.0};			// Hz of the free-running data-ready edges, 0: none
+		uint32_t conversion_ns{2000};		// CONVST to data-ready while TIM4 clocks the ADC
+		uint32_t max_sclk{25'000'000};		// faster transfers come back one bit early
+		AdcModelTypeDef adc;
+	};
+
+	/*----- Clock -----*/
+	class Clock {
+	private:
+		static double speed_;
+		static int64_t origin_ns_;
+
+	public:
+		Clock() = delete;
+
+		static void Init(double speed);
+
+		static int64_t HostNow();			// CLOCK_MONOTONIC ns
+		static uint64_t Now();				// virtual ns since Init()
+		static uint64_t Cycles();			// virtual HCLK cycles since Init()
+		static int64_t ToHost(uint64_t);	// CLOCK_MONOTONIC ns of a virtual time
+		static double GetSpeed();
+	};
+
+	/*----- Core -----*/
+	class Core {
+	public:
+		using VectorTypeDef = void (*)();
+
+		// PRIMASK set for the scope, as the firmware's CriticalSection
+		class Section {
+		private:
+			uint32_t primask_;
+
+		public:
+			Section();
+			~Section();
+			Section(const Section&) = delete;
+			Section& operator=(const Section&) = delete;
+		};
+
+		Core() = delete;
+
+		// On the CPU thread, before any interrupt is enabled
+		static void Init();
+		static void SetVector(IRQn_Type, VectorTypeDef);
+
+		// NVIC
+		static void SetPriority(IRQn_Type, uint32_t);
+		static void Enable(IRQn_Type);
+		static void Disable(IRQn_Type);
+		static bool IsEnabled(IRQn_Type);
+		static void Raise(IRQn_Type);		// from any thread
+
+		// PRIMASK and WFI
+		static uint32_t GetPrimask();
+		static void SetPrimask(uint32_t);
+		static void WaitForInterrupt();
+	};
+
+	/*----- Board -----*/
+	class Board {
+	public:
+		// Board state from the CPU thread: interrupts masked, then the bus thread locked out
+		class Lock {
+		private:
+			Core::Section section_;
+			std::unique_lock<std::mutex> lock_;
+
+		public:
+			Lock();
+		};
+
+	private:
+		static std::mutex mutex_;
+
+		friend class Lock;
+
+	public:
+		Board() = delete;
+
+		static void Init(const BoardConfigTypeDef&, int pty);
+		static void SetChipSelect(size_t, GPIO_TypeDef*, uint16_t);
+		static void Start();			// the bus thread; exits the process on SIGINT or SIGTERM
+		static void PrintStatistics();
+
+		// Called from the HAL with Lock held
+		static void OnNvicEnable(IRQn_Type);
+		static void OnTimerReload();
+		static void OnTimerRun(bool);
+		static void OnTimerInterrupt();
+
+		static HAL_StatusTypeDef StartTransfer(SPI_HandleTypeDef*, const uint8_t* tx, uint8_t* rx, uint16_t size);
+		static bool FinishTransfer(SPI_HandleTypeDef*);
+		static void AbortTransfer();
+
+		static bool Receive(uint8_t&);
+		static void OnReceiveArmed();
+		static uint32_t StartTransmit(const uint8_t*, uint16_t, bool is_it);
+		static bool FinishTransmit();
+		static void WaitTransmit(uint32_t sequence);		// without Lock
+	};
+
+	/*----- Flash -----*/
+	class Flash {
+	private:
+		static bool is_unlocked_;
+
+	public:
+		Flash() = delete;
+
+		// Maps the profile sector at its address, backed by `path` if not null
+		static bool Init(const char* path);
+
+		static HAL_StatusTypeDef Unlock();
+		static HAL_StatusTypeDef Lock();
+		static HAL_StatusTypeDef Program(uint32_t address, uint32_t word);
+		static HAL_StatusTypeDef Erase(uint32_t sector);
+	};
+
+}
+
+
+#endif /* HOST_EMU_EMULATOR_HPP_ */
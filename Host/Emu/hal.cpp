@@ -0,0 +1,406 @@
+/*
+ * hal.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * HAL functions of the emulator. Each one does what the F7 HAL does to the handle and leaves
+ * the timing to the board models; callbacks run outside Board::Lock, as from the IRQ handlers
+ * on the part.
+ */
+#include "emulator.hpp"
+#include <profile_store.hpp>
+extern "C" {
+#include "sysmem.h"
+}
+#include <fcntl.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+
+GPIO_TypeDef emu_gpio[11] = {};
+EXTI_TypeDef emu_exti = {};
+SPI_TypeDef emu_spi1 = {};
+USART_TypeDef emu_usart3 = {};
+CRC_TypeDef emu_crc = {};
+TIM_TypeDef emu_tim4 = {};
+
+namespace {
+
+	constexpr uint32_t kExti15_10 = 0xFC00;				// lines sharing EXTI15_10_IRQn
+	constexpr uint32_t kCrcPolynomial = 0xEDB8'8320;	// 0x04C11DB7 reflected
+	constexpr uint32_t kHeapStart = 0x2002'0000;		// _end
+	constexpr uint32_t kMinStackSize = 0x400;
+
+	uint32_t heap_peak = 0;
+
+	HAL_StatusTypeDef StartTransfer(SPI_HandleTypeDef* hspi, const uint8_t* tx, uint8_t* rx, uint16_t size, HAL_SPI_StateTypeDef state)
+	{
+		emu::Board::Lock lock;
+		if(hspi->State != HAL_SPI_STATE_READY) return HAL_BUSY;
+		if(size == 0 || (tx == nullptr && rx == nullptr)) return HAL_ERROR;
+
+		const auto status = emu::Board::StartTransfer(hspi, tx, rx, size);
+		if(status != HAL_OK) return status;
+		hspi->pTxBuffPtr = tx;
+		hspi->TxXferSize = size;
+		hspi->RxXferSize = size;
+		hspi->ErrorCode = 0;
+		hspi->State = state;
+		__HAL_SPI_ENABLE(hspi);
+		return HAL_OK;
+	}
+	HAL_StatusTypeDef StartTransmit(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size, bool is_it, uint32_t& sequence)
+	{
+		emu::Board::Lock lock;
+		if(huart->gState != HAL_UART_STATE_READY) return HAL_BUSY;
+		if(data == nullptr || size == 0) return HAL_ERROR;
+
+		huart->pTxBuffPtr = data;
+		huart->TxXferSize = size;
+		huart->gState = HAL_UART_STATE_BUSY_TX;
+		sequence = emu::Board::StartTransmit(data, size, is_it);
+		return HAL_OK;
+	}
+
+}
+
+namespace emu {
+
+	/*----- Registers -----*/
+	SoftwareInterruptRegister& SoftwareInterruptRegister::operator=(uint32_t lines)
+	{
+		Board::Lock lock;
+		EXTI->PR = EXTI->PR | lines;
+		if(lines & kExti15_10) Core::Raise(EXTI15_10_IRQn);
+		return *this;
+	}
+	EventGenerationRegister& EventGenerationRegister::operator=(uint32_t events)
+	{
+		if(events & TIM_EGR_UG) {
+			Board::Lock lock;
+			Board::OnTimerReload();
+		}
+		return *this;
+	}
+
+	void CrcDataRegister::Feed(uint8_t data)
+	{
+		crc_ ^= data;
+		for(int i = 0; i < 8; ++i) crc_ = (crc_ >> 1) ^ (kCrcPolynomial & (0u - (crc_ & 1)));
+	}
+	void CrcDataRegister::FlushLane()
+	{
+		if(!is_lane_written_) return;
+		is_lane_written_ = false;
+		Feed(lane_);
+	}
+	// With the input reflected by byte and the output reflected, DR is the state of the
+	// usual LSB-first CRC-32 and a word is its four bytes MSB first
+	CrcDataRegister::operator uint32_t()
+	{
+		FlushLane();
+		return crc_;
+	}
+	CrcDataRegister& CrcDataRegister::operator=(uint32_t word)
+	{
+		FlushLane();
+		for(int shift = 24; shift >= 0; shift -= 8) Feed(static_cast<uint8_t>(word >> shift));
+		return *this;
+	}
+	volatile uint8_t* CrcDataRegister::operator&()
+	{
+		FlushLane();
+		is_lane_written_ = true;
+		return &lane_;
+	}
+	void CrcDataRegister::Reset()
+	{
+		is_lane_written_ = false;
+		crc_ = 0xFFFF'FFFF;
+	}
+
+	/*----- Flash -----*/
+	bool Flash::is_unlocked_ = false;
+
+	bool Flash::Init(const char* path)
+	{
+		int fd = -1;
+		off_t size = 0;
+		if(path != nullptr)
+		{
+			fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+			struct stat st;
+			if(fd < 0 || ::fstat(fd, &st) != 0) return false;
+			size = st.st_size;
+			if(size < profile_constants::kSize && ::ftruncate(fd, profile_constants::kSize) != 0) return false;
+		}
+
+		void* const address = reinterpret_cast<void*>(uintptr_t{profile_constants::kAddress});
+		const int flags = MAP_FIXED_NOREPLACE | ((fd < 0) ? (MAP_PRIVATE | MAP_ANONYMOUS) : MAP_SHARED);
+		void* const p = ::mmap(address, profile_constants::kSize, PROT_READ | PROT_WRITE, flags, fd, 0);
+		if(fd >= 0) ::close(fd);
+		if(p != address) return false;
+
+		// New flash is erased
+		if(size < profile_constants::kSize) std::memset(static_cast<uint8_t*>(p) + size, 0xFF, profile_constants::kSize - size);
+		return true;
+	}
+	HAL_StatusTypeDef Flash::Unlock()
+	{
+		is_unlocked_ = true;
+		return HAL_OK;
+	}
+	HAL_StatusTypeDef Flash::Lock()
+	{
+		is_unlocked_ = false;
+		return HAL_OK;
+	}
+	// Programming can only clear bits
+	HAL_StatusTypeDef Flash::Program(uint32_t address, uint32_t word)
+	{
+		if(!is_unlocked_) return HAL_ERROR;
+		if(address % sizeof(uint32_t) != 0 || address < profile_constants::kAddress ||
+			address - profile_constants::kAddress > profile_constants::kSize - sizeof(uint32_t)) return HAL_ERROR;
+
+		auto* const p = reinterpret_cast<uint32_t*>(uintptr_t{address});
+		*p &= word;
+		return HAL_OK;
+	}
+	HAL_StatusTypeDef Flash::Erase(uint32_t sector)
+	{
+		if(!is_unlocked_ || sector != profile_constants::kSector) return HAL_ERROR;
+		std::memset(reinterpret_cast<void*>(uintptr_t{profile_constants::kAddress}), 0xFF, profile_constants::kSize);
+		return HAL_OK;
+	}
+
+}
+
+/*----- NVIC -----*/
+void HAL_NVIC_SetPriority(IRQn_Type irqn, uint32_t preempt, uint32_t) { emu::Core::SetPriority(irqn, preempt); }
+void HAL_NVIC_EnableIRQ(IRQn_Type irqn)
+{
+	emu::Board::Lock lock;
+	emu::Board::OnNvicEnable(irqn);
+	emu::Core::Enable(irqn);
+}
+void HAL_NVIC_DisableIRQ(IRQn_Type irqn) { emu::Core::Disable(irqn); }
+
+/*----- GPIO -----*/
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state)
+{
+	emu::Core::Section section;
+	if(state == GPIO_PIN_SET) port->ODR = port->ODR | pin;
+	else port->ODR = port->ODR & ~uint32_t{pin};
+}
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* port, uint16_t pin) { return (port->IDR & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET; }
+void HAL_GPIO_EXTI_IRQHandler(uint16_t pin)
+{
+	{
+		emu::Board::Lock lock;
+		if((EXTI->PR & pin) == 0) return;
+		EXTI->PR = EXTI->PR & ~uint32_t{pin};
+	}
+	HAL_GPIO_EXTI_Callback(pin);
+}
+
+/*----- SPI -----*/
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef* hspi)
+{
+	hspi->Instance->CR1 = hspi->Init.Mode | hspi->Init.Direction | hspi->Init.BaudRatePrescaler |
+		hspi->Init.CLKPolarity | hspi->Init.CLKPhase | hspi->Init.FirstBit;
+	hspi->Instance->CR2 = hspi->Init.DataSize;
+	hspi->State = HAL_SPI_STATE_READY;
+	hspi->ErrorCode = 0;
+	return HAL_OK;
+}
+HAL_StatusTypeDef HAL_SPI_Transmit_IT(SPI_HandleTypeDef* hspi, const uint8_t* tx, uint16_t size)
+{
+	return StartTransfer(hspi, tx, nullptr, size, HAL_SPI_STATE_BUSY_TX);
+}
+HAL_StatusTypeDef HAL_SPI_Receive_IT(SPI_HandleTypeDef* hspi, uint8_t* rx, uint16_t size)
+{
+	return StartTransfer(hspi, nullptr, rx, size, HAL_SPI_STATE_BUSY_RX);
+}
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_IT(SPI_HandleTypeDef* hspi, const uint8_t* tx, uint8_t* rx, uint16_t size)
+{
+	if(tx == nullptr || rx == nullptr) return HAL_ERROR;
+	return StartTransfer(hspi, tx, rx, size, HAL_SPI_STATE_BUSY_TX_RX);
+}
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef* hspi)
+{
+	emu::Board::Lock lock;
+	emu::Board::AbortTransfer();
+	hspi->State = HAL_SPI_STATE_READY;
+	return HAL_OK;
+}
+HAL_SPI_StateTypeDef HAL_SPI_GetState(SPI_HandleTypeDef* hspi) { return hspi->State; }
+void HAL_SPI_IRQHandler(SPI_HandleTypeDef* hspi)
+{
+	HAL_SPI_StateTypeDef state;
+	{
+		emu::Board::Lock lock;
+		if(!emu::Board::FinishTransfer(hspi)) return;
+		state = hspi->State;
+		hspi->State = HAL_SPI_STATE_READY;
+	}
+	if(state == HAL_SPI_STATE_BUSY_TX) HAL_SPI_TxCpltCallback(hspi);
+	else if(state == HAL_SPI_STATE_BUSY_RX) HAL_SPI_RxCpltCallback(hspi);
+	else if(state == HAL_SPI_STATE_BUSY_TX_RX) HAL_SPI_TxRxCpltCallback(hspi);
+}
+
+/*----- UART -----*/
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef* huart)
+{
+	huart->gState = HAL_UART_STATE_READY;
+	huart->RxState = HAL_UART_STATE_READY;
+	huart->ErrorCode = 0;
+	return HAL_OK;
+}
+// Blocks until the last character is out; a reader that stops draining the pty stalls it
+// rather than timing it out, so nothing is lost
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size, uint32_t)
+{
+	uint32_t sequence;
+	if(const auto state = StartTransmit(huart, data, size, false, sequence); state != HAL_OK) return state;
+	emu::Board::WaitTransmit(sequence);
+	huart->gState = HAL_UART_STATE_READY;
+	return HAL_OK;
+}
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size)
+{
+	uint32_t sequence;
+	return StartTransmit(huart, data, size, true, sequence);
+}
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef* huart, uint8_t* data, uint16_t size)
+{
+	emu::Board::Lock lock;
+	if(huart->RxState != HAL_UART_STATE_READY) return HAL_BUSY;
+	if(data == nullptr || size == 0) return HAL_ERROR;
+
+	huart->pRxBuffPtr = data;
+	huart->RxXferSize = size;
+	huart->RxXferCount = size;
+	huart->RxState = HAL_UART_STATE_BUSY_RX;
+	emu::Board::OnReceiveArmed();
+	return HAL_OK;
+}
+void HAL_UART_IRQHandler(UART_HandleTypeDef* huart)
+{
+	bool is_received = false;
+	bool is_transmitted = false;
+	{
+		emu::Board::Lock lock;
+		if(uint8_t c; huart->RxState == HAL_UART_STATE_BUSY_RX && emu::Board::Receive(c)) {
+			*huart->pRxBuffPtr++ = c;
+			huart->RxXferCount = huart->RxXferCount - 1;
+			if(huart->RxXferCount == 0) {
+				huart->RxState = HAL_UART_STATE_READY;
+				is_received = true;
+			}
+		}
+		if(emu::Board::FinishTransmit()) {
+			huart->gState = HAL_UART_STATE_READY;
+			is_transmitted = true;
+		}
+	}
+	if(is_received) HAL_UART_RxCpltCallback(huart);
+	if(is_transmitted) HAL_UART_TxCpltCallback(huart);
+}
+
+/*----- TIM -----*/
+HAL_StatusTypeDef HAL_TIM_PWM_Init(TIM_HandleTypeDef* htim)
+{
+	htim->Instance->PSC = htim->Init.Prescaler;
+	htim->Instance->ARR = htim->Init.Period;
+	return HAL_OK;
+}
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef* htim, uint32_t)
+{
+	emu::Board::Lock lock;
+	htim->Instance->CR1 = htim->Instance->CR1 | TIM_CR1_CEN;
+	emu::Board::OnTimerRun(true);
+	return HAL_OK;
+}
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef* htim, uint32_t)
+{
+	emu::Board::Lock lock;
+	htim->Instance->CR1 = htim->Instance->CR1 & ~TIM_CR1_CEN;
+	emu::Board::OnTimerRun(false);
+	return HAL_OK;
+}
+void HAL_TIM_IRQHandler(TIM_HandleTypeDef* htim)
+{
+	{
+		emu::Board::Lock lock;
+		if((htim->Instance->SR & TIM_SR_UIF) == 0 || (htim->Instance->DIER & TIM_DIER_UIE) == 0) return;
+		htim->Instance->SR = htim->Instance->SR & ~TIM_SR_UIF;
+	}
+	HAL_TIM_PeriodElapsedCallback(htim);
+}
+void emu_tim_enable_it(TIM_HandleTypeDef* htim, uint32_t interrupt)
+{
+	emu::Board::Lock lock;
+	htim->Instance->DIER = htim->Instance->DIER | interrupt;
+	emu::Board::OnTimerInterrupt();
+	if(htim->Instance->SR & htim->Instance->DIER & TIM_SR_UIF) emu::Core::Raise(TIM4_IRQn);
+}
+void emu_tim_disable_it(TIM_HandleTypeDef* htim, uint32_t interrupt)
+{
+	emu::Board::Lock lock;
+	htim->Instance->DIER = htim->Instance->DIER & ~interrupt;
+}
+void emu_tim_clear_flag(TIM_HandleTypeDef* htim, uint32_t flag)
+{
+	emu::Board::Lock lock;
+	htim->Instance->SR = htim->Instance->SR & ~flag;
+}
+
+/*----- FLASH -----*/
+HAL_StatusTypeDef HAL_FLASH_Unlock(void) { return emu::Flash::Unlock(); }
+HAL_StatusTypeDef HAL_FLASH_Lock(void) { return emu::Flash::Lock(); }
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t type, uint32_t address, uint64_t data)
+{
+	if(type != FLASH_TYPEPROGRAM_WORD) return HAL_ERROR;
+	return emu::Flash::Program(address, static_cast<uint32_t>(data));
+}
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef* erase, uint32_t* sector_error)
+{
+	*sector_error = 0xFFFF'FFFF;
+	for(uint32_t i = 0; i < erase->NbSectors; ++i)
+	{
+		if(emu::Flash::Erase(erase->Sector + i) != HAL_OK) {
+			*sector_error = erase->Sector + i;
+			return HAL_ERROR;
+		}
+	}
+	return HAL_OK;
+}
+
+/*----- Heap -----*/
+// The host heap, laid out as if it were the part's: _end, then the heap, then the stack
+void sbrk_get_statistics(sbrk_statistics_t* statistics)
+{
+	const struct mallinfo2 info = mallinfo2();
+	const auto used = static_cast<uint32_t>(std::min<size_t>(info.arena + info.hblkhd, UINT32_MAX));
+	heap_peak = std::max(heap_peak, used);
+
+	statistics->used = used;
+	statistics->peak = heap_peak;
+	statistics->limit = emu_constants::kStackTop - kMinStackSize - kHeapStart;
+	statistics->end = kHeapStart + used;
+	statistics->call_count = 0;
+	statistics->fail_count = 0;
+}
+
+/*----- Callbacks -----*/
+__attribute__((weak)) void HAL_GPIO_EXTI_Callback(uint16_t) {}
+__attribute__((weak)) void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef*) {}
+__attribute__((weak)) void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef*) {}
+__attribute__((weak)) void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef*) {}
+__attribute__((weak)) void HAL_SPI_ErrorCallback(SPI_HandleTypeDef*) {}
+__attribute__((weak)) void HAL_UART_TxCpltCallback(UART_HandleTypeDef*) {}
+__attribute__((weak)) void HAL_UART_RxCpltCallback(UART_HandleTypeDef*) {}
+__attribute__((weak)) void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef*) {}
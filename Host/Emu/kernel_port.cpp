@@ -0,0 +1,42 @@
+/*
+ * kernel_port.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Task switch of the kernel (kernel.hpp) for fw_emu: one ucontext per task. The tasks run on
+ * host stacks of their own rather than the firmware's, since interrupts are signal handlers
+ * that run on whatever stack is current and a signal frame alone outgrows the firmware's
+ * stacks. TASKS reports no stack use here for the same reason.
+ */
+#include <kernel.hpp>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+	constexpr size_t kHostStackSize = 256 * 1024;
+
+	std::array<ucontext_t, kernel_constants::kMaxTask + 1> context;
+
+}
+
+void kernel_port_prepare(size_t slot, std::span<uint32_t>, void (*entry)())
+{
+	// Mapped rather than allocated, so HEAP keeps reporting the firmware's own heap
+	void* stack = mmap(nullptr, kHostStackSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+	if(stack == MAP_FAILED || getcontext(&context[slot]) != 0) {
+		std::perror("kernel_port_prepare");
+		std::abort();
+	}
+	context[slot].uc_stack.ss_sp = stack;
+	context[slot].uc_stack.ss_size = kHostStackSize;
+	context[slot].uc_link = nullptr;
+	makecontext(&context[slot], entry, 0);
+}
+void kernel_port_switch(size_t from, size_t to)
+{
+	swapcontext(&context[from], &context[to]);
+}
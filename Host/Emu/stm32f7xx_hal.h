@@ -0,0 +1,502 @@
+/*
+ * stm32f7xx_hal.h
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Emulated HAL and CMSIS for building the firmware on Linux (see Host/Src/fw_emu.cpp).
+ * Found through -IHost/Emu in place of the STM32F7 HAL, so Core/Src builds unchanged.
+ * Only what the firmware and fw_emu use is declared; names, values and handle fields follow
+ * the real HAL. Registers whose accesses have side effects (DWT->CYCCNT, SysTick->VAL,
+ * EXTI->SWIER, TIM->EGR, CRC->DR) are small classes, the rest are plain memory.
+ */
+#ifndef HOST_EMU_STM32F7XX_HAL_H_
+#define HOST_EMU_STM32F7XX_HAL_H_
+
+#ifndef __cplusplus
+#error "the emulated HAL is C++ only"
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define __IO volatile
+
+extern "C" {
+
+/*----- Common -----*/
+typedef enum {
+	HAL_OK			= 0x00U,
+	HAL_ERROR		= 0x01U,
+	HAL_BUSY		= 0x02U,
+	HAL_TIMEOUT		= 0x03U
+} HAL_StatusTypeDef;
+
+#define SET_BIT(REG, BIT)						((REG) = (REG) | (BIT))
+#define CLEAR_BIT(REG, BIT)						((REG) = (REG) & ~(BIT))
+#define READ_BIT(REG, BIT)						((REG) & (BIT))
+#define WRITE_REG(REG, VAL)						((REG) = (VAL))
+#define READ_REG(REG)							((REG))
+#define MODIFY_REG(REG, CLEARMASK, SETMASK)		WRITE_REG((REG), (((READ_REG(REG)) & (~(CLEARMASK))) | (SETMASK)))
+
+typedef struct __TIM_TypeDef TIM_TypeDef;
+
+extern "C++" {
+namespace emu {
+
+	// DWT->CYCCNT: HCLK cycles of the virtual clock
+	class CycleCountRegister {
+	public:
+		operator uint32_t() const;
+		CycleCountRegister& operator=(uint32_t);
+	};
+	// SysTick->VAL: counts down from LOAD once per millisecond of the virtual clock
+	class SysTickValueRegister {
+	public:
+		operator uint32_t() const;
+	};
+	// EXTI->SWIER: setting a line's bit raises it as an edge would
+	class SoftwareInterruptRegister {
+	public:
+		SoftwareInterruptRegister& operator=(uint32_t);
+	};
+	// TIM->EGR: UG restarts the counter with the current PSC and ARR
+	class EventGenerationRegister {
+	public:
+		EventGenerationRegister& operator=(uint32_t);
+	};
+	// CRC->DR: word writes, reads, and byte writes through a uint8_t pointer to DR as the HAL
+	// does them. &DR hands out a byte lane that is fed to the CRC at the next access.
+	class CrcDataRegister {
+	private:
+		uint32_t crc_{0xFFFF'FFFF};
+		uint8_t lane_{0};
+		bool is_lane_written_{false};
+
+		void Feed(uint8_t);
+		void FlushLane();
+
+	public:
+		operator uint32_t();
+		CrcDataRegister& operator=(uint32_t);
+		volatile uint8_t* operator&();
+		void Reset();
+	};
+
+}
+}
+
+/*----- Cortex-M7 -----*/
+typedef enum {
+	SysTick_IRQn		= -1,
+	TIM4_IRQn			= 30,
+	SPI1_IRQn			= 35,
+	USART3_IRQn			= 39,
+	EXTI15_10_IRQn		= 40,
+	ETH_IRQn			= 61,
+	OTG_FS_IRQn			= 67
+} IRQn_Type;
+
+typedef struct {
+	__IO uint32_t CTRL;
+	emu::CycleCountRegister CYCCNT;
+	__IO uint32_t CPICNT;
+	__IO uint32_t EXCCNT;
+	__IO uint32_t SLEEPCNT;
+	__IO uint32_t LSUCNT;
+	__IO uint32_t FOLDCNT;
+	__IO uint32_t PCSR;
+	__IO uint32_t LAR;
+} DWT_Type;
+typedef struct {
+	__IO uint32_t DHCSR;
+	__IO uint32_t DCRSR;
+	__IO uint32_t DCRDR;
+	__IO uint32_t DEMCR;
+} CoreDebug_Type;
+typedef struct {
+	__IO uint32_t CTRL;
+	__IO uint32_t LOAD;
+	emu::SysTickValueRegister VAL;
+	__IO uint32_t CALIB;
+} SysTick_Type;
+
+extern DWT_Type emu_dwt;
+extern CoreDebug_Type emu_core_debug;
+extern SysTick_Type emu_systick;
+#define DWT			(&emu_dwt)
+#define CoreDebug	(&emu_core_debug)
+#define SysTick		(&emu_systick)
+
+#define DWT_CTRL_CYCCNTENA_Msk			(1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk		(1UL << 24)
+#define NVIC_PRIORITYGROUP_4			0x00000003U
+
+// PRIMASK masks the emulated interrupts; see emu::Core
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t);
+void __disable_irq(void);
+void __enable_irq(void);
+void __WFI(void);
+void __DSB(void);
+uint32_t __get_MSP(void);
+static inline uint32_t __REV(uint32_t value) { return __builtin_bswap32(value); }
+
+extern uint32_t SystemCoreClock;
+
+void HAL_NVIC_SetPriority(IRQn_Type, uint32_t, uint32_t);
+void HAL_NVIC_EnableIRQ(IRQn_Type);
+void HAL_NVIC_DisableIRQ(IRQn_Type);
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t);
+
+/*----- RCC -----*/
+typedef struct {
+	uint32_t ClockType;
+	uint32_t SYSCLKSource;
+	uint32_t AHBCLKDivider;
+	uint32_t APB1CLKDivider;
+	uint32_t APB2CLKDivider;
+} RCC_ClkInitTypeDef;
+
+#define RCC_HCLK_DIV1		0x00000000U
+#define RCC_HCLK_DIV2		0x00001000U
+#define RCC_HCLK_DIV4		0x00001400U
+
+uint32_t HAL_RCC_GetHCLKFreq(void);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+uint32_t HAL_RCC_GetPCLK2Freq(void);
+void HAL_RCC_GetClockConfig(RCC_ClkInitTypeDef*, uint32_t*);
+
+/*----- GPIO / EXTI -----*/
+typedef struct {
+	__IO uint32_t MODER;
+	__IO uint32_t OTYPER;
+	__IO uint32_t OSPEEDR;
+	__IO uint32_t PUPDR;
+	__IO uint32_t IDR;
+	__IO uint32_t ODR;
+	__IO uint32_t BSRR;
+	__IO uint32_t LCKR;
+	__IO uint32_t AFR[2];
+} GPIO_TypeDef;
+typedef struct {
+	__IO uint32_t IMR;
+	__IO uint32_t EMR;
+	__IO uint32_t RTSR;
+	__IO uint32_t FTSR;
+	emu::SoftwareInterruptRegister SWIER;
+	__IO uint32_t PR;
+} EXTI_TypeDef;
+
+extern GPIO_TypeDef emu_gpio[11];
+extern EXTI_TypeDef emu_exti;
+#define GPIOA	(&emu_gpio[0])
+#define GPIOB	(&emu_gpio[1])
+#define GPIOC	(&emu_gpio[2])
+#define GPIOD	(&emu_gpio[3])
+#define GPIOE	(&emu_gpio[4])
+#define GPIOF	(&emu_gpio[5])
+#define GPIOG	(&emu_gpio[6])
+#define GPIOH	(&emu_gpio[7])
+#define EXTI	(&emu_exti)
+
+typedef enum {
+	GPIO_PIN_RESET = 0,
+	GPIO_PIN_SET
+} GPIO_PinState;
+
+#define GPIO_PIN_0		((uint16_t)0x0001)
+#define GPIO_PIN_1		((uint16_t)0x0002)
+#define GPIO_PIN_2		((uint16_t)0x0004)
+#define GPIO_PIN_3		((uint16_t)0x0008)
+#define GPIO_PIN_4		((uint16_t)0x0010)
+#define GPIO_PIN_5		((uint16_t)0x0020)
+#define GPIO_PIN_6		((uint16_t)0x0040)
+#define GPIO_PIN_7		((uint16_t)0x0080)
+#define GPIO_PIN_8		((uint16_t)0x0100)
+#define GPIO_PIN_9		((uint16_t)0x0200)
+#define GPIO_PIN_10		((uint16_t)0x0400)
+#define GPIO_PIN_11		((uint16_t)0x0800)
+#define GPIO_PIN_12		((uint16_t)0x1000)
+#define GPIO_PIN_13		((uint16_t)0x2000)
+#define GPIO_PIN_14		((uint16_t)0x4000)
+#define GPIO_PIN_15		((uint16_t)0x8000)
+
+void HAL_GPIO_WritePin(GPIO_TypeDef*, uint16_t, GPIO_PinState);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef*, uint16_t);
+void HAL_GPIO_EXTI_IRQHandler(uint16_t);
+void HAL_GPIO_EXTI_Callback(uint16_t);
+
+/*----- SPI -----*/
+typedef struct {
+	__IO uint32_t CR1;
+	__IO uint32_t CR2;
+	__IO uint32_t SR;
+	__IO uint32_t DR;
+	__IO uint32_t CRCPR;
+	__IO uint32_t RXCRCR;
+	__IO uint32_t TXCRCR;
+	__IO uint32_t I2SCFGR;
+	__IO uint32_t I2SPR;
+} SPI_TypeDef;
+typedef struct {
+	uint32_t Mode;
+	uint32_t Direction;
+	uint32_t DataSize;
+	uint32_t CLKPolarity;
+	uint32_t CLKPhase;
+	uint32_t NSS;
+	uint32_t BaudRatePrescaler;
+	uint32_t FirstBit;
+	uint32_t TIMode;
+	uint32_t CRCCalculation;
+	uint32_t CRCPolynomial;
+	uint32_t CRCLength;
+	uint32_t NSSPMode;
+} SPI_InitTypeDef;
+typedef enum {
+	HAL_SPI_STATE_RESET			= 0x00U,
+	HAL_SPI_STATE_READY			= 0x01U,
+	HAL_SPI_STATE_BUSY			= 0x02U,
+	HAL_SPI_STATE_BUSY_TX		= 0x03U,
+	HAL_SPI_STATE_BUSY_RX		= 0x04U,
+	HAL_SPI_STATE_BUSY_TX_RX	= 0x05U,
+	HAL_SPI_STATE_ERROR			= 0x06U,
+	HAL_SPI_STATE_ABORT			= 0x07U
+} HAL_SPI_StateTypeDef;
+typedef struct __SPI_HandleTypeDef {
+	SPI_TypeDef* Instance;
+	SPI_InitTypeDef Init;
+	const uint8_t* pTxBuffPtr;
+	uint16_t TxXferSize;
+	uint8_t* pRxBuffPtr;
+	uint16_t RxXferSize;
+	__IO HAL_SPI_StateTypeDef State;
+	__IO uint32_t ErrorCode;
+} SPI_HandleTypeDef;
+
+extern SPI_TypeDef emu_spi1;
+#define SPI1	(&emu_spi1)
+
+#define SPI_CR1_BR_Pos					3U
+#define SPI_CR1_BR						(0x7UL << SPI_CR1_BR_Pos)
+#define SPI_CR1_SPE						(1UL << 6)
+#define SPI_CR1_RXONLY					(1UL << 10)
+#define SPI_CR2_DS_Pos					8U
+#define SPI_CR2_DS						(0xFUL << SPI_CR2_DS_Pos)
+
+#define SPI_MODE_MASTER					(0x00000104U)
+#define SPI_DIRECTION_2LINES			(0x00000000U)
+#define SPI_DIRECTION_2LINES_RXONLY		SPI_CR1_RXONLY
+#define SPI_DATASIZE_8BIT				(0x00000700U)
+#define SPI_POLARITY_LOW				(0x00000000U)
+#define SPI_PHASE_1EDGE					(0x00000000U)
+#define SPI_NSS_SOFT					(0x00000200U)
+#define SPI_FIRSTBIT_MSB				(0x00000000U)
+#define SPI_BAUDRATEPRESCALER_2			(0x00000000U)
+#define SPI_BAUDRATEPRESCALER_4			(0x00000008U)
+#define SPI_BAUDRATEPRESCALER_8			(0x00000010U)
+#define SPI_BAUDRATEPRESCALER_16		(0x00000018U)
+#define SPI_BAUDRATEPRESCALER_32		(0x00000020U)
+#define SPI_BAUDRATEPRESCALER_64		(0x00000028U)
+#define SPI_BAUDRATEPRESCALER_128		(0x00000030U)
+#define SPI_BAUDRATEPRESCALER_256		(0x00000038U)
+
+#define __HAL_SPI_ENABLE(__HANDLE__)	SET_BIT((__HANDLE__)->Instance->CR1, SPI_CR1_SPE)
+#define __HAL_SPI_DISABLE(__HANDLE__)	CLEAR_BIT((__HANDLE__)->Instance->CR1, SPI_CR1_SPE)
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef*);
+HAL_StatusTypeDef HAL_SPI_Transmit_IT(SPI_HandleTypeDef*, const uint8_t*, uint16_t);
+HAL_StatusTypeDef HAL_SPI_Receive_IT(SPI_HandleTypeDef*, uint8_t*, uint16_t);
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_IT(SPI_HandleTypeDef*, const uint8_t*, uint8_t*, uint16_t);
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef*);
+HAL_SPI_StateTypeDef HAL_SPI_GetState(SPI_HandleTypeDef*);
+void HAL_SPI_IRQHandler(SPI_HandleTypeDef*);
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef*);
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef*);
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef*);
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef*);
+
+/*----- UART -----*/
+typedef struct {
+	__IO uint32_t CR1;
+	__IO uint32_t CR2;
+	__IO uint32_t CR3;
+	__IO uint32_t BRR;
+	__IO uint32_t GTPR;
+	__IO uint32_t RTOR;
+	__IO uint32_t RQR;
+	__IO uint32_t ISR;
+	__IO uint32_t ICR;
+	__IO uint32_t RDR;
+	__IO uint32_t TDR;
+} USART_TypeDef;
+typedef struct {
+	uint32_t BaudRate;
+	uint32_t WordLength;
+	uint32_t StopBits;
+	uint32_t Parity;
+	uint32_t Mode;
+	uint32_t HwFlowCtl;
+	uint32_t OverSampling;
+	uint32_t OneBitSampling;
+} UART_InitTypeDef;
+typedef uint32_t HAL_UART_StateTypeDef;
+typedef struct __UART_HandleTypeDef {
+	USART_TypeDef* Instance;
+	UART_InitTypeDef Init;
+	const uint8_t* pTxBuffPtr;
+	uint16_t TxXferSize;
+	uint8_t* pRxBuffPtr;
+	uint16_t RxXferSize;
+	__IO uint16_t RxXferCount;
+	__IO HAL_UART_StateTypeDef gState;
+	__IO HAL_UART_StateTypeDef RxState;
+	__IO uint32_t ErrorCode;
+} UART_HandleTypeDef;
+
+extern USART_TypeDef emu_usart3;
+#define USART3	(&emu_usart3)
+
+#define HAL_UART_STATE_RESET		0x00000000U
+#define HAL_UART_STATE_READY		0x00000020U
+#define HAL_UART_STATE_BUSY_TX		0x00000021U
+#define HAL_UART_STATE_BUSY_RX		0x00000022U
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef*);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef*, const uint8_t*, uint16_t, uint32_t);
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef*, const uint8_t*, uint16_t);
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef*, uint8_t*, uint16_t);
+void HAL_UART_IRQHandler(UART_HandleTypeDef*);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef*);
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef*);
+
+/*----- CRC -----*/
+typedef struct {
+	emu::CrcDataRegister DR;
+	__IO uint32_t IDR;
+	__IO uint32_t CR;
+	__IO uint32_t INIT;
+	__IO uint32_t POL;
+} CRC_TypeDef;
+typedef struct {
+	uint8_t DefaultPolynomialUse;
+	uint8_t DefaultInitValueUse;
+	uint32_t GeneratingPolynomial;
+	uint32_t CRCLength;
+	uint32_t InitValue;
+	uint32_t InputDataInversionMode;
+	uint32_t OutputDataInversionMode;
+} CRC_InitTypeDef;
+typedef struct {
+	CRC_TypeDef* Instance;
+	CRC_InitTypeDef Init;
+	uint32_t InputDataFormat;
+} CRC_HandleTypeDef;
+
+extern CRC_TypeDef emu_crc;
+#define CRC		(&emu_crc)
+
+// Only the configuration of MX_CRC_Init() is emulated: CRC-32, bytes reflected in and out
+#define DEFAULT_POLYNOMIAL_ENABLE			((uint8_t)0x00U)
+#define DEFAULT_INIT_VALUE_ENABLE			((uint8_t)0x00U)
+#define CRC_INPUTDATA_INVERSION_BYTE		(1UL << 5)
+#define CRC_OUTPUTDATA_INVERSION_ENABLE		(1UL << 7)
+#define CRC_INPUTDATA_FORMAT_BYTES			0x00000001U
+
+#define __HAL_CRC_DR_RESET(__HANDLE__)		((__HANDLE__)->Instance->DR.Reset())
+
+/*----- TIM -----*/
+struct __TIM_TypeDef {
+	__IO uint32_t CR1;
+	__IO uint32_t CR2;
+	__IO uint32_t SMCR;
+	__IO uint32_t DIER;
+	__IO uint32_t SR;
+	emu::EventGenerationRegister EGR;
+	__IO uint32_t CCMR1;
+	__IO uint32_t CCMR2;
+	__IO uint32_t CCER;
+	__IO uint32_t CNT;
+	__IO uint32_t PSC;
+	__IO uint32_t ARR;
+	__IO uint32_t RCR;
+	__IO uint32_t CCR1;
+	__IO uint32_t CCR2;
+	__IO uint32_t CCR3;
+	__IO uint32_t CCR4;
+};
+typedef struct {
+	uint32_t Prescaler;
+	uint32_t CounterMode;
+	uint32_t Period;
+	uint32_t ClockDivision;
+	uint32_t RepetitionCounter;
+	uint32_t AutoReloadPreload;
+} TIM_Base_InitTypeDef;
+typedef struct {
+	TIM_TypeDef* Instance;
+	TIM_Base_InitTypeDef Init;
+} TIM_HandleTypeDef;
+
+extern TIM_TypeDef emu_tim4;
+#define TIM4	(&emu_tim4)
+
+#define TIM_CR1_CEN				(1UL << 0)
+#define TIM_SR_UIF				(1UL << 0)
+#define TIM_DIER_UIE			(1UL << 0)
+#define TIM_EGR_UG				(1UL << 0)
+#define TIM_FLAG_UPDATE			TIM_SR_UIF
+#define TIM_IT_UPDATE			TIM_DIER_UIE
+#define TIM_CHANNEL_1			0x00000000U
+#define TIM_COUNTERMODE_UP		0x00000000U
+
+// The update flag and interrupt enable are also known to the timer model
+void emu_tim_enable_it(TIM_HandleTypeDef*, uint32_t);
+void emu_tim_disable_it(TIM_HandleTypeDef*, uint32_t);
+void emu_tim_clear_flag(TIM_HandleTypeDef*, uint32_t);
+#define __HAL_TIM_ENABLE_IT(__HANDLE__, __INTERRUPT__)			emu_tim_enable_it((__HANDLE__), (__INTERRUPT__))
+#define __HAL_TIM_DISABLE_IT(__HANDLE__, __INTERRUPT__)			emu_tim_disable_it((__HANDLE__), (__INTERRUPT__))
+#define __HAL_TIM_CLEAR_FLAG(__HANDLE__, __FLAG__)				emu_tim_clear_flag((__HANDLE__), (__FLAG__))
+#define __HAL_TIM_SET_PRESCALER(__HANDLE__, __PRESC__)			((__HANDLE__)->Instance->PSC = (__PRESC__))
+#define __HAL_TIM_SET_AUTORELOAD(__HANDLE__, __AUTORELOAD__)	\
+	do { (__HANDLE__)->Instance->ARR = (__AUTORELOAD__); (__HANDLE__)->Init.Period = (__AUTORELOAD__); } while(0)
+#define __HAL_TIM_SET_COMPARE(__HANDLE__, __CHANNEL__, __COMPARE__)	((__HANDLE__)->Instance->CCR1 = (__COMPARE__))
+
+HAL_StatusTypeDef HAL_TIM_PWM_Init(TIM_HandleTypeDef*);
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef*, uint32_t);
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef*, uint32_t);
+void HAL_TIM_IRQHandler(TIM_HandleTypeDef*);
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef*);
+
+/*----- FLASH -----*/
+typedef struct {
+	uint32_t TypeErase;
+	uint32_t Banks;
+	uint32_t Sector;
+	uint32_t NbSectors;
+	uint32_t VoltageRange;
+} FLASH_EraseInitTypeDef;
+
+#define FLASH_TYPEERASE_SECTORS		0x00000000U
+#define FLASH_TYPEPROGRAM_WORD		0x00000002U
+#define FLASH_VOLTAGE_RANGE_3		0x00000002U
+#define FLASH_SECTOR_11				11U
+#define FLASH_FLAG_EOP				(1UL << 0)
+#define FLASH_FLAG_OPERR			(1UL << 1)
+#define FLASH_FLAG_WRPERR			(1UL << 4)
+#define FLASH_FLAG_PGAERR			(1UL << 5)
+#define FLASH_FLAG_PGPERR			(1UL << 6)
+#define FLASH_FLAG_ERSERR			(1UL << 7)
+
+#define __HAL_FLASH_CLEAR_FLAG(__FLAG__)	((void)(__FLAG__))
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void);
+HAL_StatusTypeDef HAL_FLASH_Lock(void);
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t, uint32_t, uint64_t);
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef*, uint32_t*);
+
+}
+
+
+#endif /* HOST_EMU_STM32F7XX_HAL_H_ */
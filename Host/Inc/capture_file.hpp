@@ -0,0 +1,510 @@
+/*
+ * capture_file.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Capture container for the host tools. Samples are stored as packed 24-bit little-endian
+ * two's complement, frame by frame (one sample per channel of the scan list).
+ *
+ * File layout (little endian):
+ *   [0]                      CaptureHeaderTypeDef, zero-padded to kHeaderSize
+ *   [kHeaderSize + k * slot] block k: CaptureBlockTypeDef followed by block_frames frames
+ *   [index_offset]           CaptureBlockTypeDef of every block, then the CRC-32 of that array
+ *
+ * Every block but the last holds exactly block_frames frames and every block takes one
+ * fixed-size slot, so frame n lives in slot n / block_frames: seeking is O(1) with or
+ * without the index. The index (written by Close()) gathers the per-block min/max into one
+ * contiguous array for zoomed-out plots. A capture that was never closed has no index; the
+ * reader then walks the slots and stops at the first block that is missing or fails its CRC,
+ * so everything up to the last complete block survives a crash.
+ */
+#ifndef HOST_INC_CAPTURE_FILE_HPP_
+#define HOST_INC_CAPTURE_FILE_HPP_
+
+#include <crc32.hpp>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace capture_constants {
+
+	constexpr std::array<char, 8> kMagic = {'R', 'A', 'D', 'C', 'C', 'A', 'P', '1'};
+	constexpr uint32_t kVersion = 1;
+	constexpr uint32_t kBlockMagic = 0x4B4C'4243;	// "CBLK"
+	constexpr size_t kHeaderSize = 256;
+	constexpr size_t kMaxChannels = 8;
+	constexpr size_t kSampleSize = 3;
+	constexpr uint32_t kBlockFrames = 4096;
+	constexpr uint32_t kResolution = 24;
+
+}
+
+struct CaptureHeaderTypeDef {
+	std::array<char, 8> magic;
+	uint32_t version;
+	uint32_t header_size;
+	uint32_t channels;
+	uint32_t block_frames;
+	uint32_t slot_size;
+	uint32_t resolution;
+
+	// Acquisition settings, zero when unknown
+	uint64_t start_time_ns;			// Unix time of Open()
+	uint32_t vref_uv;
+	uint32_t sclk_hz;
+	uint32_t data_rate_mhz;			// data-ready rate in mHz
+	uint32_t reserved;
+	std::array<char, 32> board;
+	std::array<char, 8> profile_name;	// PSAVE name
+	std::array<uint32_t, 3> profile_value;
+
+	// Written by Close(); zero while the capture is open
+	uint32_t block_count;
+	uint64_t frame_count;
+	uint64_t index_offset;
+
+	uint32_t reserved2;
+	uint32_t crc;					// CRC-32 of the bytes above
+};
+static_assert(sizeof(CaptureHeaderTypeDef) <= capture_constants::kHeaderSize);
+
+struct CaptureBlockTypeDef {
+	uint32_t magic;
+	uint32_t sequence;				// slot number
+	uint64_t first_frame;
+	uint32_t frames;
+	uint32_t crc;					// CRC-32 of this header (crc = 0) and the samples
+	std::array<int32_t, capture_constants::kMaxChannels> min;
+	std::array<int32_t, capture_constants::kMaxChannels> max;
+};
+static_assert(sizeof(CaptureBlockTypeDef) % 8 == 0);
+
+struct CaptureRangeTypeDef {
+	int32_t min;
+	int32_t max;
+};
+
+namespace capture_file {
+
+	template <typename T>
+	std::span<const uint8_t> AsBytes(const T& value) { return {reinterpret_cast<const uint8_t*>(&value), sizeof(T)}; }
+
+	inline uint32_t HeaderCrc(const CaptureHeaderTypeDef& header)
+	{
+		return Crc32::Calculate(AsBytes(header).first(offsetof(CaptureHeaderTypeDef, crc)));
+	}
+	inline uint32_t BlockCrc(CaptureBlockTypeDef block, std::span<const uint8_t> samples)
+	{
+		block.crc = 0;
+		return Crc32::Calculate(samples, Crc32::Calculate(AsBytes(block)));
+	}
+	inline size_t SlotSize(size_t channels, size_t block_frames)
+	{
+		const size_t size = sizeof(CaptureBlockTypeDef) + block_frames * channels * capture_constants::kSampleSize;
+		return (size + 7) & ~size_t{7};
+	}
+
+	inline void Pack(uint8_t* out, int32_t sample)
+	{
+		const auto u = static_cast<uint32_t>(sample);
+		out[0] = static_cast<uint8_t>(u);
+		out[1] = static_cast<uint8_t>(u >> 8);
+		out[2] = static_cast<uint8_t>(u >> 16);
+	}
+	inline int32_t Unpack(const uint8_t* in)
+	{
+		const uint32_t u = static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) | (static_cast<uint32_t>(in[2]) << 16);
+		return static_cast<int32_t>(u << 8) >> 8;
+	}
+
+	// Copies `s` into a fixed-size, zero-padded field
+	template <size_t N>
+	void SetText(std::array<char, N>& field, std::string_view s)
+	{
+		field.fill(0);
+		std::memcpy(field.data(), s.data(), std::min(s.size(), N));
+	}
+	template <size_t N>
+	std::string_view GetText(const std::array<char, N>& field)
+	{
+		return std::string_view(field.data(), std::find(field.begin(), field.end(), '\0') - field.begin());
+	}
+
+	inline bool WriteAt(int fd, uint64_t offset, std::span<const uint8_t> data)
+	{
+		while(!data.empty())
+		{
+			const ssize_t w = ::pwrite(fd, data.data(), data.size(), static_cast<off_t>(offset));
+			if(w <= 0) return false;
+			data = data.subspan(static_cast<size_t>(w));
+			offset += static_cast<uint64_t>(w);
+		}
+		return true;
+	}
+
+}
+
+// Read-only view of a capture through mmap. Samples are unpacked on access; nothing is
+// loaded up front except the index of a capture that was never closed.
+class CaptureReader {
+private:
+	const uint8_t* base_{nullptr};
+	size_t size_{0};
+	CaptureHeaderTypeDef header_{};
+	std::span<const CaptureBlockTypeDef> index_;
+	std::vector<CaptureBlockTypeDef> recovered_;
+	bool is_recovered_{false};
+
+	uint64_t SlotOffset(uint64_t block) const { return header_.header_size + block * header_.slot_size; }
+	size_t FrameSize() const { return header_.channels * capture_constants::kSampleSize; }
+	const uint8_t* Samples(uint64_t block) const { return base_ + SlotOffset(block) + sizeof(CaptureBlockTypeDef); }
+
+	bool LoadIndex()
+	{
+		const uint64_t offset = header_.index_offset;
+		const uint64_t bytes = uint64_t{header_.block_count} * sizeof(CaptureBlockTypeDef);
+		if(offset == 0 || offset % 8 != 0 || offset + bytes + sizeof(uint32_t) > size_) return false;
+
+		const auto data = std::span<const uint8_t>(base_ + offset, bytes);
+		uint32_t crc;
+		std::memcpy(&crc, base_ + offset + bytes, sizeof(crc));
+		if(crc != Crc32::Calculate(data)) return false;
+
+		index_ = std::span<const CaptureBlockTypeDef>(reinterpret_cast<const CaptureBlockTypeDef*>(data.data()), header_.block_count);
+		return true;
+	}
+	// Walks the slots of a capture that was not closed
+	void RecoverIndex()
+	{
+		recovered_.clear();
+		for(uint64_t k = 0;; ++k)
+		{
+			const uint64_t offset = SlotOffset(k);
+			if(offset + sizeof(CaptureBlockTypeDef) > size_) break;
+
+			CaptureBlockTypeDef block;
+			std::memcpy(&block, base_ + offset, sizeof(block));
+			if(block.magic != capture_constants::kBlockMagic || block.sequence != k ||
+				block.first_frame != k * header_.block_frames || block.frames == 0 || block.frames > header_.block_frames) break;
+
+			const uint64_t bytes = uint64_t{block.frames} * FrameSize();
+			if(offset + sizeof(block) + bytes > size_) break;
+			if(block.crc != capture_file::BlockCrc(block, std::span<const uint8_t>(base_ + offset + sizeof(block), bytes))) break;
+
+			recovered_.push_back(block);
+			if(block.frames != header_.block_frames) break;
+		}
+		index_ = recovered_;
+		is_recovered_ = true;
+	}
+
+public:
+	CaptureReader() = default;
+	CaptureReader(const CaptureReader&) = delete;
+	CaptureReader& operator=(const CaptureReader&) = delete;
+	~CaptureReader() { Close(); }
+
+	// Returns false if the file is not a capture or cannot be mapped
+	bool Open(const char* path)
+	{
+		Close();
+		const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+		if(fd < 0) return false;
+		struct stat st;
+		if(::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < capture_constants::kHeaderSize) {
+			::close(fd);
+			return false;
+		}
+		void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);
+		if(p == MAP_FAILED) return false;
+		base_ = static_cast<const uint8_t*>(p);
+		size_ = static_cast<size_t>(st.st_size);
+
+		std::memcpy(&header_, base_, sizeof(header_));
+		const bool is_valid = header_.magic == capture_constants::kMagic && header_.version == capture_constants::kVersion &&
+			header_.crc == capture_file::HeaderCrc(header_) && header_.header_size >= sizeof(header_) &&
+			header_.channels >= 1 && header_.channels <= capture_constants::kMaxChannels && header_.block_frames != 0 &&
+			header_.slot_size == capture_file::SlotSize(header_.channels, header_.block_frames);
+		if(!is_valid) {
+			Close();
+			return false;
+		}
+		if(!LoadIndex()) RecoverIndex();
+		::madvise(const_cast<uint8_t*>(base_), size_, MADV_RANDOM);
+		return true;
+	}
+	void Close()
+	{
+		if(base_ != nullptr) ::munmap(const_cast<uint8_t*>(base_), size_);
+		base_ = nullptr;
+		size_ = 0;
+		index_ = {};
+		recovered_.clear();
+		is_recovered_ = false;
+	}
+
+	const CaptureHeaderTypeDef& GetHeader() const { return header_; }
+	size_t GetChannelCount() const { return header_.channels; }
+	uint64_t GetFrameCount() const { return index_.empty() ? 0 : index_.back().first_frame + index_.back().frames; }
+	std::span<const CaptureBlockTypeDef> GetIndex() const { return index_; }
+	// True if the capture was not closed and the index was rebuilt from the blocks
+	bool IsRecovered() const { return is_recovered_; }
+
+	// Frames [first, first + out.size() / channels), interleaved. Returns the number of frames read.
+	size_t Read(uint64_t first, std::span<int32_t> out) const
+	{
+		const uint64_t total = GetFrameCount();
+		const size_t channels = header_.channels;
+		size_t count = 0;
+		for(size_t want = out.size() / channels; want > 0 && first < total;)
+		{
+			const uint64_t block = first / header_.block_frames;
+			const uint64_t offset = first % header_.block_frames;
+			const size_t n = static_cast<size_t>(std::min<uint64_t>(want, index_[block].frames - offset));
+			const uint8_t* in = Samples(block) + offset * FrameSize();
+			for(size_t i = 0; i < n * channels; ++i, in += capture_constants::kSampleSize) {
+				out[count * channels + i] = capture_file::Unpack(in);
+			}
+			count += n;
+			want -= n;
+			first += n;
+		}
+		return count;
+	}
+	int32_t At(uint64_t frame, size_t channel) const
+	{
+		return capture_file::Unpack(Samples(frame / header_.block_frames) + (frame % header_.block_frames) * FrameSize() + channel * capture_constants::kSampleSize);
+	}
+
+	// Min/max of `channel` over [first, first + count) split into out.size() equal buckets.
+	// Whole blocks inside a bucket come from the index; only the edges touch the samples.
+	void Summarize(uint64_t first, uint64_t count, size_t channel, std::span<CaptureRangeTypeDef> out) const
+	{
+		if(channel >= header_.channels) return;
+		const uint64_t total = GetFrameCount();
+		first = std::min(first, total);
+		count = std::min(count, total - first);
+		const uint64_t frames = header_.block_frames;
+		for(size_t b = 0; b < out.size(); ++b)
+		{
+			uint64_t i = first + count * b / out.size();
+			const uint64_t end = first + count * (b + 1) / out.size();
+			CaptureRangeTypeDef range = {std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::min()};
+			while(i < end)
+			{
+				const uint64_t block = i / frames;
+				if(i % frames == 0 && i + index_[block].frames <= end) {
+					range.min = std::min(range.min, index_[block].min[channel]);
+					range.max = std::max(range.max, index_[block].max[channel]);
+					i += index_[block].frames;
+					continue;
+				}
+				for(const uint64_t stop = std::min(end, (block + 1) * frames); i < stop; ++i)
+				{
+					const int32_t sample = At(i, channel);
+					range.min = std::min(range.min, sample);
+					range.max = std::max(range.max, sample);
+				}
+			}
+			out[b] = range;
+		}
+	}
+};
+
+// Streaming writer. Each block is written as soon as it is full; Flush() also writes the
+// partial block so that a crash loses nothing that was flushed.
+class CaptureWriter {
+private:
+	int fd_{-1};
+	CaptureHeaderTypeDef header_{};
+	std::vector<CaptureBlockTypeDef> index_;
+	std::vector<uint8_t> slot_;
+	CaptureBlockTypeDef block_{};
+	std::array<int32_t, capture_constants::kMaxChannels> frame_{};
+	size_t channel_{0};			// samples of the current frame in frame_
+	bool is_dirty_{false};
+
+	size_t FrameSize() const { return header_.channels * capture_constants::kSampleSize; }
+	uint64_t SlotOffset(uint64_t block) const { return header_.header_size + block * header_.slot_size; }
+
+	void ResetBlock()
+	{
+		block_ = {};
+		block_.magic = capture_constants::kBlockMagic;
+		block_.sequence = static_cast<uint32_t>(index_.size());
+		block_.first_frame = uint64_t{block_.sequence} * header_.block_frames;
+		block_.min.fill(std::numeric_limits<int32_t>::max());
+		block_.max.fill(std::numeric_limits<int32_t>::min());
+	}
+	bool WriteBlock()
+	{
+		const auto samples = std::span<const uint8_t>(slot_).subspan(sizeof(block_), block_.frames * FrameSize());
+		block_.crc = capture_file::BlockCrc(block_, samples);
+		std::memcpy(slot_.data(), &block_, sizeof(block_));
+		is_dirty_ = false;
+		return capture_file::WriteAt(fd_, SlotOffset(block_.sequence), std::span<const uint8_t>(slot_).first(sizeof(block_) + samples.size()));
+	}
+	bool WriteHeader()
+	{
+		header_.crc = capture_file::HeaderCrc(header_);
+		std::array<uint8_t, capture_constants::kHeaderSize> bytes{};
+		std::memcpy(bytes.data(), &header_, sizeof(header_));
+		return capture_file::WriteAt(fd_, 0, std::span<const uint8_t>(bytes).first(header_.header_size));
+	}
+
+public:
+	CaptureWriter() = default;
+	CaptureWriter(const CaptureWriter&) = delete;
+	CaptureWriter& operator=(const CaptureWriter&) = delete;
+	~CaptureWriter() { Close(); }
+
+	bool IsOpen() const { return fd_ >= 0; }
+	const CaptureHeaderTypeDef& GetHeader() const { return header_; }
+	uint64_t GetFrameCount() const { return uint64_t{index_.size()} * header_.block_frames + block_.frames; }
+
+	// Creates (or truncates) `path`. The acquisition settings and `channels` are taken from
+	// `info`; a zero block_frames selects kBlockFrames.
+	bool Open(const char* path, const CaptureHeaderTypeDef& info)
+	{
+		Close();
+		if(info.channels < 1 || info.channels > capture_constants::kMaxChannels) return false;
+
+		header_ = info;
+		header_.magic = capture_constants::kMagic;
+		header_.version = capture_constants::kVersion;
+		header_.header_size = capture_constants::kHeaderSize;
+		if(header_.block_frames == 0) header_.block_frames = capture_constants::kBlockFrames;
+		header_.slot_size = static_cast<uint32_t>(capture_file::SlotSize(header_.channels, header_.block_frames));
+		header_.resolution = capture_constants::kResolution;
+		if(header_.start_time_ns == 0) {
+			header_.start_time_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::system_clock::now().time_since_epoch()).count());
+		}
+		header_.block_count = 0;
+		header_.frame_count = 0;
+		header_.index_offset = 0;
+
+		fd_ = ::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if(fd_ < 0) return false;
+		index_.clear();
+		channel_ = 0;
+		slot_.assign(header_.slot_size, 0);
+		ResetBlock();
+		return WriteHeader();
+	}
+	// Continues a closed or crashed capture: the index is dropped, the last partial block is
+	// reloaded and new frames go behind it. Returns false if `path` is not a capture.
+	bool OpenAppend(const char* path)
+	{
+		Close();
+		CaptureReader reader;
+		if(!reader.Open(path)) return false;
+
+		header_ = reader.GetHeader();
+		const auto index = reader.GetIndex();
+		const bool is_partial = !index.empty() && index.back().frames != header_.block_frames;
+		index_.assign(index.begin(), index.end() - (is_partial ? 1 : 0));
+		slot_.assign(header_.slot_size, 0);
+		channel_ = 0;
+		ResetBlock();
+		if(is_partial) {
+			block_ = index.back();
+			std::vector<int32_t> frames(size_t{block_.frames} * header_.channels);
+			reader.Read(block_.first_frame, frames);
+			for(size_t i = 0; i < frames.size(); ++i) {
+				capture_file::Pack(slot_.data() + sizeof(block_) + i * capture_constants::kSampleSize, frames[i]);
+			}
+		}
+		reader.Close();
+
+		fd_ = ::open(path, O_RDWR | O_CLOEXEC);
+		if(fd_ < 0) return false;
+		header_.block_count = 0;
+		header_.frame_count = 0;
+		header_.index_offset = 0;
+		if(::ftruncate(fd_, static_cast<off_t>(SlotOffset(index_.size()))) != 0 || !WriteHeader()) {
+			::close(fd_);
+			fd_ = -1;
+			return false;
+		}
+		is_dirty_ = block_.frames != 0;
+		return true;
+	}
+
+	// Interleaved samples in scan order. A frame may be split across calls; only complete
+	// frames are written.
+	bool Append(std::span<const int32_t> samples)
+	{
+		if(fd_ < 0) return false;
+
+		for(const auto sample : samples)
+		{
+			frame_[channel_] = sample;
+			if(++channel_ != header_.channels) continue;
+
+			uint8_t* out = slot_.data() + sizeof(block_) + block_.frames * FrameSize();
+			for(size_t c = 0; c < channel_; ++c, out += capture_constants::kSampleSize)
+			{
+				capture_file::Pack(out, frame_[c]);
+				block_.min[c] = std::min(block_.min[c], frame_[c]);
+				block_.max[c] = std::max(block_.max[c], frame_[c]);
+			}
+			channel_ = 0;
+			is_dirty_ = true;
+			if(++block_.frames == header_.block_frames)
+			{
+				if(!WriteBlock()) return false;
+				index_.push_back(block_);
+				ResetBlock();
+			}
+		}
+		return true;
+	}
+	// Writes the partial block; with `is_durable` also waits for the disk
+	bool Flush(bool is_durable = false)
+	{
+		if(fd_ < 0) return false;
+		if(is_dirty_ && block_.frames != 0 && !WriteBlock()) return false;
+		return !is_durable || ::fdatasync(fd_) == 0;
+	}
+	// Writes the partial block, the index and the final header
+	bool Close()
+	{
+		if(fd_ < 0) return true;
+		bool is_ok = Flush();
+		if(block_.frames != 0) {
+			index_.push_back(block_);
+			ResetBlock();
+		}
+
+		header_.block_count = static_cast<uint32_t>(index_.size());
+		header_.frame_count = index_.empty() ? 0 : index_.back().first_frame + index_.back().frames;
+		header_.index_offset = SlotOffset(index_.size());
+		const auto bytes = std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(index_.data()), index_.size() * sizeof(CaptureBlockTypeDef));
+		const uint32_t crc = Crc32::Calculate(bytes);
+		is_ok = is_ok && capture_file::WriteAt(fd_, header_.index_offset, bytes) &&
+			capture_file::WriteAt(fd_, header_.index_offset + bytes.size(), capture_file::AsBytes(crc)) &&
+			::ftruncate(fd_, static_cast<off_t>(header_.index_offset + bytes.size() + sizeof(crc))) == 0 &&
+			WriteHeader();
+
+		::close(fd_);
+		fd_ = -1;
+		index_.clear();
+		return is_ok;
+	}
+};
+
+
+#endif /* HOST_INC_CAPTURE_FILE_HPP_ */
@@ -0,0 +1,41 @@
+/*
+ * crc32.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * CRC-32 (IEEE 802.3, same as zlib): the value the firmware's CRCUnit computes in hardware.
+ */
+#ifndef HOST_INC_CRC32_HPP_
+#define HOST_INC_CRC32_HPP_
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+class Crc32 {
+private:
+	static constexpr auto kTable = [] {
+		std::array<uint32_t, 256> table{};
+		for(uint32_t i = 0; i < table.size(); ++i)
+		{
+			uint32_t c = i;
+			for(size_t bit = 0; bit < 8; ++bit) c = (c >> 1) ^ ((c & 1) ? 0xEDB8'8320 : 0);
+			table[i] = c;
+		}
+		return table;
+	}();
+
+public:
+	Crc32() = delete;
+
+	// `crc` continues a previous result
+	static uint32_t Calculate(std::span<const uint8_t> data, uint32_t crc = 0)
+	{
+		crc = ~crc;
+		for(const auto byte : data) crc = kTable[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+		return ~crc;
+	}
+};
+
+
+#endif /* HOST_INC_CRC32_HPP_ */
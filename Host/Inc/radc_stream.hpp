@@ -0,0 +1,217 @@
+/*
+ * radc_stream.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Zero-copy framing of the byte stream a board sends back: command replies, RADC sample
+ * lines in any FMT, and the "RADC RICE" header line followed by binary blocks (CMP 0|1|2).
+ * After "CRC ON" every line ends in "*XXXXXXXX" and every block is followed by its CRC-32
+ * (4 bytes, little endian); SetChecksum(true) makes the parser verify and expect them.
+ * Frames are spans into the caller's receive buffer; nothing is copied, and samples are only
+ * decoded when Decode() is asked for them.
+ */
+#ifndef HOST_INC_RADC_STREAM_HPP_
+#define HOST_INC_RADC_STREAM_HPP_
+
+#include <rice_codec.hpp>
+#include <format.hpp>
+#include <crc32.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+
+enum class FrameKindTypeDef {
+	kNone,			// more bytes needed
+	kSampleLine,	// one data-ready edge, `samples` channels
+	kRiceHeader,	// "RADC RICE <samples> <channels>", `samples` announced
+	kRiceBlock,		// one block, `samples` samples (payload not verified)
+	kReply,			// any other text line ("FMT OK", "PLIST ...")
+	kGarbage,		// bytes skipped while resynchronising on a block header
+	kBadChecksum	// a line or block whose CRC does not match; `samples` of a block as announced
+};
+
+struct FrameTypeDef {
+	FrameKindTypeDef kind;
+	std::span<const uint8_t> bytes;
+	size_t samples;
+};
+
+class RadcStreamParser {
+private:
+	size_t rice_remaining_{0};
+	size_t rice_channels_{1};
+	bool is_checksum_{false};
+
+	static constexpr std::string_view kRicePrefix = "RADC RICE ";
+	static constexpr size_t kMaxLine = 4096;
+	static constexpr size_t kChecksumSize = 9;		// "*XXXXXXXX"
+	static constexpr size_t kTrailerSize = 4;
+
+	static bool IsSampleChar(uint8_t c)
+	{
+		return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || c == '-' || c == '.' || c == ' ';
+	}
+	// Line without the terminating CR/LF
+	static std::string_view StripLineEnd(std::span<const uint8_t> line)
+	{
+		size_t n = line.size();
+		while(n > 0 && (line[n - 1] == '\r' || line[n - 1] == '\n')) --n;
+		return std::string_view(reinterpret_cast<const char*>(line.data()), n);
+	}
+	static bool HasChecksum(std::string_view text)
+	{
+		return text.size() >= kChecksumSize && text[text.size() - kChecksumSize] == '*';
+	}
+	// Line without the terminating CR/LF and checksum
+	static std::string_view Trim(std::span<const uint8_t> line)
+	{
+		const auto text = StripLineEnd(line);
+		return HasChecksum(text) ? text.substr(0, text.size() - kChecksumSize) : text;
+	}
+	static bool IsChecksumValid(std::span<const uint8_t> line)
+	{
+		const auto text = StripLineEnd(line);
+		if(!HasChecksum(text)) return false;
+		const auto body = text.substr(0, text.size() - kChecksumSize);
+		char* end = nullptr;
+		const std::string digits(text.substr(body.size() + 1));
+		const auto crc = static_cast<uint32_t>(std::strtoul(digits.c_str(), &end, 16));
+		return *end == '\0' && crc == Crc32::Calculate(std::span<const uint8_t>(line.data(), body.size()));
+	}
+
+	FrameTypeDef NextLine(std::span<const uint8_t> in)
+	{
+		const auto* lf = static_cast<const uint8_t*>(std::memchr(in.data(), '\n', in.size()));
+		if(lf == nullptr)
+		{
+			// A line this long is noise; drop it instead of waiting forever
+			if(in.size() >= kMaxLine) return {FrameKindTypeDef::kGarbage, in, 0};
+			return {FrameKindTypeDef::kNone, {}, 0};
+		}
+
+		const auto line = in.first(static_cast<size_t>(lf - in.data()) + 1);
+		if(is_checksum_ && !IsChecksumValid(line)) return {FrameKindTypeDef::kBadChecksum, line, 0};
+		const auto text = Trim(line);
+		if(text.starts_with(kRicePrefix))
+		{
+			char* end = nullptr;
+			const long samples = std::strtol(text.data() + kRicePrefix.size(), &end, 10);
+			const long channels = std::strtol(end, nullptr, 10);
+			rice_remaining_ = (samples > 0) ? static_cast<size_t>(samples) : 0;
+			rice_channels_ = (channels > 0) ? static_cast<size_t>(channels) : 1;
+			return {FrameKindTypeDef::kRiceHeader, line, rice_remaining_};
+		}
+		if(!text.empty() && std::all_of(text.begin(), text.end(), [](char c) { return IsSampleChar(static_cast<uint8_t>(c)); }))
+		{
+			const size_t fields = static_cast<size_t>(std::count(text.begin(), text.end(), ' ')) + 1;
+			return {FrameKindTypeDef::kSampleLine, line, fields};
+		}
+		return {FrameKindTypeDef::kReply, line, 0};
+	}
+
+	FrameTypeDef NextBlock(std::span<const uint8_t> in)
+	{
+		if(in.size() < rice_constants::kHeaderSize) return {FrameKindTypeDef::kNone, {}, 0};
+
+		RiceCodec::HeaderTypeDef header;
+		if(!RiceCodec::ParseHeader(in, header)) return {FrameKindTypeDef::kGarbage, in.first(1), 0};
+
+		const size_t size = rice_constants::kHeaderSize + header.payload;
+		const size_t bytes = size + (is_checksum_ ? kTrailerSize : 0);
+		if(in.size() < bytes) return {FrameKindTypeDef::kNone, {}, 0};
+
+		rice_remaining_ -= std::min<size_t>(header.count, rice_remaining_);
+		if(is_checksum_)
+		{
+			const uint32_t crc = static_cast<uint32_t>(in[size]) | (static_cast<uint32_t>(in[size + 1]) << 8) |
+				(static_cast<uint32_t>(in[size + 2]) << 16) | (static_cast<uint32_t>(in[size + 3]) << 24);
+			if(crc != Crc32::Calculate(in.first(size))) return {FrameKindTypeDef::kBadChecksum, in.first(bytes), header.count};
+		}
+		return {FrameKindTypeDef::kRiceBlock, in.first(bytes), header.count};
+	}
+
+public:
+	// Next complete frame at the start of `in`. The caller consumes frame.bytes.size() bytes.
+	FrameTypeDef Next(std::span<const uint8_t> in)
+	{
+		if(in.empty()) return {FrameKindTypeDef::kNone, {}, 0};
+		return (rice_remaining_ != 0) ? NextBlock(in) : NextLine(in);
+	}
+
+	// Samples of a kSampleLine printed in `format` (VOLT needs the FMT reference, and loses the
+	// sub-microvolt part). Returns the number of fields, or 0 if one of them does not parse.
+	static size_t ParseSamples(std::span<const uint8_t> line, FormatTypeDef format, uint32_t vref_uv, std::span<int32_t> out)
+	{
+		const auto text = Trim(line);
+		size_t count = 0;
+		for(size_t begin = 0; begin < text.size();)
+		{
+			size_t end = text.find(' ', begin);
+			if(end == std::string_view::npos) end = text.size();
+			const std::string field(text.substr(begin, end - begin));
+			begin = end + 1;
+			if(field.empty()) continue;
+			if(count == out.size()) return 0;
+
+			char* stop = nullptr;
+			switch(format) {
+			case FormatTypeDef::kHex:
+				out[count] = Format::SignExtend(static_cast<uint32_t>(std::strtoul(field.c_str(), &stop, 16)), 24);
+				break;
+			case FormatTypeDef::kDec:
+				out[count] = static_cast<int32_t>(std::strtol(field.c_str(), &stop, 10));
+				break;
+			case FormatTypeDef::kVolt: {
+				const double volt = std::strtod(field.c_str(), &stop);
+				out[count] = static_cast<int32_t>(std::lround(std::clamp(volt * 1e6 * (1 << 23) / vref_uv, -8'388'608.0, 8'388'607.0)));
+				break;
+			}
+			default:
+				out[count] = Format::SignExtend(static_cast<uint32_t>(std::strtoul(field.c_str(), &stop, 2)), 24);
+				break;
+			}
+			if(stop == nullptr || *stop != '\0') return 0;
+			++count;
+		}
+		return count;
+	}
+
+	// Samples carried by a kSampleLine or kRiceBlock frame, 0 for any other frame or on error.
+	// `out` must hold rice_constants::kBlockSamples samples.
+	static size_t Decode(const FrameTypeDef& frame, FormatTypeDef format, uint32_t vref_uv, std::span<int32_t> out)
+	{
+		if(frame.kind == FrameKindTypeDef::kSampleLine) return ParseSamples(frame.bytes, format, vref_uv, out);
+		if(frame.kind != FrameKindTypeDef::kRiceBlock || out.size() < rice_constants::kBlockSamples) return 0;
+
+		std::array<uint32_t, rice_constants::kBlockSamples> block;
+		const auto result = RiceCodec::Decode(frame.bytes, block);
+		std::transform(block.begin(), block.begin() + result.samples, out.begin(), [](uint32_t u) { return static_cast<int32_t>(u); });
+		return result.samples;
+	}
+
+	// The bytes of a frame without its checksum (what the board sends with CRC OFF, minus CR/LF)
+	static std::span<const uint8_t> GetPayload(const FrameTypeDef& frame)
+	{
+		if(frame.kind == FrameKindTypeDef::kRiceBlock)
+		{
+			RiceCodec::HeaderTypeDef header;
+			if(!RiceCodec::ParseHeader(frame.bytes, header)) return {};
+			return frame.bytes.first(rice_constants::kHeaderSize + header.payload);
+		}
+		return frame.bytes.first(Trim(frame.bytes).size());
+	}
+
+	void SetChecksum(bool is_checksum) { is_checksum_ = is_checksum; }
+	bool IsChecksum() const { return is_checksum_; }
+	bool IsBinary() const { return rice_remaining_ != 0; }
+	size_t GetChannelCount() const { return rice_channels_; }
+	void Reset() { rice_remaining_ = 0; rice_channels_ = 1; }
+};
+
+
+#endif /* HOST_INC_RADC_STREAM_HPP_ */
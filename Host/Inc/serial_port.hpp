@@ -0,0 +1,92 @@
+/*
+ * serial_port.hpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Raw, non-blocking serial and pseudo-terminal setup for the Linux host tools.
+ */
+#ifndef HOST_INC_SERIAL_PORT_HPP_
+#define HOST_INC_SERIAL_PORT_HPP_
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <string>
+
+namespace serial {
+
+	// 8N1, no flow control, no line discipline. Baud rates are ignored by pseudo-terminals.
+	inline bool MakeRaw(int fd, speed_t baud = B115200)
+	{
+		termios tio;
+		if(tcgetattr(fd, &tio) != 0) return false;
+		cfmakeraw(&tio);
+		tio.c_cflag |= CLOCAL | CREAD;
+		tio.c_cflag &= ~CRTSCTS;
+		tio.c_cc[VMIN] = 0;
+		tio.c_cc[VTIME] = 0;
+		cfsetispeed(&tio, baud);
+		cfsetospeed(&tio, baud);
+		return tcsetattr(fd, TCSANOW, &tio) == 0;
+	}
+
+	inline speed_t ToSpeed(long baud)
+	{
+		switch(baud) {
+		case 9600:		return B9600;
+		case 19200:		return B19200;
+		case 38400:		return B38400;
+		case 57600:		return B57600;
+		case 230400:	return B230400;
+		case 460800:	return B460800;
+		case 921600:	return B921600;
+		default:		return B115200;
+		}
+	}
+
+	// Returns -1 on error (errno is set)
+	inline int Open(const char* path, speed_t baud = B115200)
+	{
+		const int fd = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+		if(fd < 0) return -1;
+		if(!MakeRaw(fd, baud)) {
+			::close(fd);
+			return -1;
+		}
+		return fd;
+	}
+
+	struct PseudoTerminalTypeDef {
+		int master;
+		int slave;		// kept open so the master does not see a hang-up between clients
+		std::string path;
+	};
+
+	// Non-blocking master, raw slave. Returns false on error (errno is set).
+	inline bool OpenPseudoTerminal(PseudoTerminalTypeDef& pty)
+	{
+		pty.master = ::posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+		if(pty.master < 0) return false;
+		if(::grantpt(pty.master) != 0 || ::unlockpt(pty.master) != 0) {
+			::close(pty.master);
+			return false;
+		}
+		const char* name = ::ptsname(pty.master);
+		if(name == nullptr) {
+			::close(pty.master);
+			return false;
+		}
+		pty.path = name;
+		pty.slave = ::open(name, O_RDWR | O_NOCTTY | O_CLOEXEC);
+		if(pty.slave < 0 || !MakeRaw(pty.slave)) {
+			::close(pty.master);
+			return false;
+		}
+		return true;
+	}
+
+}
+
+
+#endif /* HOST_INC_SERIAL_PORT_HPP_ */
@@ -0,0 +1,100 @@
+/*
+ * cap_dump.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Prints the header and index of a capture file (capture_file.hpp), a range of frames, or a
+ * min/max envelope for plotting.
+ *   cap_dump [-i] [-r first count] [-z buckets [-c channel]] file.cap
+ *     -i    list every block of the index
+ *     -r    print frames [first, first + count), one line per frame, signed decimal
+ *     -z    print `buckets` lines of "min max" over the whole capture (or over -r's range)
+ */
+#include <capture_file.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string_view>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+	bool is_index = false;
+	bool has_range = false;
+	uint64_t first = 0, count = 0;
+	size_t buckets = 0, channel = 0;
+	const char* path = nullptr;
+	for(int i = 1; i < argc; ++i)
+	{
+		const std::string_view arg = argv[i];
+		if(arg == "-i")								is_index = true;
+		else if(arg == "-r" && i + 2 < argc) {
+			first = std::strtoull(argv[++i], nullptr, 0);
+			count = std::strtoull(argv[++i], nullptr, 0);
+			has_range = true;
+		}
+		else if(arg == "-z" && i + 1 < argc)		buckets = static_cast<size_t>(std::atol(argv[++i]));
+		else if(arg == "-c" && i + 1 < argc)		channel = static_cast<size_t>(std::atol(argv[++i]));
+		else if(!arg.starts_with("-") && path == nullptr)	path = argv[i];
+		else {
+			path = nullptr;
+			break;
+		}
+	}
+	if(path == nullptr) {
+		std::fprintf(stderr, "usage: cap_dump [-i] [-r first count] [-z buckets [-c channel]] file.cap\n");
+		return 2;
+	}
+
+	CaptureReader reader;
+	if(!reader.Open(path)) {
+		std::fprintf(stderr, "cap_dump: %s is not a capture\n", path);
+		return 1;
+	}
+	const auto& header = reader.GetHeader();
+	const size_t channels = reader.GetChannelCount();
+	if(!has_range) count = reader.GetFrameCount();
+
+	if(buckets != 0)
+	{
+		if(channel >= channels) {
+			std::fprintf(stderr, "cap_dump: no channel %zu\n", channel);
+			return 1;
+		}
+		std::vector<CaptureRangeTypeDef> range(buckets);
+		reader.Summarize(first, count, channel, range);
+		for(const auto& r : range) std::printf("%d %d\n", r.min, r.max);
+		return 0;
+	}
+	if(has_range)
+	{
+		std::vector<int32_t> frame(channels);
+		for(uint64_t n = first; n < first + count && reader.Read(n, frame) == 1; ++n)
+		{
+			for(size_t c = 0; c < channels; ++c) std::printf((c + 1 < channels) ? "%d " : "%d\n", frame[c]);
+		}
+		return 0;
+	}
+
+	const auto seconds = static_cast<std::time_t>(header.start_time_ns / 1'000'000'000);
+	std::array<char, 32> time;
+	std::strftime(time.data(), time.size(), "%Y-%m-%d %H:%M:%S", std::localtime(&seconds));
+	std::printf("board     %.*s\n", static_cast<int>(capture_file::GetText(header.board).size()), header.board.data());
+	std::printf("start     %s\n", time.data());
+	std::printf("profile   %.*s 0x%08X 0x%08X 0x%08X\n", static_cast<int>(capture_file::GetText(header.profile_name).size()),
+		header.profile_name.data(), header.profile_value[0], header.profile_value[1], header.profile_value[2]);
+	std::printf("clock     sclk %u Hz, data rate %.3f Hz, vref %u uV\n", header.sclk_hz, header.data_rate_mhz / 1000.0, header.vref_uv);
+	std::printf("frames    %llu x %zu channels, %zu blocks of %u frames%s\n",
+		static_cast<unsigned long long>(reader.GetFrameCount()), channels, reader.GetIndex().size(), header.block_frames,
+		reader.IsRecovered() ? " (not closed, index rebuilt)" : "");
+	if(is_index)
+	{
+		for(const auto& block : reader.GetIndex())
+		{
+			std::printf("%6u %12llu %5u", block.sequence, static_cast<unsigned long long>(block.first_frame), block.frames);
+			for(size_t c = 0; c < channels; ++c) std::printf("  [%d, %d]", block.min[c], block.max[c]);
+			std::printf("\n");
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,438 @@
+/*
+ * cmd_bench.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Round-trip latency of the command path. Commands are drawn from a weighted mix and sent one at
+ * a time; each is timed from write() to the end of its reply. Percentiles, command rate and reply
+ * bytes per second are reported per command (first word), so UART timeouts can be sized and
+ * control-path regressions show up as shifted tails. Works against a board or fw_emu.
+ * With -L the firmware stamps every reply ("LAT ON"): RX is the command line on the wire, EXEC
+ * from its LF until the reply has left the UART, and the rest of the round trip is the host side.
+ *   cmd_bench [-c "weight command[|end]"]... [-m mixfile] [-n count] [-W warmup] [-i line]...
+ *             [-b baud] [-t seconds] [-s seed] [-L] [-o csv] [-v] port
+ *     -c    mix entry (repeatable), default "4 WREG 0 0 0", "4 RREG 0" and "1 RADC 10";
+ *           a reply ends after one line, after the STAT line for RADC,
+ *           or at the first line starting with `end` if given
+ *     -m    mix entries from a file, one per line, '#' starts a comment
+ *     -n    timed commands, default 1000
+ *     -W    untimed commands sent first, default 10
+ *     -i    line sent once before the run, waits for its reply (repeatable);
+ *           replies are read as text lines, so leave CMP off
+ *     -t    a command without a complete reply after this long fails, default 5
+ *     -o    every timed command as CSV
+ *     -v    print each command and its reply time
+ */
+#include <serial_port.hpp>
+#include <poll.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kChecksumSize = 9;		// "*XXXXXXXX" in front of CR+LF with CRC ON
+constexpr size_t kMaxTimeouts = 3;		// in a row before the port is given up
+constexpr double kQuiet = 0.2;			// seconds of silence that end a drain
+
+struct MixEntryTypeDef {
+	double weight{1.0};
+	std::string command;
+	std::string end;		// reply ends at a line starting with this, empty: by command
+};
+
+struct SampleTypeDef {
+	double round_trip{0.0};		// us
+	double rx{0.0};				// us, from the LAT line
+	double exec{0.0};
+	size_t bytes{0};
+};
+
+struct StatisticsTypeDef {
+	std::vector<SampleTypeDef> samples;
+	uint64_t failures{0};
+	uint64_t timeouts{0};
+};
+
+struct OptionTypeDef {
+	std::vector<MixEntryTypeDef> mix;
+	std::vector<std::string> init;
+	size_t count{1000};
+	size_t warmup{10};
+	speed_t baud{B115200};
+	double timeout{5.0};
+	uint64_t seed{1};
+	bool is_latency{false};
+	std::string csv;
+	bool is_verbose{false};
+};
+
+enum class ReplyTypeDef {
+	kOk,
+	kFailed,	// an "NG" line, or the LAT line before the reply was complete
+	kTimeOut
+};
+
+/*----- Port -----*/
+class Port {
+private:
+	int fd_;
+	std::string buffer_;
+
+public:
+	explicit Port(int fd) : fd_(fd) {}
+
+	bool Send(std::string_view line)
+	{
+		const std::string s = std::string(line) + "\r\n";
+		return ::write(fd_, s.data(), s.size()) == static_cast<ssize_t>(s.size());
+	}
+
+	// One line without CR+LF and checksum; `bytes` gets its size on the wire
+	std::optional<std::string> ReadLine(Clock::time_point deadline, size_t& bytes)
+	{
+		while(true)
+		{
+			const size_t lf = buffer_.find('\n');
+			if(lf != std::string::npos) {
+				std::string line = buffer_.substr(0, lf);
+				buffer_.erase(0, lf + 1);
+				bytes = lf + 1;
+				if(!line.empty() && line.back() == '\r') line.pop_back();
+				if(line.size() >= kChecksumSize && line[line.size() - kChecksumSize] == '*') {
+					line.resize(line.size() - kChecksumSize);
+				}
+				return line;
+			}
+
+			const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+			if(left <= 0) return std::nullopt;
+			pollfd pfd = {fd_, POLLIN, 0};
+			const int n = ::poll(&pfd, 1, static_cast<int>(left));
+			if(n < 0 && errno != EINTR) return std::nullopt;
+			if(n <= 0) continue;
+			if(pfd.revents & (POLLERR | POLLHUP)) return std::nullopt;
+
+			char chunk[4096];
+			const ssize_t r = ::read(fd_, chunk, sizeof(chunk));
+			if(r > 0) buffer_.append(chunk, static_cast<size_t>(r));
+		}
+	}
+
+	// Throws away everything until the port has been quiet for kQuiet
+	void Drain()
+	{
+		buffer_.clear();
+		size_t bytes;
+		while(ReadLine(Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(kQuiet)), bytes));
+		buffer_.clear();
+	}
+};
+
+std::string_view Word(std::string_view command)
+{
+	const size_t space = command.find(' ');
+	return (space == std::string_view::npos) ? command : command.substr(0, space);
+}
+
+bool IsFailure(std::string_view line)
+{
+	return line.ends_with(" NG") || line == "NG";
+}
+
+bool IsLatency(std::string_view line) { return line.starts_with("LAT RX "); }
+
+// UART load sent by IRQTEST ahead of its reply
+bool IsLoad(std::string_view line) { return line.starts_with("IRQLOAD "); }
+
+// "LAT RX <us> EXEC <us>"
+bool ParseLatency(std::string_view line, SampleTypeDef& sample)
+{
+	unsigned long rx, exec;
+	if(std::sscanf(std::string(line).c_str(), "LAT RX %lu EXEC %lu", &rx, &exec) != 2) return false;
+	sample.rx = static_cast<double>(rx);
+	sample.exec = static_cast<double>(exec);
+	return true;
+}
+
+bool ParseMixEntry(std::string_view text, std::vector<MixEntryTypeDef>& mix)
+{
+	const size_t space = text.find(' ');
+	if(space == std::string_view::npos) return false;
+
+	MixEntryTypeDef entry;
+	entry.weight = std::atof(std::string(text.substr(0, space)).c_str());
+	std::string_view command = text.substr(space + 1);
+	const size_t bar = command.find('|');
+	if(bar != std::string_view::npos) {
+		entry.end = command.substr(bar + 1);
+		command = command.substr(0, bar);
+	}
+	while(command.ends_with(' ')) command.remove_suffix(1);
+	if(entry.weight <= 0.0 || command.empty()) return false;
+	entry.command = command;
+	mix.push_back(std::move(entry));
+	return true;
+}
+
+bool ReadMixFile(const char* path, std::vector<MixEntryTypeDef>& mix)
+{
+	std::ifstream in(path);
+	if(!in) return false;
+	std::string line;
+	while(std::getline(in, line))
+	{
+		const size_t hash = line.find('#');
+		if(hash != std::string::npos) line.resize(hash);
+		while(!line.empty() && (line.back() == ' ' || line.back() == '\r' || line.back() == '\t')) line.pop_back();
+		const size_t first = line.find_first_not_of(" \t");
+		if(first == std::string::npos) continue;
+		if(!ParseMixEntry(std::string_view(line).substr(first), mix)) return false;
+	}
+	return true;
+}
+
+// Sends one command and reads its reply, then the LAT line with -L
+ReplyTypeDef Execute(Port& port, const MixEntryTypeDef& entry, const OptionTypeDef& option, SampleTypeDef& sample)
+{
+	const bool is_capture = entry.end.empty() && Word(entry.command) == "RADC";
+	const auto start = Clock::now();
+	const auto deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(option.timeout));
+	if(!port.Send(entry.command)) return ReplyTypeDef::kTimeOut;
+
+	ReplyTypeDef result = ReplyTypeDef::kOk;
+	while(true)
+	{
+		size_t bytes = 0;
+		const auto line = port.ReadLine(deadline, bytes);
+		if(!line) return ReplyTypeDef::kTimeOut;
+		// A command the firmware ignores only gets its LAT line
+		if(option.is_latency && IsLatency(*line)) {
+			sample.round_trip = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+			ParseLatency(*line, sample);
+			return ReplyTypeDef::kFailed;
+		}
+		sample.bytes += bytes;
+		if(IsLoad(*line)) continue;
+
+		if(IsFailure(*line)) {
+			result = ReplyTypeDef::kFailed;
+			break;
+		}
+		if(!entry.end.empty()) {
+			if(line->starts_with(entry.end)) break;
+		}
+		else if(!is_capture || line->starts_with("STAT ")) break;
+	}
+	sample.round_trip = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+	if(option.is_latency) {
+		size_t bytes = 0;
+		const auto line = port.ReadLine(deadline, bytes);
+		if(!line || !IsLatency(*line)) return ReplyTypeDef::kTimeOut;
+		ParseLatency(*line, sample);
+	}
+	return result;
+}
+
+// Nearest rank of sorted values
+double Percentile(const std::vector<double>& sorted, double p)
+{
+	if(sorted.empty()) return 0.0;
+	const size_t rank = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size()) + 0.999999);
+	return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+void PrintDistribution(const char* label, std::vector<double> values)
+{
+	std::sort(values.begin(), values.end());
+	double sum = 0.0;
+	for(const double v : values) sum += v;
+	const double mean = values.empty() ? 0.0 : sum / static_cast<double>(values.size());
+	std::printf("  %-8s %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+		label, mean, Percentile(values, 50), Percentile(values, 90), Percentile(values, 99), values.empty() ? 0.0 : values.back());
+}
+
+void Report(const std::map<std::string, StatisticsTypeDef>& statistics, double elapsed, bool is_latency)
+{
+	uint64_t total = 0, failures = 0, bytes = 0;
+	for(const auto& [name, stat] : statistics)
+	{
+		double busy = 0.0;
+		uint64_t reply_bytes = 0;
+		std::vector<double> round_trip, rx, exec, host;
+		for(const auto& s : stat.samples)
+		{
+			busy += s.round_trip;
+			reply_bytes += s.bytes;
+			round_trip.push_back(s.round_trip);
+			rx.push_back(s.rx);
+			exec.push_back(s.exec);
+			host.push_back(std::max(0.0, s.round_trip - s.rx - s.exec));
+		}
+		total += stat.samples.size() + stat.timeouts;
+		failures += stat.failures + stat.timeouts;
+		bytes += reply_bytes;
+
+		const double seconds = busy / 1e6;
+		std::printf("%s: %zu ok, %llu failed, %llu timed out, %.1f cmd/s, %.0f reply B/s\n",
+			name.c_str(), stat.samples.size() - static_cast<size_t>(stat.failures),
+			static_cast<unsigned long long>(stat.failures), static_cast<unsigned long long>(stat.timeouts),
+			(seconds > 0.0) ? static_cast<double>(stat.samples.size()) / seconds : 0.0,
+			(seconds > 0.0) ? static_cast<double>(reply_bytes) / seconds : 0.0);
+		std::printf("  %-8s %10s %10s %10s %10s %10s\n", "us", "mean", "p50", "p90", "p99", "max");
+		PrintDistribution("total", std::move(round_trip));
+		if(is_latency) {
+			PrintDistribution("rx", std::move(rx));
+			PrintDistribution("exec", std::move(exec));
+			PrintDistribution("host", std::move(host));
+		}
+	}
+	std::printf("all: %llu commands, %llu failed, %.1f s, %.1f cmd/s, %.0f reply B/s\n",
+		static_cast<unsigned long long>(total), static_cast<unsigned long long>(failures), elapsed,
+		(elapsed > 0.0) ? static_cast<double>(total) / elapsed : 0.0,
+		(elapsed > 0.0) ? static_cast<double>(bytes) / elapsed : 0.0);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	OptionTypeDef option;
+	const char* path = nullptr;
+	bool is_valid = true;
+	for(int i = 1; i < argc && is_valid; ++i)
+	{
+		const std::string_view arg = argv[i];
+		const bool has_value = i + 1 < argc;
+		if(arg == "-c" && has_value)		is_valid = ParseMixEntry(argv[++i], option.mix);
+		else if(arg == "-m" && has_value)	is_valid = ReadMixFile(argv[++i], option.mix);
+		else if(arg == "-n" && has_value)	option.count = static_cast<size_t>(std::atol(argv[++i]));
+		else if(arg == "-W" && has_value)	option.warmup = static_cast<size_t>(std::atol(argv[++i]));
+		else if(arg == "-i" && has_value)	option.init.emplace_back(argv[++i]);
+		else if(arg == "-b" && has_value)	option.baud = serial::ToSpeed(std::atol(argv[++i]));
+		else if(arg == "-t" && has_value)	option.timeout = std::atof(argv[++i]);
+		else if(arg == "-s" && has_value)	option.seed = static_cast<uint64_t>(std::atoll(argv[++i]));
+		else if(arg == "-L")				option.is_latency = true;
+		else if(arg == "-o" && has_value)	option.csv = argv[++i];
+		else if(arg == "-v")				option.is_verbose = true;
+		else if(!arg.starts_with("-") && path == nullptr)	path = argv[i];
+		else is_valid = false;
+	}
+	if(!is_valid || path == nullptr) {
+		std::fprintf(stderr,
+			"usage: cmd_bench [-c \"weight command[|end]\"]... [-m mixfile] [-n count] [-W warmup] [-i line]...\n"
+			"                 [-b baud] [-t seconds] [-s seed] [-L] [-o csv] [-v] port\n");
+		return 2;
+	}
+	if(option.mix.empty()) {
+		ParseMixEntry("4 WREG 0 0 0", option.mix);
+		ParseMixEntry("4 RREG 0", option.mix);
+		ParseMixEntry("1 RADC 10", option.mix);
+	}
+
+	const int fd = serial::Open(path, option.baud);
+	if(fd < 0) {
+		std::perror(path);
+		return 1;
+	}
+	tcflush(fd, TCIOFLUSH);
+	Port port(fd);
+
+	// Init lines and LAT ON, whose own LAT line follows its reply
+	if(option.is_latency) option.init.emplace_back("LAT ON");
+	for(const auto& line : option.init)
+	{
+		size_t bytes;
+		const auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(option.timeout));
+		if(!port.Send(line) || !port.ReadLine(deadline, bytes)) {
+			std::fprintf(stderr, "cmd_bench: no reply to \"%s\"\n", line.c_str());
+			return 1;
+		}
+	}
+	port.Drain();
+
+	FILE* csv = nullptr;
+	if(!option.csv.empty()) {
+		csv = std::fopen(option.csv.c_str(), "w");
+		if(csv == nullptr) {
+			std::perror(option.csv.c_str());
+			return 1;
+		}
+		std::fprintf(csv, "index,command,result,round_trip_us,reply_bytes%s\n", option.is_latency ? ",rx_us,exec_us" : "");
+	}
+
+	std::vector<double> weights;
+	for(const auto& entry : option.mix) weights.push_back(entry.weight);
+	std::mt19937_64 random(option.seed);
+	std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+
+	std::map<std::string, StatisticsTypeDef> statistics;
+	size_t timeouts_in_row = 0;
+	auto start = Clock::now();
+	for(size_t i = 0; i < option.warmup + option.count; ++i)
+	{
+		if(i == option.warmup) start = Clock::now();
+		const auto& entry = option.mix[pick(random)];
+		SampleTypeDef sample;
+		const ReplyTypeDef result = Execute(port, entry, option, sample);
+		if(option.is_verbose) {
+			std::fprintf(stderr, "%zu %s: %s %.1f us\n", i, entry.command.c_str(),
+				(result == ReplyTypeDef::kOk) ? "ok" : (result == ReplyTypeDef::kFailed) ? "NG" : "timeout", sample.round_trip);
+		}
+		if(result == ReplyTypeDef::kTimeOut) {
+			// Whatever is left of the reply would be taken for the next one
+			port.Drain();
+			if(++timeouts_in_row == kMaxTimeouts) {
+				std::fprintf(stderr, "cmd_bench: %zu timeouts in a row, giving up\n", kMaxTimeouts);
+				break;
+			}
+		}
+		else {
+			timeouts_in_row = 0;
+		}
+		if(i < option.warmup) continue;
+
+		auto& stat = statistics[std::string(Word(entry.command))];
+		if(result == ReplyTypeDef::kTimeOut) {
+			++stat.timeouts;
+		}
+		else {
+			if(result == ReplyTypeDef::kFailed) ++stat.failures;
+			stat.samples.push_back(sample);
+		}
+		if(csv != nullptr) {
+			std::fprintf(csv, "%zu,%s,%s,%.1f,%zu", i - option.warmup, entry.command.c_str(),
+				(result == ReplyTypeDef::kOk) ? "ok" : (result == ReplyTypeDef::kFailed) ? "ng" : "timeout", sample.round_trip, sample.bytes);
+			if(option.is_latency) std::fprintf(csv, ",%.0f,%.0f", sample.rx, sample.exec);
+			std::fputc('\n', csv);
+		}
+	}
+	const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+	if(csv != nullptr) std::fclose(csv);
+
+	if(option.is_latency) {
+		port.Send("LAT OFF");
+		port.Drain();
+	}
+	::close(fd);
+
+	Report(statistics, elapsed, option.is_latency);
+	for(const auto& [name, stat] : statistics)
+	{
+		if(stat.failures != 0 || stat.timeouts != 0) return 1;
+	}
+	return (timeouts_in_row == kMaxTimeouts) ? 1 : 0;
+}
@@ -0,0 +1,191 @@
+/*
+ * fw_emu.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * The firmware itself on Linux. Core/Src is built against the emulated HAL in Host/Emu and runs
+ * application_init() / application_run() as main.c does; USART3 is a pseudo-terminal whose slave
+ * path is printed on stdout. CLKDEC edges, TIM4, SPI transfers and UART characters are timed on a
+ * virtual clock, and SPI reads return an ADC model whose gain follows register 1 like a PGA.
+ *   fw_emu [-x speed] [-b baud] [-r clkdec_rate] [-c conversion_ns] [-S max_sclk]
+ *          [-w sine|ramp|square|dc] [-a amplitude] [-f frequency] [-N noise] [-O offset] [-s seed] [-F flash_file]
+ *     -x    virtual seconds per real second, default 1
+ *     -b    UART baud rate, 0 for unpaced, default 115200
+ *     -r    free-running data-ready rate on CLKDEC in Hz, 0 for none, default 1000
+ *     -c    CONVST to data-ready while TIM4 clocks the ADC, default 2000 ns
+ *     -S    fastest SCLK the ADC follows, default 25000000
+ *     -a -N -O    amplitude, rms noise and offset as fractions of full scale at gain 1
+ *     -F    back the profile sector with a file so PSAVE survives restarts
+ * Ctrl-C prints edge, timer, transfer and UART counts on stderr.
+ */
+#include <emulator.hpp>
+#include <serial_port.hpp>
+extern "C" {
+#include "main.h"
+#include "stm32f7xx_it.h"
+#include "application.h"
+#include "boot_timeline.h"
+}
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+extern "C" {
+SPI_HandleTypeDef hspi1;
+UART_HandleTypeDef huart3;
+CRC_HandleTypeDef hcrc;
+TIM_HandleTypeDef htim4;
+}
+
+namespace {
+
+	/*----- MX initialization, as main.c -----*/
+	void MX_GPIO_Init()
+	{
+		HAL_GPIO_WritePin(CS1_GPIO_Port, CS1_Pin, GPIO_PIN_RESET);
+		HAL_GPIO_WritePin(CS0_GPIO_Port, CS0_Pin, GPIO_PIN_RESET);
+
+		HAL_NVIC_SetPriority(EXTI15_10_IRQn, 0, 0);
+		HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+	}
+	void MX_USART3_UART_Init(uint32_t baud)
+	{
+		huart3.Instance = USART3;
+		huart3.Init.BaudRate = baud;
+		if(HAL_UART_Init(&huart3) != HAL_OK) Error_Handler();
+
+		HAL_NVIC_SetPriority(USART3_IRQn, 0, 0);
+		HAL_NVIC_EnableIRQ(USART3_IRQn);
+	}
+	void MX_SPI1_Init()
+	{
+		hspi1.Instance = SPI1;
+		hspi1.Init.Mode = SPI_MODE_MASTER;
+		hspi1.Init.Direction = SPI_DIRECTION_2LINES;
+		hspi1.Init.DataSize = SPI_DATASIZE_8BIT;
+		hspi1.Init.CLKPolarity = SPI_POLARITY_LOW;
+		hspi1.Init.CLKPhase = SPI_PHASE_1EDGE;
+		hspi1.Init.NSS = SPI_NSS_SOFT;
+		hspi1.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16;
+		hspi1.Init.FirstBit = SPI_FIRSTBIT_MSB;
+		if(HAL_SPI_Init(&hspi1) != HAL_OK) Error_Handler();
+
+		HAL_NVIC_SetPriority(SPI1_IRQn, 0, 0);
+		HAL_NVIC_EnableIRQ(SPI1_IRQn);
+	}
+	void MX_CRC_Init()
+	{
+		hcrc.Instance = CRC;
+		hcrc.Init.DefaultPolynomialUse = DEFAULT_POLYNOMIAL_ENABLE;
+		hcrc.Init.DefaultInitValueUse = DEFAULT_INIT_VALUE_ENABLE;
+		hcrc.Init.InputDataInversionMode = CRC_INPUTDATA_INVERSION_BYTE;
+		hcrc.Init.OutputDataInversionMode = CRC_OUTPUTDATA_INVERSION_ENABLE;
+		hcrc.InputDataFormat = CRC_INPUTDATA_FORMAT_BYTES;
+		__HAL_CRC_DR_RESET(&hcrc);
+	}
+	void MX_TIM4_Init()
+	{
+		htim4.Instance = TIM4;
+		htim4.Init.Prescaler = 95;
+		htim4.Init.CounterMode = TIM_COUNTERMODE_UP;
+		htim4.Init.Period = 999;
+		if(HAL_TIM_PWM_Init(&htim4) != HAL_OK) Error_Handler();
+		htim4.Instance->CCR1 = 500;
+
+		HAL_NVIC_SetPriority(TIM4_IRQn, 0, 0);
+		HAL_NVIC_EnableIRQ(TIM4_IRQn);
+	}
+
+	bool ParseWaveform(const char* name, emu::WaveformTypeDef& waveform)
+	{
+		if(std::strcmp(name, "sine") == 0)			waveform = emu::WaveformTypeDef::kSine;
+		else if(std::strcmp(name, "ramp") == 0)		waveform = emu::WaveformTypeDef::kRamp;
+		else if(std::strcmp(name, "square") == 0)	waveform = emu::WaveformTypeDef::kSquare;
+		else if(std::strcmp(name, "dc") == 0)		waveform = emu::WaveformTypeDef::kDC;
+		else return false;
+		return true;
+	}
+
+}
+
+/*----- Interrupt handlers, as stm32f7xx_it.c -----*/
+extern "C" void TIM4_IRQHandler(void) { HAL_TIM_IRQHandler(&htim4); }
+extern "C" void SPI1_IRQHandler(void) { HAL_SPI_IRQHandler(&hspi1); }
+extern "C" void USART3_IRQHandler(void) { HAL_UART_IRQHandler(&huart3); }
+extern "C" void EXTI15_10_IRQHandler(void)
+{
+	HAL_GPIO_EXTI_IRQHandler(USER_Btn_Pin);
+	HAL_GPIO_EXTI_IRQHandler(CLKDEC_Pin);
+}
+
+extern "C" void Error_Handler(void)
+{
+	std::fprintf(stderr, "fw_emu: Error_Handler\n");
+	std::abort();
+}
+
+int main(int argc, char** argv)
+{
+	emu::BoardConfigTypeDef config;
+	const char* flash_file = nullptr;
+	bool is_valid = true;
+	for(int i = 1; i < argc && is_valid; ++i) {
+		if(std::strcmp(argv[i], "-x") == 0 && i + 1 < argc)			config.speed = std::atof(argv[++i]);
+		else if(std::strcmp(argv[i], "-b") == 0 && i + 1 < argc)	config.baud = static_cast<uint32_t>(std::atol(argv[++i]));
+		else if(std::strcmp(argv[i], "-r") == 0 && i + 1 < argc)	config.clkdec_rate = std::atof(argv[++i]);
+		else if(std::strcmp(argv[i], "-c") == 0 && i + 1 < argc)	config.conversion_ns = static_cast<uint32_t>(std::atol(argv[++i]));
+		else if(std::strcmp(argv[i], "-S") == 0 && i + 1 < argc)	config.max_sclk = static_cast<uint32_t>(std::atol(argv[++i]));
+		else if(std::strcmp(argv[i], "-w") == 0 && i + 1 < argc)	is_valid = ParseWaveform(argv[++i], config.adc.waveform);
+		else if(std::strcmp(argv[i], "-a") == 0 && i + 1 < argc)	config.adc.amplitude = std::atof(argv[++i]);
+		else if(std::strcmp(argv[i], "-f") == 0 && i + 1 < argc)	config.adc.frequency = std::atof(argv[++i]);
+		else if(std::strcmp(argv[i], "-N") == 0 && i + 1 < argc)	config.adc.noise = std::atof(argv[++i]);
+		else if(std::strcmp(argv[i], "-O") == 0 && i + 1 < argc)	config.adc.offset = std::atof(argv[++i]);
+		else if(std::strcmp(argv[i], "-s") == 0 && i + 1 < argc)	config.adc.seed = static_cast<uint64_t>(std::atoll(argv[++i]));
+		else if(std::strcmp(argv[i], "-F") == 0 && i + 1 < argc)	flash_file = argv[++i];
+		else is_valid = false;
+	}
+	if(!is_valid || config.speed <= 0.0) {
+		std::fprintf(stderr,
+			"usage: fw_emu [-x speed] [-b baud] [-r clkdec_rate] [-c conversion_ns] [-S max_sclk]\n"
+			"              [-w sine|ramp|square|dc] [-a amplitude] [-f frequency] [-N noise] [-O offset] [-s seed] [-F flash_file]\n");
+		return 2;
+	}
+
+	serial::PseudoTerminalTypeDef pty;
+	if(!serial::OpenPseudoTerminal(pty)) {
+		std::perror("posix_openpt");
+		return 1;
+	}
+	if(!emu::Flash::Init(flash_file)) {
+		std::perror("flash");
+		return 1;
+	}
+	std::printf("%s\n", pty.path.c_str());
+	std::fflush(stdout);
+
+	// Reset
+	emu::Clock::Init(config.speed);
+	emu::Core::Init();
+	emu::Core::SetVector(TIM4_IRQn, TIM4_IRQHandler);
+	emu::Core::SetVector(SPI1_IRQn, SPI1_IRQHandler);
+	emu::Core::SetVector(USART3_IRQn, USART3_IRQHandler);
+	emu::Core::SetVector(EXTI15_10_IRQn, EXTI15_10_IRQHandler);
+	emu::Board::Init(config, pty.master);
+	emu::Board::SetChipSelect(0, CS0_GPIO_Port, CS0_Pin);
+	emu::Board::SetChipSelect(1, CS1_GPIO_Port, CS1_Pin);
+	emu::Board::Start();
+
+	boot_timeline_mark("main");
+	boot_timeline_mark("hal");
+	boot_timeline_mark("clock");
+
+	MX_GPIO_Init();
+	MX_USART3_UART_Init(config.baud);
+	MX_SPI1_Init();
+	MX_CRC_Init();
+	MX_TIM4_Init();
+	boot_timeline_mark("peripheral");
+	application_init();
+
+	while(true) application_run();
+}
@@ -0,0 +1,410 @@
+/*
+ * fw_sim.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Simulated boards on pseudo-terminals, for testing host tools without hardware.
+ * Each board answers FMT, CMP, SCAN, CRC, STAT, RATE, RXONLY and RADC like the firmware, with a synthetic
+ * sine + noise signal per channel. The slave paths are printed one per line.
+ *   fw_sim [-n boards] [-B bytes_per_second] [-e byte_error_rate] [-m miss_rate] [-s seed]
+ *     -B    limit the output rate per board (e.g. 11520 for 115200 baud), default unlimited
+ *     -e    probability that an output byte gets one bit flipped, default 0
+ *     -m    probability that a data-ready edge is skipped as busy (reported by STAT), default 0
+ */
+#include <serial_port.hpp>
+#include <format.hpp>
+#include <rice_codec.hpp>
+#include <crc32.hpp>
+#include <sys/epoll.h>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr size_t kResolution = 24;
+constexpr uint32_t kVref_uV = 2'500'000;
+constexpr size_t kMaxRecord = 4096;
+constexpr size_t kMaxChannels = 8;
+
+volatile std::sig_atomic_t is_running = 1;
+
+struct BoardTypeDef {
+	serial::PseudoTerminalTypeDef pty;
+	std::string line;
+	std::string out;
+	size_t out_offset{0};
+	bool is_writing{false};
+
+	FormatTypeDef format{FormatTypeDef::kBin};
+	uint32_t vref_uv{kVref_uV};
+	bool is_compressed{false};
+	uint8_t order{1};
+	size_t channels{1};
+	bool is_checksum{false};
+	double miss_rate{0.0};
+	uint32_t rate{0};			// Hz, 0 while the conversions are clocked externally
+	bool is_triggered{false};
+
+	// STAT of the last RADC
+	uint64_t edges{0};
+	uint64_t samples{0};
+	uint64_t busy{0};
+
+	uint64_t edge{0};
+	std::mt19937 rng;
+	std::normal_distribution<double> noise{0.0, 3.0};
+};
+
+std::vector<std::string_view> Split(std::string_view s)
+{
+	std::vector<std::string_view> tokens;
+	size_t begin = s.find_first_not_of(" \t");
+	while(begin != std::string_view::npos)
+	{
+		const size_t end = s.find_first_of(" \t", begin);
+		tokens.push_back(s.substr(begin, end - begin));
+		begin = s.find_first_not_of(" \t", end);
+	}
+	return tokens;
+}
+
+// The whole token has to be a decimal integer, as on the firmware
+std::optional<long> ToInteger(std::string_view s)
+{
+	const std::string text(s);
+	char* end = nullptr;
+	errno = 0;
+	const long value = std::strtol(text.c_str(), &end, 10);
+	if(text.empty() || errno != 0 || *end != '\0') return std::nullopt;
+	return value;
+}
+
+// 24-bit two's complement code of channel `c` at the current edge
+uint32_t Sample(BoardTypeDef& board, size_t c)
+{
+	const double phase = 2.0 * M_PI * (static_cast<double>(board.edge) / 1000.0 + static_cast<double>(c) / 8.0);
+	const double value = std::sin(phase) * 1'000'000.0 + board.noise(board.rng);
+	const auto code = static_cast<int32_t>(std::lround(std::clamp(value, -8'388'608.0, 8'388'607.0)));
+	return static_cast<uint32_t>(code) & 0xFF'FFFF;
+}
+
+size_t FormatSample(const BoardTypeDef& board, std::span<char> out, uint32_t data)
+{
+	switch(board.format) {
+	case FormatTypeDef::kHex:	return Format::Hex(out, data, kResolution);
+	case FormatTypeDef::kDec:	return Format::Dec(out, Format::SignExtend(data, kResolution));
+	case FormatTypeDef::kVolt:	return Format::Volt(out, data, kResolution, board.vref_uv);
+	default:					return Format::Bin(out, data, 32);
+	}
+}
+
+void WriteLine(BoardTypeDef& board, std::string_view s)
+{
+	board.out.append(s);
+	if(board.is_checksum)
+	{
+		std::array<char, 10> suffix;
+		std::snprintf(suffix.data(), suffix.size(), "*%08X", Crc32::Calculate(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(s.data()), s.size())));
+		board.out.append(suffix.data(), 9);
+	}
+	board.out.append("\r\n");
+}
+void WriteBlock(BoardTypeDef& board, std::span<const uint8_t> block)
+{
+	board.out.append(reinterpret_cast<const char*>(block.data()), block.size());
+	if(!board.is_checksum) return;
+	const uint32_t crc = Crc32::Calculate(block);
+	for(size_t i = 0; i < 4; ++i) board.out.push_back(static_cast<char>(crc >> (8 * i)));
+}
+
+void WriteStatistics(BoardTypeDef& board)
+{
+	WriteLine(board, "STAT EDGES " + std::to_string(board.edges) + " SAMPLES " + std::to_string(board.samples) +
+		" BUSY " + std::to_string(board.busy) + " SPIERR 0 OVERRUN 0");
+}
+
+void Radc(BoardTypeDef& board, size_t n)
+{
+	if(n > kMaxRecord / board.channels) {
+		WriteLine(board, "RADC NG");
+		return;
+	}
+
+	// Skipped edges leave a gap in the signal, as on the board
+	std::vector<uint32_t> record;
+	record.reserve(n * board.channels);
+	std::bernoulli_distribution miss(board.miss_rate);
+	board.edges = board.busy = 0;
+	for(size_t i = 0; i < n; ++board.edge, ++board.edges)
+	{
+		if(board.miss_rate > 0.0 && miss(board.rng)) {
+			++board.busy;
+			continue;
+		}
+		for(size_t c = 0; c < board.channels; ++c) record.push_back(Sample(board, c));
+		++i;
+	}
+	board.samples = record.size();
+
+	if(!board.is_compressed)
+	{
+		std::array<char, 512> text;
+		for(size_t i = 0; i < record.size(); i += board.channels)
+		{
+			size_t length = 0;
+			for(size_t c = 0; c < board.channels; ++c)
+			{
+				if(c != 0) text[length++] = ' ';
+				length += FormatSample(board, std::span<char>(text).subspan(length), record[i + c]);
+			}
+			WriteLine(board, std::string_view(text.data(), length));
+		}
+		WriteStatistics(board);
+		return;
+	}
+
+	WriteLine(board, "RADC RICE " + std::to_string(record.size()) + " " + std::to_string(board.channels));
+	std::array<uint32_t, rice_constants::kBlockSamples> block;
+	std::array<uint8_t, rice_constants::kMaxBlockSize> encoded;
+	for(size_t i = 0; i < record.size(); i += block.size())
+	{
+		const size_t count = std::min(block.size(), record.size() - i);
+		std::transform(record.begin() + i, record.begin() + i + count, block.begin(),
+			[](uint32_t data) { return static_cast<uint32_t>(Format::SignExtend(data, kResolution)); });
+		const size_t size = RiceCodec::Encode(std::span<const uint32_t>(block).first(count), board.order, encoded);
+		WriteBlock(board, std::span<const uint8_t>(encoded).first(size));
+	}
+	WriteStatistics(board);
+}
+
+void Dispatch(BoardTypeDef& board, std::string_view line)
+{
+	const auto tokens = Split(line);
+	if(tokens.empty()) return;
+	const auto command = tokens.front();
+	const auto args = std::span<const std::string_view>(tokens).subspan(1);
+
+	if(command == "RADC" && args.size() == 1) {
+		const auto n = ToInteger(args[0]);
+		if(!n || *n < 0) {
+			WriteLine(board, "RADC NG");
+			return;
+		}
+		Radc(board, static_cast<size_t>(*n));
+	}
+	else if(command == "FMT" && !args.empty()) {
+		if(args[0] == "BIN")		board.format = FormatTypeDef::kBin;
+		else if(args[0] == "HEX")	board.format = FormatTypeDef::kHex;
+		else if(args[0] == "DEC")	board.format = FormatTypeDef::kDec;
+		else if(args[0] == "VOLT")	board.format = FormatTypeDef::kVolt;
+		else return;
+		if(args.size() == 2) {
+			const auto vref_uv = ToInteger(args[1]);
+			if(!vref_uv || *vref_uv < 0) {
+				WriteLine(board, "FMT NG");
+				return;
+			}
+			board.vref_uv = static_cast<uint32_t>(*vref_uv);
+		}
+		WriteLine(board, "FMT OK");
+	}
+	else if(command == "CMP" && args.size() == 1) {
+		if(args[0] == "OFF") {
+			board.is_compressed = false;
+		}
+		else {
+			const auto order = ToInteger(args[0]);
+			if(!order) {
+				WriteLine(board, "CMP NG");
+				return;
+			}
+			if(*order < 0 || *order > rice_constants::kMaxOrder) return;
+			board.order = static_cast<uint8_t>(*order);
+			board.is_compressed = true;
+		}
+		WriteLine(board, "CMP OK");
+	}
+	else if(command == "CRC" && args.size() == 1) {
+		if(args[0] == "ON")			board.is_checksum = true;
+		else if(args[0] == "OFF")	board.is_checksum = false;
+		else return;
+		WriteLine(board, "CRC OK");
+	}
+	else if(command == "STAT" && args.empty()) {
+		WriteStatistics(board);
+	}
+	else if(command == "RATE" && args.size() <= 2) {
+		if(args.size() == 1 && args[0] == "EXT") {
+			board.rate = 0;
+			board.is_triggered = false;
+		}
+		else if(!args.empty()) {
+			if(args.size() == 2 && args[1] != "TRIG") return;
+			const auto rate = ToInteger(args[0]);
+			if(!rate || *rate <= 0 || *rate > 1'000'000) {
+				WriteLine(board, "RATE NG");
+				return;
+			}
+			board.rate = static_cast<uint32_t>(*rate);
+			board.is_triggered = args.size() == 2;
+		}
+		if(board.rate == 0) WriteLine(board, "RATE EXT");
+		else WriteLine(board, std::string(board.is_triggered ? "RATE TRIG " : "RATE PWM ") + std::to_string(board.rate) + ".000");
+	}
+	else if(command == "RXONLY" && args.size() == 1) {
+		if(args[0] != "ON" && args[0] != "OFF") return;
+		WriteLine(board, "RXONLY OK");
+	}
+	else if(command == "SCAN" && args.size() <= kMaxChannels) {
+		board.channels = std::max<size_t>(args.size(), 1);
+		WriteLine(board, "SCAN OK");
+	}
+}
+
+void Corrupt(BoardTypeDef& board, size_t from, double rate)
+{
+	if(rate <= 0.0) return;
+	std::bernoulli_distribution hit(rate);
+	std::uniform_int_distribution<int> bit(0, 7);
+	for(size_t i = from; i < board.out.size(); ++i) {
+		if(hit(board.rng)) board.out[i] = static_cast<char>(board.out[i] ^ (1 << bit(board.rng)));
+	}
+}
+
+void SetWriting(int epoll_fd, BoardTypeDef& board, bool is_writing)
+{
+	if(board.is_writing == is_writing) return;
+	epoll_event event = {};
+	event.events = EPOLLIN | (is_writing ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+	event.data.ptr = &board;
+	epoll_ctl(epoll_fd, EPOLL_CTL_MOD, board.pty.master, &event);
+	board.is_writing = is_writing;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	size_t count = 1;
+	double rate_limit = 0.0;
+	double error_rate = 0.0;
+	double miss_rate = 0.0;
+	unsigned seed = 1;
+	for(int i = 1; i < argc; ++i) {
+		if(std::strcmp(argv[i], "-n") == 0 && i + 1 < argc)			count = static_cast<size_t>(std::atol(argv[++i]));
+		else if(std::strcmp(argv[i], "-B") == 0 && i + 1 < argc)	rate_limit = std::atof(argv[++i]);
+		else if(std::strcmp(argv[i], "-e") == 0 && i + 1 < argc)	error_rate = std::atof(argv[++i]);
+		else if(std::strcmp(argv[i], "-m") == 0 && i + 1 < argc)	miss_rate = std::atof(argv[++i]);
+		else if(std::strcmp(argv[i], "-s") == 0 && i + 1 < argc)	seed = static_cast<unsigned>(std::atol(argv[++i]));
+		else {
+			std::fprintf(stderr, "usage: fw_sim [-n boards] [-B bytes_per_second] [-e byte_error_rate] [-m miss_rate] [-s seed]\n");
+			return 2;
+		}
+	}
+
+	std::signal(SIGINT, [](int) { is_running = 0; });
+	std::signal(SIGTERM, [](int) { is_running = 0; });
+
+	const int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if(epoll_fd < 0) {
+		std::perror("epoll_create1");
+		return 1;
+	}
+
+	std::vector<BoardTypeDef> boards(count);
+	for(size_t i = 0; i < count; ++i)
+	{
+		auto& board = boards[i];
+		if(!serial::OpenPseudoTerminal(board.pty)) {
+			std::perror("posix_openpt");
+			return 1;
+		}
+		board.rng.seed(seed + static_cast<unsigned>(i));
+		board.miss_rate = std::clamp(miss_rate, 0.0, 0.99);
+
+		epoll_event event = {};
+		event.events = EPOLLIN;
+		event.data.ptr = &board;
+		epoll_ctl(epoll_fd, EPOLL_CTL_ADD, board.pty.master, &event);
+		std::printf("%s\n", board.pty.path.c_str());
+	}
+	std::fflush(stdout);
+
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<uint64_t> sent(count, 0);
+	std::array<epoll_event, 16> events;
+	while(is_running)
+	{
+		const int n = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), (rate_limit > 0.0) ? 1 : 100);
+		if(n < 0 && errno != EINTR) {
+			std::perror("epoll_wait");
+			return 1;
+		}
+
+		for(int e = 0; e < n; ++e)
+		{
+			auto& board = *static_cast<BoardTypeDef*>(events[e].data.ptr);
+			if(events[e].events & EPOLLIN)
+			{
+				std::array<char, 1024> chunk;
+				const ssize_t r = ::read(board.pty.master, chunk.data(), chunk.size());
+				for(ssize_t k = 0; k < r; ++k)
+				{
+					const char c = chunk[static_cast<size_t>(k)];
+					if(c != '\r' && c != '\n') {
+						board.line.push_back(c);
+						continue;
+					}
+					const size_t from = board.out.size();
+					Dispatch(board, board.line);
+					Corrupt(board, from, error_rate);
+					board.line.clear();
+				}
+			}
+		}
+
+		// Flush pending output, optionally paced like a UART
+		const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		for(size_t i = 0; i < count; ++i)
+		{
+			auto& board = boards[i];
+			size_t pending = board.out.size() - board.out_offset;
+			if(rate_limit > 0.0) {
+				const double budget = rate_limit * elapsed - static_cast<double>(sent[i]);
+				pending = std::min(pending, static_cast<size_t>(std::max(budget, 0.0)));
+			}
+			if(pending != 0)
+			{
+				const ssize_t w = ::write(board.pty.master, board.out.data() + board.out_offset, pending);
+				if(w > 0) {
+					board.out_offset += static_cast<size_t>(w);
+					sent[i] += static_cast<uint64_t>(w);
+				}
+			}
+			if(board.out_offset == board.out.size()) {
+				board.out.clear();
+				board.out_offset = 0;
+			}
+			else if(rate_limit <= 0.0) {
+				SetWriting(epoll_fd, board, true);
+				continue;
+			}
+			SetWriting(epoll_fd, board, false);
+			// Nothing was sent while idle, so the UART pacing does not build up credit
+			if(board.out.empty()) sent[i] = static_cast<uint64_t>(rate_limit * elapsed);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,552 @@
+/*
+ * radc_aggregate.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Drives several boards at once, one serial port (or pseudo-terminal) each, from a single
+ * epoll loop. Every board gets the init lines, then the capture command `runs` times.
+ * Received sample lines and RICE blocks are written unchanged to <dir>/<port>.radc straight
+ * from the receive buffer (with CRC ON, damaged ones too so radc_verify can point them out);
+ * replies and resync bytes are only counted. The STAT line each capture ends with is added up
+ * per board, so conversions the firmware lost (busy bus, SPI errors, overruns) are reported.
+ *   radc_aggregate [-c command] [-i line]... [-r runs] [-o dir] [-b baud] [-t seconds] [-C]
+ *                  [-p name] [-R r0,r1,r2] [-s sclk_hz] [-d rate_hz] [-v] port...
+ *     -c    capture command, default "RADC 1000"
+ *     -i    line sent once before the first capture, waits for its reply (repeatable);
+ *           an "FMT" line also tells -C how to read the sample lines,
+ *           "CRC ON" makes every frame checked against its checksum, and the replies
+ *           to "SCLK" and "RATE" lines give each board's SCLK and data rate for -C
+ *     -C    decode and write <dir>/<port>.cap (capture_file.hpp) instead
+ *     -p -R -s -d  header fields of the .cap files as in radc_pack; a board's own
+ *           SCLK/RATE reply overrides -s/-d
+ *     -t    a board that stays silent this long while a reply is due is given up, default 5;
+ *           a capture cut short by a lost line ending, or a missing STAT line, is abandoned
+ *           and the next run started
+ *     -v    print per-board progress once a second
+ */
+#include <serial_port.hpp>
+#include <radc_stream.hpp>
+#include <capture_file.hpp>
+#include <sys/epoll.h>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kBufferSize = 1 << 16;
+
+enum class StateTypeDef {
+	kInit,
+	kCapture,
+	kStatus,	// capture received, waiting for its STAT line
+	kDone,
+	kFailed
+};
+
+struct StatisticsTypeDef {
+	uint64_t bytes{0};
+	uint64_t samples{0};
+	uint64_t lines{0};
+	uint64_t blocks{0};
+	uint64_t replies{0};
+	uint64_t garbage_bytes{0};
+	uint64_t bad_lines{0};
+	uint64_t decode_errors{0};
+	uint64_t checksum_errors{0};
+	uint64_t timeouts{0};
+	uint64_t rejected{0};	// capture commands answered with NG
+
+	// Sums of the firmware's STAT lines
+	uint64_t edges{0};
+	uint64_t busy{0};
+	uint64_t spi_errors{0};
+	uint64_t overruns{0};
+	uint64_t lost_status{0};
+};
+
+struct BoardTypeDef {
+	std::string path;
+	int fd{-1};
+	int out_fd{-1};
+	std::string out_path;
+	std::unique_ptr<CaptureWriter> capture;
+	CaptureHeaderTypeDef info{};	// settings for the .cap header, from the options and the board's replies
+
+	std::vector<uint8_t> buffer = std::vector<uint8_t>(kBufferSize);
+	size_t begin{0};
+	size_t end{0};
+	RadcStreamParser parser;
+
+	StateTypeDef state{StateTypeDef::kInit};
+	size_t init_index{0};
+	size_t run{0};
+	size_t expected{0};		// sample lines (text) or samples (RICE) left in this capture
+	uint64_t run_bytes{0};	// stat.bytes when this capture was sent
+
+	Clock::time_point start;
+	Clock::time_point last_rx;
+	StatisticsTypeDef stat;
+};
+
+struct OptionTypeDef {
+	std::string command{"RADC 1000"};
+	std::vector<std::string> init;
+	size_t runs{1};
+	std::string directory{"."};
+	speed_t baud{B115200};
+	double timeout{5.0};
+	bool is_capture{false};
+	bool is_verbose{false};
+	FormatTypeDef format{FormatTypeDef::kBin};
+	uint32_t vref_uv{2'500'000};
+	CaptureHeaderTypeDef info{};	// -p -R -s -d
+};
+
+void Send(BoardTypeDef& board, std::string_view line)
+{
+	const std::string s = std::string(line) + "\r\n";
+	// Command lines are short; a full output buffer here means the port is dead anyway
+	if(::write(board.fd, s.data(), s.size()) != static_cast<ssize_t>(s.size())) {
+		board.state = StateTypeDef::kFailed;
+	}
+	board.last_rx = Clock::now();
+}
+
+size_t LinesOf(std::string_view command)
+{
+	if(!command.starts_with("RADC ")) return 0;
+	return static_cast<size_t>(std::strtol(std::string(command.substr(5)).c_str(), nullptr, 10));
+}
+
+void StartNext(BoardTypeDef& board, const OptionTypeDef& option)
+{
+	if(board.state == StateTypeDef::kInit && board.init_index < option.init.size()) {
+		// The reply to CRC ON already carries a checksum
+		const std::string_view command = option.init[board.init_index];
+		if(command == "CRC ON")			board.parser.SetChecksum(true);
+		else if(command == "CRC OFF")	board.parser.SetChecksum(false);
+		Send(board, command);
+		return;
+	}
+	board.state = StateTypeDef::kCapture;
+	if(board.run == option.runs) {
+		board.state = StateTypeDef::kDone;
+		return;
+	}
+	board.parser.Reset();
+	board.expected = LinesOf(option.command);
+	board.run_bytes = board.stat.bytes;
+	Send(board, option.command);
+}
+
+// The capture's data is complete; its STAT line comes next
+void EndCapture(BoardTypeDef& board)
+{
+	board.state = StateTypeDef::kStatus;
+}
+
+// "STAT EDGES <n> SAMPLES <n> BUSY <n> SPIERR <n> OVERRUN <n>"; false if it is not a STAT line
+bool ParseStatistics(std::string_view line, StatisticsTypeDef& stat)
+{
+	if(!line.starts_with("STAT ")) return false;
+	const std::string text(line.substr(5));
+	const char* p = text.c_str();
+	while(*p != '\0')
+	{
+		char* end = nullptr;
+		const char* key = p;
+		const size_t key_length = std::strcspn(p, " ");
+		const uint64_t value = std::strtoull(key + key_length, &end, 10);
+		if(end == key + key_length) return false;
+		const std::string_view name(key, key_length);
+		if(name == "EDGES")			stat.edges += value;
+		else if(name == "BUSY")		stat.busy += value;
+		else if(name == "SPIERR")	stat.spi_errors += value;
+		else if(name == "OVERRUN")	stat.overruns += value;
+		p = end + std::strspn(end, " ");
+	}
+	return true;
+}
+
+// "SCLK <divider> <Hz>" and "RATE PWM|TRIG <Hz>" replies, for the .cap header; other lines are left alone
+void ParseSetting(std::string_view line, CaptureHeaderTypeDef& info)
+{
+	const std::string text(line);
+	unsigned long divider, sclk;
+	if(std::sscanf(text.c_str(), "SCLK %lu %lu", &divider, &sclk) == 2) {
+		info.sclk_hz = static_cast<uint32_t>(sclk);
+	}
+	else if(line.starts_with("RATE PWM ") || line.starts_with("RATE TRIG ")) {
+		info.data_rate_mhz = static_cast<uint32_t>(std::atof(text.c_str() + text.rfind(' ') + 1) * 1000.0 + 0.5);
+	}
+}
+
+// Writes a run of adjacent data frames with one system call
+void Flush(BoardTypeDef& board, const uint8_t*& pending, const uint8_t* until)
+{
+	if(pending == nullptr) return;
+	for(const uint8_t* p = pending; p < until;)
+	{
+		const ssize_t w = ::write(board.out_fd, p, static_cast<size_t>(until - p));
+		if(w <= 0) {
+			std::perror(board.path.c_str());
+			break;
+		}
+		p += w;
+	}
+	pending = nullptr;
+}
+
+// -C: the capture file is created on the first data frame, which fixes the channel count
+bool Store(BoardTypeDef& board, const OptionTypeDef& option, std::span<const int32_t> samples, size_t channels)
+{
+	if(!board.capture->IsOpen())
+	{
+		CaptureHeaderTypeDef info = board.info;
+		info.channels = static_cast<uint32_t>(channels);
+		info.vref_uv = option.vref_uv;
+		capture_file::SetText(info.board, board.path);
+		if(!board.capture->Open(board.out_path.c_str(), info)) {
+			std::perror(board.out_path.c_str());
+			return false;
+		}
+	}
+	return board.capture->Append(samples);
+}
+
+void Process(BoardTypeDef& board, const OptionTypeDef& option)
+{
+	std::array<int32_t, rice_constants::kBlockSamples> samples;
+	const uint8_t* pending = nullptr;
+
+	while(board.begin < board.end)
+	{
+		const auto in = std::span<const uint8_t>(board.buffer).subspan(board.begin, board.end - board.begin);
+		const auto frame = board.parser.Next(in);
+		if(frame.kind == FrameKindTypeDef::kNone) break;
+
+		const bool is_data = board.state == StateTypeDef::kCapture && (
+			frame.kind == FrameKindTypeDef::kSampleLine ||
+			frame.kind == FrameKindTypeDef::kRiceHeader ||
+			frame.kind == FrameKindTypeDef::kRiceBlock ||
+			frame.kind == FrameKindTypeDef::kBadChecksum);
+		if(is_data && !option.is_capture) {
+			if(pending == nullptr) pending = frame.bytes.data();
+		}
+		else {
+			Flush(board, pending, frame.bytes.data());
+		}
+
+		switch(frame.kind) {
+		case FrameKindTypeDef::kSampleLine:
+			if(!is_data) break;
+			++board.stat.lines;
+			board.stat.samples += frame.samples;
+			if(board.expected != 0) --board.expected;
+			if(option.is_capture)
+			{
+				const size_t count = RadcStreamParser::Decode(frame, option.format, option.vref_uv, samples);
+				const bool is_valid = count != 0 && (!board.capture->IsOpen() || count == board.capture->GetHeader().channels);
+				if(!is_valid) ++board.stat.bad_lines;
+				else if(!Store(board, option, std::span<const int32_t>(samples).first(count), count)) board.state = StateTypeDef::kFailed;
+			}
+			break;
+		case FrameKindTypeDef::kRiceHeader:
+			board.expected = frame.samples;
+			break;
+		case FrameKindTypeDef::kRiceBlock:
+			++board.stat.blocks;
+			if(const size_t count = RadcStreamParser::Decode(frame, option.format, option.vref_uv, samples); count == 0) {
+				++board.stat.decode_errors;
+			}
+			else if(option.is_capture && !Store(board, option, std::span<const int32_t>(samples).first(count), board.parser.GetChannelCount())) {
+				board.state = StateTypeDef::kFailed;
+			}
+			board.stat.samples += frame.samples;
+			board.expected -= std::min<size_t>(frame.samples, board.expected);
+			break;
+		case FrameKindTypeDef::kBadChecksum:
+			++board.stat.checksum_errors;
+			if(board.state == StateTypeDef::kCapture && frame.samples != 0) {
+				// A damaged block still accounts for its samples
+				board.expected -= std::min<size_t>(frame.samples, board.expected);
+				break;
+			}
+			[[fallthrough]];
+		case FrameKindTypeDef::kReply:
+			if(board.state == StateTypeDef::kInit) {
+				if(frame.kind == FrameKindTypeDef::kReply) {
+					const auto payload = RadcStreamParser::GetPayload(frame);
+					ParseSetting(std::string_view(reinterpret_cast<const char*>(payload.data()), payload.size()), board.info);
+				}
+				++board.stat.replies;
+				++board.init_index;
+				StartNext(board, option);
+			}
+			else if(board.state == StateTypeDef::kStatus) {
+				// Nothing else is due now, so a damaged line here is the STAT line
+				const auto payload = RadcStreamParser::GetPayload(frame);
+				const std::string_view text(reinterpret_cast<const char*>(payload.data()), payload.size());
+				if(frame.kind != FrameKindTypeDef::kReply || !ParseStatistics(text, board.stat)) ++board.stat.lost_status;
+				++board.stat.replies;
+				++board.run;
+				StartNext(board, option);
+			}
+			else if(board.state == StateTypeDef::kCapture) {
+				// The board refused the capture command (too long for its record, say) and would refuse every run
+				const auto payload = RadcStreamParser::GetPayload(frame);
+				const std::string_view text(reinterpret_cast<const char*>(payload.data()), payload.size());
+				if(frame.kind == FrameKindTypeDef::kReply && text.ends_with(" NG")) {
+					++board.stat.rejected;
+					board.state = StateTypeDef::kFailed;
+					break;
+				}
+				// A sample line damaged on the wire; it still ends one data-ready edge
+				if(frame.kind == FrameKindTypeDef::kReply) ++board.stat.bad_lines;
+				if(board.expected != 0 && --board.expected == 0) {
+					board.begin += frame.bytes.size();
+					Flush(board, pending, board.buffer.data() + board.begin);
+					EndCapture(board);
+					continue;
+				}
+			}
+			break;
+		case FrameKindTypeDef::kGarbage:
+			board.stat.garbage_bytes += frame.bytes.size();
+			break;
+		default:
+			break;
+		}
+		board.begin += frame.bytes.size();
+
+		if(is_data && board.expected == 0 && !board.parser.IsBinary())
+		{
+			Flush(board, pending, board.buffer.data() + board.begin);
+			EndCapture(board);
+		}
+	}
+	Flush(board, pending, board.buffer.data() + board.begin);
+	if(option.is_capture && board.capture->IsOpen()) board.capture->Flush();
+
+	// Move the incomplete frame to the front; complete frames were never copied
+	if(board.begin == board.end) {
+		board.begin = board.end = 0;
+	}
+	else if(board.end == board.buffer.size()) {
+		std::memmove(board.buffer.data(), board.buffer.data() + board.begin, board.end - board.begin);
+		board.end -= board.begin;
+		board.begin = 0;
+	}
+}
+
+void Report(const std::vector<BoardTypeDef>& boards, FILE* fp)
+{
+	for(const auto& board : boards)
+	{
+		const double seconds = std::max(std::chrono::duration<double>(board.last_rx - board.start).count(), 1e-9);
+		const char* state =
+			(board.state == StateTypeDef::kDone) ? "done" :
+			(board.state == StateTypeDef::kFailed) ? "failed" : "running";
+		const uint64_t missed = board.stat.busy + board.stat.spi_errors + board.stat.overruns;
+		std::fprintf(fp, "%s: %s, run %zu, %llu samples, %llu bytes, %.1f kB/s, %.0f samples/s, "
+			"%llu lines, %llu blocks, %llu replies, errors: %llu garbage bytes, %llu bad lines, %llu bad blocks, %llu bad checksums, %llu timeouts, %llu rejected; "
+			"firmware: %llu edges, %llu missed (%llu busy, %llu SPI errors, %llu overruns), %llu STAT lost\n",
+			board.path.c_str(), state, board.run,
+			static_cast<unsigned long long>(board.stat.samples), static_cast<unsigned long long>(board.stat.bytes),
+			static_cast<double>(board.stat.bytes) / seconds / 1000.0, static_cast<double>(board.stat.samples) / seconds,
+			static_cast<unsigned long long>(board.stat.lines), static_cast<unsigned long long>(board.stat.blocks),
+			static_cast<unsigned long long>(board.stat.replies), static_cast<unsigned long long>(board.stat.garbage_bytes),
+			static_cast<unsigned long long>(board.stat.bad_lines), static_cast<unsigned long long>(board.stat.decode_errors),
+			static_cast<unsigned long long>(board.stat.checksum_errors), static_cast<unsigned long long>(board.stat.timeouts),
+			static_cast<unsigned long long>(board.stat.rejected),
+			static_cast<unsigned long long>(board.stat.edges), static_cast<unsigned long long>(missed),
+			static_cast<unsigned long long>(board.stat.busy), static_cast<unsigned long long>(board.stat.spi_errors),
+			static_cast<unsigned long long>(board.stat.overruns), static_cast<unsigned long long>(board.stat.lost_status));
+	}
+}
+
+std::string OutputPath(const std::string& directory, const std::string& port, const char* extension)
+{
+	std::string name = port.substr(port.find_last_of('/') + 1);
+	std::replace(name.begin(), name.end(), '.', '_');
+	return directory + "/" + name + extension;
+}
+
+// The FMT the boards were switched to, so -C can read their sample lines
+void ParseFormat(std::string_view line, OptionTypeDef& option)
+{
+	if(!line.starts_with("FMT ")) return;
+	const std::string type(line.substr(4, line.find(' ', 4) - 4));
+	if(type == "BIN")		option.format = FormatTypeDef::kBin;
+	else if(type == "HEX")	option.format = FormatTypeDef::kHex;
+	else if(type == "DEC")	option.format = FormatTypeDef::kDec;
+	else if(type == "VOLT")	option.format = FormatTypeDef::kVolt;
+	if(const size_t space = line.find(' ', 4); space != std::string_view::npos) {
+		option.vref_uv = static_cast<uint32_t>(std::strtoul(std::string(line.substr(space + 1)).c_str(), nullptr, 0));
+	}
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	OptionTypeDef option;
+	std::vector<BoardTypeDef> boards;
+	for(int i = 1; i < argc; ++i)
+	{
+		const std::string_view arg = argv[i];
+		const bool has_value = i + 1 < argc;
+		if(arg == "-c" && has_value)		option.command = argv[++i];
+		else if(arg == "-i" && has_value) {
+			option.init.emplace_back(argv[++i]);
+			ParseFormat(option.init.back(), option);
+		}
+		else if(arg == "-r" && has_value)	option.runs = static_cast<size_t>(std::atol(argv[++i]));
+		else if(arg == "-o" && has_value)	option.directory = argv[++i];
+		else if(arg == "-b" && has_value)	option.baud = serial::ToSpeed(std::atol(argv[++i]));
+		else if(arg == "-t" && has_value)	option.timeout = std::atof(argv[++i]);
+		else if(arg == "-C")				option.is_capture = true;
+		else if(arg == "-p" && has_value)	capture_file::SetText(option.info.profile_name, argv[++i]);
+		else if(arg == "-R" && has_value) {
+			char* p = argv[++i];
+			for(auto& value : option.info.profile_value) {
+				value = static_cast<uint32_t>(std::strtoul(p, &p, 0));
+				if(*p == ',') ++p;
+			}
+		}
+		else if(arg == "-s" && has_value)	option.info.sclk_hz = static_cast<uint32_t>(std::atol(argv[++i]));
+		else if(arg == "-d" && has_value)	option.info.data_rate_mhz = static_cast<uint32_t>(std::atof(argv[++i]) * 1000.0);
+		else if(arg == "-v")				option.is_verbose = true;
+		else if(!arg.starts_with("-"))		boards.emplace_back().path = argv[i];
+		else {
+			std::fprintf(stderr, "usage: radc_aggregate [-c command] [-i line]... [-r runs] [-o dir] [-b baud] [-t seconds] [-C] "
+				"[-p name] [-R r0,r1,r2] [-s sclk_hz] [-d rate_hz] [-v] port...\n");
+			return 2;
+		}
+	}
+	if(boards.empty()) {
+		std::fprintf(stderr, "radc_aggregate: no ports\n");
+		return 2;
+	}
+
+	const int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if(epoll_fd < 0) {
+		std::perror("epoll_create1");
+		return 1;
+	}
+	for(auto& board : boards)
+	{
+		board.fd = serial::Open(board.path.c_str(), option.baud);
+		if(board.fd < 0) {
+			std::perror(board.path.c_str());
+			return 1;
+		}
+		board.out_path = OutputPath(option.directory, board.path, option.is_capture ? ".cap" : ".radc");
+		if(option.is_capture) {
+			board.capture = std::make_unique<CaptureWriter>();
+			board.info = option.info;
+		}
+		else {
+			board.out_fd = ::open(board.out_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+			if(board.out_fd < 0) {
+				std::perror(board.out_path.c_str());
+				return 1;
+			}
+		}
+		tcflush(board.fd, TCIOFLUSH);
+
+		epoll_event event = {};
+		event.events = EPOLLIN;
+		event.data.ptr = &board;
+		epoll_ctl(epoll_fd, EPOLL_CTL_ADD, board.fd, &event);
+
+		board.start = board.last_rx = Clock::now();
+		StartNext(board, option);
+	}
+
+	auto report = Clock::now();
+	std::array<epoll_event, 32> events;
+	const auto is_active = [](const BoardTypeDef& b) {
+		return b.state == StateTypeDef::kInit || b.state == StateTypeDef::kCapture || b.state == StateTypeDef::kStatus;
+	};
+	while(std::any_of(boards.begin(), boards.end(), is_active))
+	{
+		const int n = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), 100);
+		if(n < 0 && errno != EINTR) {
+			std::perror("epoll_wait");
+			return 1;
+		}
+
+		for(int e = 0; e < n; ++e)
+		{
+			auto& board = *static_cast<BoardTypeDef*>(events[e].data.ptr);
+			if(events[e].events & (EPOLLERR | EPOLLHUP)) {
+				board.state = StateTypeDef::kFailed;
+				epoll_ctl(epoll_fd, EPOLL_CTL_DEL, board.fd, nullptr);
+				continue;
+			}
+			// Drain the port; each read lands directly behind the unparsed bytes
+			while(board.end < board.buffer.size())
+			{
+				const ssize_t r = ::read(board.fd, board.buffer.data() + board.end, board.buffer.size() - board.end);
+				if(r <= 0) break;
+				board.end += static_cast<size_t>(r);
+				board.stat.bytes += static_cast<uint64_t>(r);
+				board.last_rx = Clock::now();
+				if(board.end == board.buffer.size()) Process(board, option);
+			}
+			Process(board, option);
+		}
+
+		const auto now = Clock::now();
+		for(auto& board : boards)
+		{
+			if(!is_active(board)) continue;
+			if(std::chrono::duration<double>(now - board.last_rx).count() <= option.timeout) continue;
+			++board.stat.timeouts;
+			const bool is_answered = board.state == StateTypeDef::kStatus ||
+				(board.state == StateTypeDef::kCapture && board.stat.bytes != board.run_bytes);
+			if(is_answered) {
+				if(board.state == StateTypeDef::kStatus) ++board.stat.lost_status;
+				// The board answered but the count never closed; drop the tail and carry on
+				board.stat.garbage_bytes += board.end - board.begin;
+				board.begin = board.end = 0;
+				++board.run;
+				StartNext(board, option);
+				continue;
+			}
+			board.state = StateTypeDef::kFailed;
+		}
+		if(option.is_verbose && now - report >= std::chrono::seconds(1)) {
+			Report(boards, stderr);
+			report = now;
+		}
+	}
+
+	Report(boards, stderr);
+	bool is_ok = true;
+	for(const auto& board : boards)
+	{
+		::close(board.fd);
+		if(board.out_fd >= 0) ::close(board.out_fd);
+		if(board.capture && !board.capture->Close()) {
+			std::perror(board.out_path.c_str());
+			is_ok = false;
+		}
+		is_ok = is_ok && board.state == StateTypeDef::kDone && board.stat.timeouts == 0 &&
+			board.stat.garbage_bytes == 0 && board.stat.bad_lines == 0 && board.stat.decode_errors == 0 && board.stat.checksum_errors == 0 &&
+			board.stat.busy == 0 && board.stat.spi_errors == 0 && board.stat.overruns == 0 && board.stat.lost_status == 0;
+	}
+	return is_ok ? 0 : 1;
+}
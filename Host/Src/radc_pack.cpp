@@ -0,0 +1,173 @@
+/*
+ * radc_pack.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Converts a RADC dump (sample lines in any FMT, or CMP blocks) into a capture file
+ * (capture_file.hpp). Input is consumed as it arrives, so a live stream can be piped in;
+ * every chunk read is flushed, so a crash keeps everything up to the last complete frame.
+ *   radc_pack [-F bin|hex|dec|volt] [-V vref_uv] [-b board] [-p name] [-R r0,r1,r2]
+ *             [-s sclk_hz] [-d rate_hz] [-a] [-S] [-K] out.cap [in]
+ *     -F    FMT the sample lines were printed in, default bin
+ *     -K    the dump was taken with CRC ON; frames failing their checksum count as errors
+ *     -a    append to an existing capture instead of replacing it
+ *     -S    wait for the disk after every flush
+ */
+#include <capture_file.hpp>
+#include <radc_stream.hpp>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+bool ToFormat(std::string_view s, FormatTypeDef& format)
+{
+	if(s == "bin")			format = FormatTypeDef::kBin;
+	else if(s == "hex")		format = FormatTypeDef::kHex;
+	else if(s == "dec")		format = FormatTypeDef::kDec;
+	else if(s == "volt")	format = FormatTypeDef::kVolt;
+	else return false;
+	return true;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	FormatTypeDef format = FormatTypeDef::kBin;
+	CaptureHeaderTypeDef info = {};
+	info.vref_uv = 2'500'000;
+	bool is_append = false;
+	bool is_durable = false;
+	bool is_checksum = false;
+	const char* out_path = nullptr;
+	const char* in_path = nullptr;
+	bool is_usage = false;
+	for(int i = 1; i < argc && !is_usage; ++i)
+	{
+		const std::string_view arg = argv[i];
+		const bool has_value = i + 1 < argc;
+		if(arg == "-F" && has_value)		is_usage = !ToFormat(argv[++i], format);
+		else if(arg == "-V" && has_value)	info.vref_uv = static_cast<uint32_t>(std::atol(argv[++i]));
+		else if(arg == "-b" && has_value)	capture_file::SetText(info.board, argv[++i]);
+		else if(arg == "-p" && has_value)	capture_file::SetText(info.profile_name, argv[++i]);
+		else if(arg == "-R" && has_value) {
+			char* p = argv[++i];
+			for(auto& value : info.profile_value) {
+				value = static_cast<uint32_t>(std::strtoul(p, &p, 0));
+				if(*p == ',') ++p;
+			}
+		}
+		else if(arg == "-s" && has_value)	info.sclk_hz = static_cast<uint32_t>(std::atol(argv[++i]));
+		else if(arg == "-d" && has_value)	info.data_rate_mhz = static_cast<uint32_t>(std::atof(argv[++i]) * 1000.0);
+		else if(arg == "-a")				is_append = true;
+		else if(arg == "-S")				is_durable = true;
+		else if(arg == "-K")				is_checksum = true;
+		else if(!arg.starts_with("-") && out_path == nullptr)	out_path = argv[i];
+		else if(!arg.starts_with("-") && in_path == nullptr)	in_path = argv[i];
+		else is_usage = true;
+	}
+	if(is_usage || out_path == nullptr) {
+		std::fprintf(stderr, "usage: radc_pack [-F bin|hex|dec|volt] [-V vref_uv] [-b board] [-p name] [-R r0,r1,r2] "
+			"[-s sclk_hz] [-d rate_hz] [-a] [-S] [-K] out.cap [in]\n");
+		return 2;
+	}
+
+	FILE* fp = (in_path == nullptr) ? stdin : std::fopen(in_path, "rb");
+	if(fp == nullptr) {
+		std::perror(in_path);
+		return 1;
+	}
+
+	// The channel count is only known from the first sample line or RICE header
+	CaptureWriter writer;
+	if(is_append && !writer.OpenAppend(out_path)) {
+		std::fprintf(stderr, "radc_pack: %s is not a capture\n", out_path);
+		return 1;
+	}
+	const auto open = [&](size_t channels) {
+		if(writer.IsOpen()) return true;
+		info.channels = static_cast<uint32_t>(channels);
+		if(!writer.Open(out_path, info)) {
+			std::perror(out_path);
+			return false;
+		}
+		return true;
+	};
+
+	RadcStreamParser parser;
+	parser.SetChecksum(is_checksum);
+	std::vector<uint8_t> buffer(1 << 16);
+	std::array<int32_t, rice_constants::kBlockSamples> samples;
+	size_t begin = 0, end = 0;
+	size_t frames_in = 0, errors = 0, skipped = 0;
+	for(;;)
+	{
+		if(begin != 0) {
+			std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+			end -= begin;
+			begin = 0;
+		}
+		// read() rather than fread() so a pipe is processed as soon as something arrives
+		const ssize_t r = ::read(fileno(fp), buffer.data() + end, buffer.size() - end);
+		if(r < 0 && errno == EINTR) continue;
+		const size_t n = (r > 0) ? static_cast<size_t>(r) : 0;
+		end += n;
+
+		while(begin < end)
+		{
+			const auto frame = parser.Next(std::span<const uint8_t>(buffer).subspan(begin, end - begin));
+			if(frame.kind == FrameKindTypeDef::kNone) break;
+			begin += frame.bytes.size();
+
+			if(frame.kind == FrameKindTypeDef::kGarbage) {
+				skipped += frame.bytes.size();
+				continue;
+			}
+			if(frame.kind == FrameKindTypeDef::kBadChecksum) {
+				++errors;
+				continue;
+			}
+			if(frame.kind != FrameKindTypeDef::kSampleLine && frame.kind != FrameKindTypeDef::kRiceBlock) continue;
+
+			const size_t count = RadcStreamParser::Decode(frame, format, info.vref_uv, samples);
+			if(count == 0) {
+				++errors;
+				continue;
+			}
+			const size_t channels = (frame.kind == FrameKindTypeDef::kSampleLine) ? count : parser.GetChannelCount();
+			if(!open(channels)) return 1;
+			if(frame.kind == FrameKindTypeDef::kSampleLine && count != writer.GetHeader().channels) {
+				++errors;
+				continue;
+			}
+			if(!writer.Append(std::span<const int32_t>(samples).first(count))) {
+				std::perror(out_path);
+				return 1;
+			}
+			++frames_in;
+		}
+		if(writer.IsOpen() && !writer.Flush(is_durable)) {
+			std::perror(out_path);
+			return 1;
+		}
+		if(n == 0) break;
+	}
+	if(fp != stdin) std::fclose(fp);
+
+	if(!writer.IsOpen() && !open(1)) return 1;
+	const uint64_t frames = writer.GetFrameCount();
+	const size_t channels = writer.GetHeader().channels;
+	if(!writer.Close()) {
+		std::perror(out_path);
+		return 1;
+	}
+	std::fprintf(stderr, "radc_pack: %zu lines/blocks, %llu frames x %zu channels, %zu errors, %zu bytes skipped\n",
+		frames_in, static_cast<unsigned long long>(frames), channels, errors, skipped);
+	return (errors == 0 && skipped == 0) ? 0 : 1;
+}
@@ -0,0 +1,273 @@
+/*
+ * radc_replay.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Replays a capture file (capture_file.hpp) through the firmware's sample processing
+ * (sample_pipeline.hpp, built unchanged) as fast as the host allows. Every scan is turned back
+ * into the SPI bytes the ADCs sent, decoded as in the data-ready interrupt, collected into
+ * records as RADC does and written out as RADC would (FMT text or CMP blocks).
+ *   radc_replay [-F bin|hex|dec|volt] [-V vref_uv] [-c order] [-l frames] [-n repeat]
+ *               [-o out] [-g golden] [-m samples_per_second] file.cap
+ *     -c    CMP order (RICE output), default text
+ *     -l    frames per RADC record, default as many as the firmware's record holds
+ *     -n    replay this many times and report the fastest run, default 5
+ *     -o    write the output of the first run to `out`
+ *     -g    compare the output with `golden` (a previous -o) and report the first difference
+ *     -m    fail if fewer samples per second are processed
+ */
+#include <capture_file.hpp>
+#include <sample_pipeline.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kRecordSize = 4096;		// app_constants::kMax
+constexpr size_t kTxBufferSize = 320;		// uart_constants::kTxBufferSize
+
+// Stands in for UARTDriver; collects everything the firmware would transmit
+class ReplayOutput {
+private:
+	static inline std::array<char, kTxBufferSize> tx_buffer_;
+	static inline std::string out_;
+
+public:
+	ReplayOutput() = delete;
+
+	static std::span<char> GetTxBuffer() { return std::span<char>(tx_buffer_).first(tx_buffer_.size() - 2); }
+	static void WriteTxBuffer(size_t n)
+	{
+		if(n > GetTxBuffer().size()) return;
+		out_.append(tx_buffer_.data(), n);
+		out_.append("\r\n");
+	}
+	static void WriteLine(std::string_view s)
+	{
+		out_.append(s);
+		out_.append("\r\n");
+	}
+	static void Write(std::span<const uint8_t> s) { out_.append(reinterpret_cast<const char*>(s.data()), s.size()); }
+
+	static std::string& Get() { return out_; }
+};
+
+struct OptionTypeDef {
+	FormatTypeDef format{FormatTypeDef::kBin};
+	uint32_t vref_uv{adc_constants::kVref_uV};
+	bool is_compressed{false};
+	uint8_t order{1};
+	size_t record_frames{0};
+	size_t repeat{5};
+	const char* out_path{nullptr};
+	const char* golden_path{nullptr};
+	double min_rate{0.0};
+};
+
+bool ToFormat(std::string_view s, FormatTypeDef& format)
+{
+	if(s == "bin")			format = FormatTypeDef::kBin;
+	else if(s == "hex")		format = FormatTypeDef::kHex;
+	else if(s == "dec")		format = FormatTypeDef::kDec;
+	else if(s == "volt")	format = FormatTypeDef::kVolt;
+	else return false;
+	return true;
+}
+
+// The SPI receive stream of the whole capture: one frame per sample in the layout of AdcProfile, scans back to back
+std::vector<uint8_t> ToSpiBytes(const CaptureReader& reader)
+{
+	const size_t channels = reader.GetChannelCount();
+	const uint64_t frames = reader.GetFrameCount();
+	std::vector<uint8_t> bytes(frames * channels * adc_constants::kBufferSize);
+	std::vector<int32_t> samples(capture_constants::kBlockFrames * channels);
+	uint8_t* out = bytes.data();
+	for(uint64_t first = 0; first < frames;)
+	{
+		const size_t n = reader.Read(first, samples);
+		for(const auto sample : std::span<const int32_t>(samples).first(n * channels))
+		{
+			AdcProfile::Encode(static_cast<uint32_t>(sample), out);
+			out += adc_constants::kBufferSize;
+		}
+		first += n;
+	}
+	return bytes;
+}
+
+struct TimingTypeDef {
+	double decode;
+	double output;
+};
+
+// One pass over the capture, RADC record by RADC record
+TimingTypeDef Replay(std::span<const uint8_t> spi, size_t channels, const OptionTypeDef& option)
+{
+	static SPSCQueue<uint32_t, kRecordSize> record;
+	static std::array<uint32_t, rice_constants::kBlockSamples> block;
+	static std::array<uint8_t, rice_constants::kMaxBlockSize> encoded;
+
+	const size_t scan_size = channels * adc_constants::kBufferSize;
+	const size_t record_size = option.record_frames * scan_size;
+	Clock::duration decode{}, output{};
+	for(size_t offset = 0; offset < spi.size(); offset += record_size)
+	{
+		const auto chunk = spi.subspan(offset, std::min(record_size, spi.size() - offset));
+		const size_t count = chunk.size() / adc_constants::kBufferSize;
+		record.Clear();
+
+		const auto t0 = Clock::now();
+		for(size_t i = 0; i < chunk.size(); i += scan_size) {
+			SamplePipeline::DecodeScan(chunk.subspan(i, scan_size), record);
+		}
+		const auto t1 = Clock::now();
+		if(option.is_compressed) {
+			SamplePipeline::WriteRecordCompressed<ReplayOutput>(record, count, channels, option.order, block, encoded);
+		}
+		else {
+			SamplePipeline::WriteRecord<ReplayOutput>(record, count, channels, option.format, option.vref_uv);
+		}
+		const auto t2 = Clock::now();
+		decode += t1 - t0;
+		output += t2 - t1;
+	}
+	return {std::chrono::duration<double>(decode).count(), std::chrono::duration<double>(output).count()};
+}
+
+std::string ReadFile(const char* path)
+{
+	std::string data;
+	FILE* fp = std::fopen(path, "rb");
+	if(fp == nullptr) return data;
+	std::array<char, 1 << 16> chunk;
+	size_t n;
+	while((n = std::fread(chunk.data(), 1, chunk.size(), fp)) > 0) data.append(chunk.data(), n);
+	std::fclose(fp);
+	return data;
+}
+
+// Prints the first difference; returns true if both are equal
+bool Compare(std::string_view out, std::string_view golden)
+{
+	const auto mismatch = std::mismatch(out.begin(), out.end(), golden.begin(), golden.end());
+	if(mismatch.first == out.end() && mismatch.second == golden.end()) return true;
+
+	const auto offset = static_cast<size_t>(mismatch.first - out.begin());
+	const size_t line = static_cast<size_t>(std::count(out.begin(), mismatch.first, '\n')) + 1;
+	const size_t begin = out.rfind('\n', offset == 0 ? 0 : offset - 1);
+	const auto excerpt = [&](std::string_view s) {
+		const size_t from = (begin == std::string_view::npos) ? 0 : begin + 1;
+		if(from >= s.size()) return std::string_view("<end>");
+		return s.substr(from, std::min<size_t>(s.find('\n', from), from + 80) - from);
+	};
+	std::fprintf(stderr, "radc_replay: output differs from golden at byte %zu (line %zu), %zu vs %zu bytes\n",
+		offset, line, out.size(), golden.size());
+	std::fprintf(stderr, "  got:    %.*s\n", static_cast<int>(excerpt(out).size()), excerpt(out).data());
+	std::fprintf(stderr, "  golden: %.*s\n", static_cast<int>(excerpt(golden).size()), excerpt(golden).data());
+	return false;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	OptionTypeDef option;
+	const char* path = nullptr;
+	bool is_usage = false;
+	for(int i = 1; i < argc && !is_usage; ++i)
+	{
+		const std::string_view arg = argv[i];
+		const bool has_value = i + 1 < argc;
+		if(arg == "-F" && has_value)		is_usage = !ToFormat(argv[++i], option.format);
+		else if(arg == "-V" && has_value)	option.vref_uv = static_cast<uint32_t>(std::atol(argv[++i]));
+		else if(arg == "-c" && has_value) {
+			const long order = std::atol(argv[++i]);
+			is_usage = order < 0 || order > rice_constants::kMaxOrder;
+			option.order = static_cast<uint8_t>(order);
+			option.is_compressed = true;
+		}
+		else if(arg == "-l" && has_value)	option.record_frames = static_cast<size_t>(std::atol(argv[++i]));
+		else if(arg == "-n" && has_value)	option.repeat = std::max<size_t>(static_cast<size_t>(std::atol(argv[++i])), 1);
+		else if(arg == "-o" && has_value)	option.out_path = argv[++i];
+		else if(arg == "-g" && has_value)	option.golden_path = argv[++i];
+		else if(arg == "-m" && has_value)	option.min_rate = std::atof(argv[++i]);
+		else if(!arg.starts_with("-") && path == nullptr)	path = argv[i];
+		else is_usage = true;
+	}
+	if(is_usage || path == nullptr) {
+		std::fprintf(stderr, "usage: radc_replay [-F bin|hex|dec|volt] [-V vref_uv] [-c order] [-l frames] [-n repeat] "
+			"[-o out] [-g golden] [-m samples_per_second] file.cap\n");
+		return 2;
+	}
+
+	CaptureReader reader;
+	if(!reader.Open(path)) {
+		std::fprintf(stderr, "radc_replay: %s is not a capture\n", path);
+		return 1;
+	}
+	const size_t channels = reader.GetChannelCount();
+	const size_t max_frames = kRecordSize / channels;
+	if(option.record_frames == 0 || option.record_frames > max_frames) option.record_frames = max_frames;
+
+	const auto spi = ToSpiBytes(reader);
+	const uint64_t samples = spi.size() / adc_constants::kBufferSize;
+	if(samples == 0) {
+		std::fprintf(stderr, "radc_replay: %s has no samples\n", path);
+		return 1;
+	}
+
+	// The first run produces the output; later ones only time the same work again
+	std::string output;
+	TimingTypeDef best = {1e30, 1e30};
+	double best_total = 1e30;
+	for(size_t n = 0; n < option.repeat; ++n)
+	{
+		ReplayOutput::Get().clear();
+		ReplayOutput::Get().reserve(output.size());
+		const auto timing = Replay(spi, channels, option);
+		if(n == 0) output.swap(ReplayOutput::Get());
+		if(timing.decode + timing.output < best_total) {
+			best = timing;
+			best_total = timing.decode + timing.output;
+		}
+	}
+
+	const double rate = static_cast<double>(samples) / best_total;
+	std::printf("replay: %llu samples (%zu channels), %zu output bytes, best of %zu\n",
+		static_cast<unsigned long long>(samples), channels, output.size(), option.repeat);
+	std::printf("decode: %.3f ms, %.1f Msamples/s, %.1f ns/scan\n",
+		best.decode * 1e3, static_cast<double>(samples) / best.decode / 1e6, best.decode * 1e9 / static_cast<double>(samples / channels));
+	std::printf("output: %.3f ms, %.1f Msamples/s, %.1f ns/sample\n",
+		best.output * 1e3, static_cast<double>(samples) / best.output / 1e6, best.output * 1e9 / static_cast<double>(samples));
+	std::printf("total:  %.1f samples/s\n", rate);
+
+	bool is_ok = true;
+	if(option.out_path != nullptr)
+	{
+		FILE* fp = std::fopen(option.out_path, "wb");
+		if(fp == nullptr || std::fwrite(output.data(), 1, output.size(), fp) != output.size()) {
+			std::perror(option.out_path);
+			is_ok = false;
+		}
+		if(fp != nullptr) std::fclose(fp);
+	}
+	if(option.golden_path != nullptr)
+	{
+		const bool is_same = Compare(output, ReadFile(option.golden_path));
+		std::printf("golden: %s\n", is_same ? "same" : "DIFFERENT");
+		is_ok = is_ok && is_same;
+	}
+	if(option.min_rate > 0.0 && rate < option.min_rate) {
+		std::printf("rate:   below %.1f samples/s\n", option.min_rate);
+		is_ok = false;
+	}
+	return is_ok ? 0 : 1;
+}
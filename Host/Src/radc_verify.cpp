@@ -0,0 +1,104 @@
+/*
+ * radc_verify.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Checks a dump taken with "CRC ON": every line must end in a matching "*XXXXXXXX" and every
+ * RICE block must be followed by its CRC-32. Reports good and damaged frames by kind.
+ *   radc_verify [-s] [in]
+ *     -s    write the dump to stdout without the checksums (as if taken with CRC OFF),
+ *           dropping the damaged frames, so radc_pack and rice_decode can read it
+ */
+#include <radc_stream.hpp>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+void Write(std::span<const uint8_t> bytes)
+{
+	std::fwrite(bytes.data(), 1, bytes.size(), stdout);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	bool is_strip = false;
+	const char* in_path = nullptr;
+	for(int i = 1; i < argc; ++i)
+	{
+		const std::string_view arg = argv[i];
+		if(arg == "-s")	is_strip = true;
+		else if(!arg.starts_with("-") && in_path == nullptr)	in_path = argv[i];
+		else {
+			std::fprintf(stderr, "usage: radc_verify [-s] [in]\n");
+			return 2;
+		}
+	}
+
+	FILE* fp = (in_path == nullptr) ? stdin : std::fopen(in_path, "rb");
+	if(fp == nullptr) {
+		std::perror(in_path);
+		return 1;
+	}
+
+	RadcStreamParser parser;
+	parser.SetChecksum(true);
+	std::vector<uint8_t> buffer(1 << 16);
+	size_t begin = 0, end = 0;
+	size_t lines = 0, blocks = 0, bad_lines = 0, bad_blocks = 0, skipped = 0;
+	static constexpr uint8_t kLineEnd[] = {'\r', '\n'};
+	for(;;)
+	{
+		if(begin != 0) {
+			std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+			end -= begin;
+			begin = 0;
+		}
+		const ssize_t r = ::read(fileno(fp), buffer.data() + end, buffer.size() - end);
+		if(r < 0 && errno == EINTR) continue;
+		const size_t n = (r > 0) ? static_cast<size_t>(r) : 0;
+		end += n;
+
+		while(begin < end)
+		{
+			const auto frame = parser.Next(std::span<const uint8_t>(buffer).subspan(begin, end - begin));
+			if(frame.kind == FrameKindTypeDef::kNone) break;
+			begin += frame.bytes.size();
+
+			switch(frame.kind) {
+			case FrameKindTypeDef::kGarbage:
+				skipped += frame.bytes.size();
+				break;
+			case FrameKindTypeDef::kBadChecksum:
+				++((frame.samples != 0) ? bad_blocks : bad_lines);
+				break;
+			case FrameKindTypeDef::kRiceBlock:
+				++blocks;
+				if(is_strip) Write(RadcStreamParser::GetPayload(frame));
+				break;
+			default:
+				++lines;
+				if(is_strip) {
+					Write(RadcStreamParser::GetPayload(frame));
+					Write(kLineEnd);
+				}
+				break;
+			}
+		}
+		if(n == 0) break;
+	}
+	if(fp != stdin) std::fclose(fp);
+	std::fflush(stdout);
+
+	// Whatever is left never completed a frame
+	skipped += end - begin;
+	std::fprintf(stderr, "radc_verify: %zu lines, %zu blocks good; %zu lines, %zu blocks damaged; %zu bytes skipped\n",
+		lines, blocks, bad_lines, bad_blocks, skipped);
+	return (bad_lines == 0 && bad_blocks == 0 && skipped == 0) ? 0 : 1;
+}
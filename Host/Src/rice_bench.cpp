@@ -0,0 +1,103 @@
+/*
+ * rice_bench.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Throughput and compression ratio of RiceCodec on synthetic 24-bit captures.
+ *   rice_bench [samples]
+ */
+#include <rice_codec.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct SignalTypeDef {
+	const char* name;
+	std::vector<uint32_t> samples;
+};
+
+uint32_t ToCode(double value)
+{
+	const auto code = static_cast<int32_t>(std::lround(std::clamp(value, -8'388'608.0, 8'388'607.0)));
+	return static_cast<uint32_t>(code);
+}
+
+std::vector<SignalTypeDef> MakeSignals(size_t n)
+{
+	std::mt19937 rng(12345);
+	std::normal_distribution<double> noise(0.0, 2.0);
+	std::uniform_int_distribution<uint32_t> full(0, 0xFF'FFFF);
+
+	std::vector<SignalTypeDef> signals = {
+		{"noise (2 LSB rms)", {}}, {"sine 10 Hz @ 1 kSPS + noise", {}}, {"ramp", {}}, {"full-scale random", {}}
+	};
+	for(size_t i = 0; i < n; ++i)
+	{
+		signals[0].samples.push_back(ToCode(1000.0 + noise(rng)));
+		signals[1].samples.push_back(ToCode(4'000'000.0 * std::sin(2.0 * M_PI * 10.0 * static_cast<double>(i) / 1000.0) + noise(rng)));
+		signals[2].samples.push_back(ToCode(static_cast<double>(i % 16'777'216) - 8'388'608.0));
+		signals[3].samples.push_back(static_cast<uint32_t>((static_cast<int32_t>(full(rng) << 8)) >> 8));
+	}
+	return signals;
+}
+
+double Seconds(std::chrono::steady_clock::time_point begin)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const size_t n = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 4'000'000;
+	const auto signals = MakeSignals(n);
+
+	std::vector<uint8_t> stream(((n + rice_constants::kBlockSamples - 1) / rice_constants::kBlockSamples) * rice_constants::kMaxBlockSize);
+	std::vector<uint32_t> decoded(n);
+
+	std::printf("%-28s %5s %8s %8s %12s %12s\n", "signal", "order", "bits/smp", "vs 24b", "enc Msmp/s", "dec Msmp/s");
+	for(const auto& signal : signals)
+	{
+		for(uint8_t order = 0; order <= rice_constants::kMaxOrder; ++order)
+		{
+			auto begin = std::chrono::steady_clock::now();
+			size_t bytes = 0;
+			for(size_t i = 0; i < n; i += rice_constants::kBlockSamples)
+			{
+				const size_t count = std::min(rice_constants::kBlockSamples, n - i);
+				bytes += RiceCodec::Encode(std::span<const uint32_t>(signal.samples).subspan(i, count), order,
+					std::span<uint8_t>(stream).subspan(bytes));
+			}
+			const double encode = Seconds(begin);
+
+			begin = std::chrono::steady_clock::now();
+			size_t offset = 0, samples = 0;
+			while(offset < bytes)
+			{
+				const auto result = RiceCodec::Decode(std::span<const uint8_t>(stream).subspan(offset, bytes - offset),
+					std::span<uint32_t>(decoded).subspan(samples));
+				if(result.samples == 0) break;
+				offset += result.bytes;
+				samples += result.samples;
+			}
+			const double decode = Seconds(begin);
+
+			if(samples != n || decoded != signal.samples) {
+				std::fprintf(stderr, "rice_bench: round trip failed (%s, order %u)\n", signal.name, order);
+				return 1;
+			}
+
+			const double bits = 8.0 * static_cast<double>(bytes) / static_cast<double>(n);
+			std::printf("%-28s %5u %8.2f %7.2fx %12.1f %12.1f\n", signal.name, order, bits, 24.0 / bits,
+				static_cast<double>(n) / encode / 1e6, static_cast<double>(n) / decode / 1e6);
+		}
+	}
+	return 0;
+}
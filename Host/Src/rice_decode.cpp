@@ -0,0 +1,132 @@
+/*
+ * rice_decode.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Decodes a compressed RADC dump (CMP 0|1|2) back to one line per data-ready edge,
+ * channels of a scan separated by a space.
+ *   rice_decode [-x] [-b bits] [file]
+ *     -x    print two's complement hex instead of signed decimal
+ *     -b    resolution of the hex output (default: AdcProfile of this build)
+ */
+#include <rice_codec.hpp>
+#include <constants.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <string_view>
+
+namespace {
+
+std::vector<uint8_t> ReadAll(FILE* fp)
+{
+	std::vector<uint8_t> data;
+	std::array<uint8_t, 4096> chunk;
+	size_t n;
+	while((n = std::fread(chunk.data(), 1, chunk.size(), fp)) > 0) {
+		data.insert(data.end(), chunk.begin(), chunk.begin() + n);
+	}
+	return data;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	bool is_hex = false;
+	long bits = static_cast<long>(adc_constants::kResolution);
+	const char* path = nullptr;
+	for(int i = 1; i < argc; ++i) {
+		if(std::strcmp(argv[i], "-x") == 0) is_hex = true;
+		else if(std::strcmp(argv[i], "-b") == 0 && i + 1 < argc) bits = std::strtol(argv[++i], nullptr, 10);
+		else path = argv[i];
+	}
+	if(bits < 1 || bits > 32) {
+		std::fprintf(stderr, "rice_decode: -b must be 1 to 32\n");
+		return 1;
+	}
+	const int digits = static_cast<int>((bits + 3) / 4);
+	const uint32_t mask = (bits == 32) ? 0xFFFF'FFFF : (uint32_t{1} << bits) - 1;
+
+	FILE* fp = (path == nullptr) ? stdin : std::fopen(path, "rb");
+	if(fp == nullptr) {
+		std::perror(path);
+		return 1;
+	}
+	const auto data = ReadAll(fp);
+	if(fp != stdin) std::fclose(fp);
+
+	std::span<const uint8_t> in(data);
+
+	// Optional "RADC RICE <samples> <channels>" line in front of the blocks. Dumps of
+	// several captures (radc_aggregate -r) repeat it; the announced counts add up.
+	long expected = -1;
+	long channels = 1;
+	constexpr std::string_view kPrefix = "RADC RICE ";
+	const auto is_header = [&]() {
+		return in.size() >= kPrefix.size() && std::memcmp(in.data(), kPrefix.data(), kPrefix.size()) == 0;
+	};
+	const auto parse_header = [&]() {
+		if(!is_header()) return false;
+		const auto* lf = static_cast<const uint8_t*>(std::memchr(in.data(), '\n', in.size()));
+		if(lf == nullptr) return false;
+		char* end = nullptr;
+		expected = std::max(expected, 0L) + std::strtol(reinterpret_cast<const char*>(in.data()) + kPrefix.size(), &end, 10);
+		channels = std::max(std::strtol(end, nullptr, 10), 1L);
+		in = in.subspan(static_cast<size_t>(lf - in.data()) + 1);
+		return true;
+	};
+	// The STAT line after each capture (raw serial dumps) carries no samples
+	constexpr std::string_view kStatus = "STAT ";
+	const auto is_status = [&]() {
+		return in.size() >= kStatus.size() && std::memcmp(in.data(), kStatus.data(), kStatus.size()) == 0;
+	};
+	const auto skip_status = [&]() {
+		if(!is_status()) return false;
+		const auto* lf = static_cast<const uint8_t*>(std::memchr(in.data(), '\n', in.size()));
+		in = (lf == nullptr) ? std::span<const uint8_t>() : in.subspan(static_cast<size_t>(lf - in.data()) + 1);
+		return true;
+	};
+	if(is_header() && !parse_header()) {
+		std::fprintf(stderr, "rice_decode: truncated header line\n");
+		return 1;
+	}
+
+	std::array<uint32_t, rice_constants::kBlockSamples> block;
+	size_t blocks = 0, samples = 0, errors = 0, skipped = 0;
+	while(!in.empty())
+	{
+		if(parse_header() || skip_status()) continue;
+		const auto result = RiceCodec::Decode(in, block);
+		if(result.samples == 0)
+		{
+			// Resynchronise on the next byte that starts a valid header
+			++errors;
+			RiceCodec::HeaderTypeDef header;
+			do {
+				in = in.subspan(1);
+				++skipped;
+			} while(!in.empty() && !RiceCodec::ParseHeader(in, header) && !is_header() && !is_status());
+			continue;
+		}
+
+		for(size_t i = 0; i < result.samples; ++i)
+		{
+			if(is_hex) std::printf("%0*X", digits, block[i] & mask);
+			else std::printf("%d", static_cast<int32_t>(block[i]));
+			std::putchar(((samples + i + 1) % static_cast<size_t>(channels) == 0) ? '\n' : ' ');
+		}
+		in = in.subspan(result.bytes);
+		samples += result.samples;
+		++blocks;
+	}
+
+	std::fprintf(stderr, "rice_decode: %zu blocks, %zu samples, %zu errors, %zu bytes skipped\n", blocks, samples, errors, skipped);
+	if(expected >= 0 && static_cast<size_t>(expected) != samples) {
+		std::fprintf(stderr, "rice_decode: expected %ld samples\n", expected);
+		return 1;
+	}
+	return errors == 0 ? 0 : 1;
+}